@@ -0,0 +1,189 @@
+/*
+  Cycle-cost benchmark suite - see audio_bench.h
+*/
+
+#include "audio_bench.h"
+
+#include <Mozzi.h>
+#include <stdio.h>
+
+#include "cycle_counter.h"
+#include "sample_engine.h"
+
+// Synthetic voice used by the kernels, cycling through the real drum samples
+struct BenchVoice {
+  const int8_t* data;
+  uint32_t length;
+  uint32_t position;  // Integer position for fetch/decode/mix
+  uint32_t phase;     // Q16.16 position for interpolation
+  uint32_t step;      // Q16.16 playback rate for interpolation
+};
+
+static BenchVoice benchVoices[BENCH_MAX_VOICES];
+static int8_t benchVoiceBuffers[BENCH_MAX_VOICES][BENCH_BLOCK_SIZE];
+static int16_t benchOutput[BENCH_BLOCK_SIZE];
+static int8_t benchEngineOutput[BENCH_BLOCK_SIZE];
+static volatile int32_t benchSink;  // Keeps results observable
+
+static void resetBenchVoices() {
+  for (int v = 0; v < BENCH_MAX_VOICES; v++) {
+    const SamplePlayer& player = samplePlayers[v % NUM_VOICES];
+    benchVoices[v].data = player.data;
+    benchVoices[v].length = player.length;
+    benchVoices[v].position = (v / NUM_VOICES) * 997;  // Spread flash reads
+    benchVoices[v].phase = benchVoices[v].position << 16;
+    benchVoices[v].step = 0x10000 + v * 0x1A00;  // 1.0x to ~2.5x
+  }
+}
+
+// Flash fetch: one pgm_read_byte per voice per sample
+static void kernelFetch(int voices) {
+  int32_t sum = 0;
+  for (int v = 0; v < voices; v++) {
+    BenchVoice& voice = benchVoices[v];
+    for (int i = 0; i < BENCH_BLOCK_SIZE; i++) {
+      sum += (int8_t)pgm_read_byte(&voice.data[voice.position]);
+      if (++voice.position >= voice.length) voice.position = 0;
+    }
+  }
+  benchSink = sum;
+}
+
+// Decode: 8-bit signed samples to 16-bit output scale
+static void kernelDecode(int voices) {
+  for (int v = 0; v < voices; v++) {
+    const int8_t* in = benchVoiceBuffers[v];
+    for (int i = 0; i < BENCH_BLOCK_SIZE; i++) {
+      benchOutput[i] = (int16_t)(in[i] * 256);
+    }
+  }
+  benchSink = benchOutput[BENCH_BLOCK_SIZE - 1];
+}
+
+// Linear interpolation at a fractional Q16.16 playback rate
+static void kernelInterpolate(int voices) {
+  for (int v = 0; v < voices; v++) {
+    BenchVoice& voice = benchVoices[v];
+    for (int i = 0; i < BENCH_BLOCK_SIZE; i++) {
+      uint32_t index = voice.phase >> 16;
+      if (index + 1 >= voice.length) {
+        voice.phase = 0;
+        index = 0;
+      }
+      int32_t a = (int8_t)pgm_read_byte(&voice.data[index]);
+      int32_t b = (int8_t)pgm_read_byte(&voice.data[index + 1]);
+      int32_t frac = voice.phase & 0xFFFF;
+      benchOutput[i] = (int16_t)(a * 256 + (((b - a) * frac) >> 8));
+      voice.phase += voice.step;
+    }
+  }
+  benchSink = benchOutput[BENCH_BLOCK_SIZE - 1];
+}
+
+// Mixer: sum voices already in RAM and clamp to the 8-bit output range
+static void kernelMix(int voices) {
+  for (int i = 0; i < BENCH_BLOCK_SIZE; i++) {
+    int16_t mixed = 0;
+    for (int v = 0; v < voices; v++) {
+      mixed += benchVoiceBuffers[v][i];
+    }
+    if (mixed > 127) mixed = 127;
+    if (mixed < -128) mixed = -128;
+    benchOutput[i] = mixed;
+  }
+  benchSink = benchOutput[BENCH_BLOCK_SIZE - 1];
+}
+
+static_assert(BENCH_BLOCK_SIZE % AUDIO_BLOCK_SIZE == 0,
+              "the engine kernel renders whole blocks");
+
+// The real engine, limited to the voices it actually has. Renders whole
+// blocks as updateAudio() does, so the per-block work (decay step, ramp
+// setup, peak reset) is counted too.
+static void kernelEngine(int voices) {
+  stopAllSamples();
+  for (int v = 0; v < voices; v++) {
+    triggerSample(v);
+  }
+  for (int i = 0; i < BENCH_BLOCK_SIZE; i += AUDIO_BLOCK_SIZE) {
+    renderBlock(benchEngineOutput + i, AUDIO_BLOCK_SIZE);
+  }
+  benchSink = benchEngineOutput[BENCH_BLOCK_SIZE - 1];
+}
+
+struct BenchKernel {
+  const char* name;
+  void (*run)(int voices);
+  int maxVoices;
+};
+
+static const BenchKernel benchKernels[] = {
+    {"fetch", kernelFetch, BENCH_MAX_VOICES},
+    {"decode", kernelDecode, BENCH_MAX_VOICES},
+    {"interp", kernelInterpolate, BENCH_MAX_VOICES},
+    {"mix", kernelMix, BENCH_MAX_VOICES},
+    {"engine", kernelEngine, NUM_VOICES},
+};
+
+static const int benchVoiceCounts[] = {1, 2, 4, 8, 16};
+
+void runAudioBenchmarks(ReportLineFn emit) {
+  char line[96];
+  uint32_t tickHz = cycleCounterHz();
+  double nsPerTick = 1e9 / tickHz;
+  double budgetNs = 1e9 / MOZZI_AUDIO_RATE;
+
+  snprintf(line, sizeof(line), "# bench,tick_hz=%lu,audio_rate=%d,budget_ns=%.0f",
+           (unsigned long)tickHz, MOZZI_AUDIO_RATE, budgetNs);
+  emit(line);
+  emit("kernel,voices,ticks_min,ticks_avg,ns_min,ns_avg,budget_pct");
+
+  // The engine kernel renders on the live engine. It runs far behind the
+  // real clock, so triggers already queued (MIDI, sequencer, host) are never
+  // due, and without the onset hook, so the latency probe sees nothing.
+  uint32_t savedClock = engineSampleClock();
+  VoiceOnsetFn savedOnsetHandler = currentVoiceOnsetHandler();
+  setEngineSampleClock(savedClock - BENCH_CLOCK_OFFSET);
+  setVoiceOnsetHandler(nullptr);
+
+  // Fill the RAM voice buffers the decode and mix kernels read from
+  resetBenchVoices();
+  for (int v = 0; v < BENCH_MAX_VOICES; v++) {
+    for (int i = 0; i < BENCH_BLOCK_SIZE; i++) {
+      benchVoiceBuffers[v][i] =
+          (int8_t)pgm_read_byte(&benchVoices[v].data[benchVoices[v].position + i]);
+    }
+  }
+
+  for (const BenchKernel& kernel : benchKernels) {
+    for (int voices : benchVoiceCounts) {
+      if (voices > kernel.maxVoices) continue;
+
+      resetBenchVoices();
+      kernel.run(voices);  // Warm up caches
+
+      uint32_t minTicks = UINT32_MAX;
+      uint64_t totalTicks = 0;
+      for (int r = 0; r < BENCH_REPEATS; r++) {
+        uint32_t start = readCycleCounter();
+        kernel.run(voices);
+        uint32_t ticks = readCycleCounter() - start;
+        if (ticks < minTicks) minTicks = ticks;
+        totalTicks += ticks;
+      }
+
+      double minPerSample = (double)minTicks / BENCH_BLOCK_SIZE;
+      double avgPerSample =
+          (double)totalTicks / BENCH_REPEATS / BENCH_BLOCK_SIZE;
+      snprintf(line, sizeof(line), "%s,%d,%.1f,%.1f,%.1f,%.1f,%.3f",
+               kernel.name, voices, minPerSample, avgPerSample,
+               minPerSample * nsPerTick, avgPerSample * nsPerTick,
+               avgPerSample * nsPerTick * 100.0 / budgetNs);
+      emit(line);
+    }
+  }
+
+  stopAllSamples();
+  setVoiceOnsetHandler(savedOnsetHandler);
+  setEngineSampleClock(savedClock);
+}
@@ -0,0 +1,32 @@
+/*
+  Cycle-cost benchmark suite for the audio hot path.
+
+  Times the building blocks of updateAudio() - flash fetch, 8-bit to 16-bit
+  decode, linear interpolation, the voice mixer and the real renderBlock() -
+  for 1 to 16 voices and reports the cost per output sample as CSV:
+
+    # bench,tick_hz=<hz>,audio_rate=<hz>,budget_ns=<ns per sample>
+    kernel,voices,ticks_min,ticks_avg,ns_min,ns_avg,budget_pct
+
+  Ticks are CPU cycles on the RP2040 and nanoseconds on the host build.
+  budget_pct is the average cost relative to one audio sample period.
+*/
+
+#ifndef AUDIO_BENCH_H
+#define AUDIO_BENCH_H
+
+#include "report.h"
+
+#define BENCH_MAX_VOICES 16
+#define BENCH_BLOCK_SIZE 256  // Samples rendered per timed run
+#define BENCH_REPEATS 32      // Timed runs per kernel/voice count
+#define BENCH_CLOCK_OFFSET 0x40000000u  // Engine runs this far in the past
+
+// Run every kernel and emit the CSV report line by line. The engine kernel
+// renders on the live engine: every playing voice is stopped, and audio is
+// interrupted while the suite runs on the module. The engine sample clock,
+// the scheduled triggers and the onset hook come back as they were, so the
+// engine and DAC clocks still count together afterwards.
+void runAudioBenchmarks(ReportLineFn emit);
+
+#endif  // AUDIO_BENCH_H
@@ -0,0 +1,8 @@
+/*
+  Audio sample clocks - see audio_clock.h
+*/
+
+#include "audio_clock.h"
+
+volatile uint32_t audioSamplesRendered = 0;
+volatile uint32_t audioSamplesOutput = 0;
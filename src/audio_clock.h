@@ -0,0 +1,23 @@
+/*
+  Audio sample clocks.
+
+  audioSamplesRendered counts samples handed to Mozzi by updateAudio();
+  audioSamplesOutput counts samples passed to the DAC by audioOutput(). Each
+  has a single writer, and the difference is the audio still buffered. Both
+  wrap at 2^32 samples (~72 hours), so compare them with signed differences.
+*/
+
+#ifndef AUDIO_CLOCK_H
+#define AUDIO_CLOCK_H
+
+#include <Arduino.h>
+
+extern volatile uint32_t audioSamplesRendered;
+extern volatile uint32_t audioSamplesOutput;
+
+// Samples rendered but not yet played
+inline int32_t audioSamplesBuffered() {
+  return (int32_t)(audioSamplesRendered - audioSamplesOutput);
+}
+
+#endif  // AUDIO_CLOCK_H
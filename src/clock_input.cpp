@@ -0,0 +1,162 @@
+/*
+  External clock input - see clock_input.h
+*/
+
+#include "clock_input.h"
+
+#include "sample_engine.h"
+#include "sequencer.h"
+
+// Step positions are counted in twelfths of a step, which every ratio below
+// advances by a whole number per pulse
+#define CLOCK_STEP_UNITS 12
+
+const ClockRatio clockRatios[CLOCK_RATIO_COUNT] = {
+    {1, 1, "x1"}, {2, 1, "x2"}, {4, 1, "x4"},
+    {1, 2, "/2"}, {1, 4, "/4"}, {1, 6, "/6 (24 PPQN)"}};
+
+// Edges from the pin interrupt (single producer, read by clockInputUpdate())
+static volatile uint32_t edgeQueue[CLOCK_EDGE_QUEUE];
+static volatile uint32_t edgeHead = 0;
+static uint32_t edgeTail = 0;
+
+// Recent pulses, oldest first, for the fit
+static uint32_t history[CLOCK_HISTORY];
+static int historyCount = 0;
+
+static bool running = false;
+static int ratio = 0;
+static uint32_t periodQ8 = 0;
+static uint32_t lastEdge = 0;
+static uint32_t stepPosition = 0;  // Of the latest pulse, in step units
+
+void clockInputEdge(uint32_t sampleClock) {
+  uint32_t head = edgeHead;
+  if (head - edgeTail >= CLOCK_EDGE_QUEUE) return;  // Update is stalled
+  edgeQueue[head % CLOCK_EDGE_QUEUE] = sampleClock;
+  edgeHead = head + 1;
+}
+
+// Least-squares line through the history against pulse number. Sets the
+// period and returns the fitted time of the latest pulse.
+static uint32_t fitHistory() {
+  int n = historyCount;
+  if (n < 2) return history[n - 1];
+
+  int64_t sumX = 0, sumY = 0, sumXX = 0, sumXY = 0;
+  for (int i = 0; i < n; i++) {
+    int64_t y = (int32_t)(history[i] - history[0]);
+    sumX += i;
+    sumY += y;
+    sumXX += i * i;
+    sumXY += i * y;
+  }
+
+  int64_t slopeQ8 = (n * sumXY - sumX * sumY) * 256 / (n * sumXX - sumX * sumX);
+  int64_t interceptQ8 = (sumY * 256 - slopeQ8 * sumX) / n;
+  int64_t latestQ8 = interceptQ8 + slopeQ8 * (n - 1);
+
+  periodQ8 = (uint32_t)slopeQ8;
+  return history[0] + (uint32_t)((latestQ8 + 128) >> 8);
+}
+
+// Re-lock the sequencer grid to the latest pulse, fitted at pulseClock
+static void syncSequencer(uint32_t pulseClock) {
+  if (periodQ8 == 0) return;  // Keep the internal tempo until two pulses
+
+  const ClockRatio& r = clockRatios[ratio];
+  uint32_t stepQ8 = periodQ8 * r.divide / r.multiply;
+
+  // Anchor on the step at or before the pulse
+  uint32_t step = stepPosition / CLOCK_STEP_UNITS;
+  uint32_t offset = stepPosition % CLOCK_STEP_UNITS;
+  uint32_t stepClock = pulseClock - ((uint64_t)stepQ8 * offset /
+                                     (CLOCK_STEP_UNITS * 256));
+  sequencerSync(step, stepClock, stepQ8);
+}
+
+static void addPulse(uint32_t edge) {
+  if (historyCount == CLOCK_HISTORY) {
+    for (int i = 1; i < CLOCK_HISTORY; i++) history[i - 1] = history[i];
+    historyCount--;
+  }
+  history[historyCount++] = edge;
+  lastEdge = edge;
+}
+
+// One pulse from the queue. Returns CLOCK_STARTED on the first pulse.
+static ClockEvent handleEdge(uint32_t edge) {
+  if (!running) {
+    historyCount = 0;
+    addPulse(edge);
+    stepPosition = 0;
+    running = true;
+    // The grid is anchored on the pulse, but the output buffer has already
+    // put the pulse behind the engine: steps already past are skipped, not
+    // fired late
+    sequencerStart(edge);
+    syncSequencer(edge);  // Last known period, if any
+    sequencerSkipBefore(engineSampleClock());
+    return CLOCK_STARTED;
+  }
+
+  uint32_t interval = edge - lastEdge;
+  if (interval < CLOCK_MIN_INTERVAL) return CLOCK_NO_CHANGE;
+  if (periodQ8 && interval < (periodQ8 >> 10)) return CLOCK_NO_CHANGE;
+
+  // A tempo jump restarts the fit from the previous pulse
+  uint32_t intervalQ8 = interval << 8;
+  uint32_t error = intervalQ8 > periodQ8 ? intervalQ8 - periodQ8
+                                         : periodQ8 - intervalQ8;
+  if (periodQ8 && error > periodQ8 / 4) {
+    history[0] = lastEdge;
+    historyCount = 1;
+  }
+
+  addPulse(edge);
+  const ClockRatio& r = clockRatios[ratio];
+  stepPosition += CLOCK_STEP_UNITS * r.multiply / r.divide;
+  syncSequencer(fitHistory());
+  return CLOCK_NO_CHANGE;
+}
+
+ClockEvent clockInputUpdate(uint32_t now) {
+  ClockEvent event = CLOCK_NO_CHANGE;
+
+  while (edgeTail != edgeHead) {
+    uint32_t edge = edgeQueue[edgeTail % CLOCK_EDGE_QUEUE];
+    edgeTail++;
+    if (running && edge - lastEdge > CLOCK_MAX_INTERVAL) {
+      running = false;  // Long gap: start over on this pulse
+    }
+    if (handleEdge(edge) == CLOCK_STARTED) event = CLOCK_STARTED;
+  }
+
+  // No pulse for a while: the clock has stopped
+  uint32_t timeout = periodQ8 && historyCount > 1
+                         ? (periodQ8 >> 8) * CLOCK_TIMEOUT_PERIODS
+                         : CLOCK_MAX_INTERVAL;
+  if (running && (int32_t)(now - lastEdge) > (int32_t)timeout) {
+    running = false;
+    sequencerStop();
+    event = CLOCK_STOPPED;
+  }
+  return event;
+}
+
+void clockInputReset() {
+  edgeTail = edgeHead;
+  historyCount = 0;
+  running = false;
+  periodQ8 = 0;
+}
+
+void clockInputSetRatio(int index) {
+  if (index >= 0 && index < CLOCK_RATIO_COUNT) ratio = index;
+}
+
+int clockInputRatio() { return ratio; }
+
+bool clockInputRunning() { return running; }
+
+uint32_t clockInputPeriodQ8() { return periodQ8; }
@@ -0,0 +1,67 @@
+/*
+  External clock input.
+
+  One trigger input can be used as a clock instead of a pad. Its pin
+  interrupt stamps the start of each pulse on the audio sample clock with
+  clockInputEdge(); clockInputUpdate(), called before each audio block,
+  fits a least-squares line through the last CLOCK_HISTORY pulses. The slope
+  is the pulse period and the line gives each pulse's de-jittered time, so
+  the period and phase follow the clock without following its jitter.
+
+  The fit drives the step sequencer: the first pulse starts it, every pulse
+  re-locks its step grid with sequencerSync(), and the sequencer predicts
+  the steps in between, multiplied or divided by the selected ratio. Steps
+  between pulses therefore sound on time rather than waiting for the next
+  edge. A clock that stops for CLOCK_TIMEOUT_PERIODS pulses stops the
+  sequencer; a jump of more than a quarter in the period restarts the fit
+  so tempo changes are followed within two pulses.
+*/
+
+#ifndef CLOCK_INPUT_H
+#define CLOCK_INPUT_H
+
+#include <Arduino.h>
+
+#define CLOCK_HISTORY 16         // Pulses in the fit
+#define CLOCK_EDGE_QUEUE 8       // Edges waiting for clockInputUpdate()
+#define CLOCK_TIMEOUT_PERIODS 2  // Pulses missing before the clock stops
+#define CLOCK_MIN_INTERVAL (MOZZI_AUDIO_RATE / 500)  // Closer is a glitch
+#define CLOCK_MAX_INTERVAL (MOZZI_AUDIO_RATE * 2)    // Longer restarts
+
+// Steps per clock pulse, as multiplier / divisor
+struct ClockRatio {
+  uint8_t multiply;
+  uint8_t divide;
+  const char* name;
+};
+
+#define CLOCK_RATIO_COUNT 6
+extern const ClockRatio clockRatios[CLOCK_RATIO_COUNT];
+
+enum ClockEvent {
+  CLOCK_NO_CHANGE,
+  CLOCK_STARTED,  // First pulse: the sequencer started on it
+  CLOCK_STOPPED,  // No pulse for CLOCK_TIMEOUT_PERIODS: sequencer stopped
+};
+
+// Pin interrupt hook: a clock pulse arrived at sampleClock
+void clockInputEdge(uint32_t sampleClock);
+
+// Fit new pulses and keep the sequencer locked to them. Call before each
+// audio block; now is the sample clock reaching the DAC, the same clock the
+// edges are stamped with.
+ClockEvent clockInputUpdate(uint32_t now);
+
+// Forget the clock (input switched off); the sequencer is left alone
+void clockInputReset();
+
+// Select clockRatios[index]; takes effect from the next pulse
+void clockInputSetRatio(int index);
+int clockInputRatio();
+
+bool clockInputRunning();
+
+// Fitted pulse period in 1/256 samples, 0 until two pulses have arrived
+uint32_t clockInputPeriodQ8();
+
+#endif  // CLOCK_INPUT_H
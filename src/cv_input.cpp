@@ -0,0 +1,169 @@
+/*
+  CV inputs - see cv_input.h
+*/
+
+#include "cv_input.h"
+
+#include "sample_engine.h"
+
+#ifndef SAMPLER_NATIVE
+#include <hardware/adc.h>
+#include <hardware/dma.h>
+#endif
+
+#define CV_RING_BYTES (CV_RING_SAMPLES * 2)
+#define CV_RING_BITS 9  // log2(CV_RING_BYTES), for the DMA address wrap
+#define CV_FULL_SCALE_Q4 (4095 << 4)
+#define CV_SELECT_ZONE_Q4 ((4096 << 4) / NUM_SAMPLES)
+
+// 2^(i/64) in Q16, for the fraction of an octave
+static const uint32_t octaveTable[65] = {
+    65536,  66250,  66971,  67700,  68438,  69183,  69936,  70698,
+    71468,  72246,  73032,  73828,  74632,  75444,  76266,  77096,
+    77936,  78785,  79642,  80510,  81386,  82273,  83169,  84074,
+    84990,  85915,  86851,  87796,  88752,  89719,  90696,  91684,
+    92682,  93691,  94711,  95743,  96785,  97839,  98905,  99982,
+    101070, 102171, 103283, 104408, 105545, 106694, 107856, 109031,
+    110218, 111418, 112631, 113858, 115098, 116351, 117618, 118899,
+    120194, 121502, 122825, 124163, 125515, 126882, 128263, 129660,
+    131072};
+
+// Per-block factor reaching -60 dB in T blocks, with T swept exponentially
+// from 1024 blocks (2 s) to 10.24 blocks (20 ms) over the CV range, Q16
+static const uint16_t decayTable[65] = {
+    65095, 65063, 65027, 64990, 64949, 64906, 64859, 64808,
+    64755, 64697, 64634, 64568, 64496, 64419, 64336, 64248,
+    64153, 64051, 63941, 63824, 63698, 63563, 63418, 63263,
+    63096, 62918, 62727, 62522, 62303, 62069, 61817, 61548,
+    61261, 60953, 60625, 60273, 59898, 59497, 59070, 58614,
+    58128, 57610, 57058, 56472, 55848, 55185, 54482, 53736,
+    52946, 52110, 51227, 50294, 49310, 48275, 47186, 46044,
+    44847, 43595, 42289, 40930, 39517, 38053, 36541, 34983,
+    33382};
+
+uint16_t cvRing[CV_RING_SAMPLES] __attribute__((aligned(CV_RING_BYTES)));
+
+static uint16_t smoothedQ4[CV_CHANNELS];
+static int sampleOffset = 0;
+static uint8_t targetMask = (1 << NUM_VOICES) - 1;
+
+void cvInputProcess(const uint16_t* ring, uint32_t writeIndex) {
+  // The newest complete frames end at the last frame boundary
+  uint32_t end = writeIndex & ~(uint32_t)(CV_CHANNELS - 1);
+
+  for (int channel = 0; channel < CV_CHANNELS; channel++) {
+    uint32_t sum = 0;
+    for (int frame = 1; frame <= CV_DECIMATE; frame++) {
+      uint32_t slot = end - frame * CV_CHANNELS + channel;
+      sum += ring[slot % CV_RING_SAMPLES] & 0x0FFF;
+    }
+
+    // Mean in Q12.4; with 16 frames the sum already is
+    int32_t mean = sum * 16 / CV_DECIMATE;
+    smoothedQ4[channel] += (mean - smoothedQ4[channel]) >> CV_SMOOTH_SHIFT;
+  }
+
+  // Sample select only moves once the CV is clearly inside another zone
+  int32_t value = smoothedQ4[CV_SELECT];
+  int32_t low = sampleOffset * CV_SELECT_ZONE_Q4 - (CV_SELECT_HYSTERESIS << 4);
+  int32_t high =
+      (sampleOffset + 1) * CV_SELECT_ZONE_Q4 + (CV_SELECT_HYSTERESIS << 4);
+  if (value < low || value >= high) {
+    sampleOffset = value / CV_SELECT_ZONE_Q4;
+    if (sampleOffset >= NUM_SAMPLES) sampleOffset = NUM_SAMPLES - 1;
+  }
+}
+
+uint16_t cvInputValue(int channel) { return smoothedQ4[channel]; }
+
+int cvInputSampleOffset() { return sampleOffset; }
+
+// Position of a value above the dead zone in 1/64 steps of the table range
+static uint32_t tablePosition(uint16_t valueQ4, uint32_t spanQ4) {
+  return (uint32_t)(valueQ4 - (CV_DEADZONE << 4)) * 64 * 256 / spanQ4;
+}
+
+// Linear interpolation in a 65-entry table at a position in 1/256 entries
+template <typename T>
+static uint32_t lookup(const T* table, uint32_t position) {
+  uint32_t index = position >> 8;
+  if (index >= 64) return table[64];
+  int32_t a = table[index];
+  int32_t b = table[index + 1];
+  return a + (((b - a) * (int32_t)(position & 0xFF)) >> 8);
+}
+
+uint32_t cvPitchStep(uint16_t valueQ4) {
+  if (valueQ4 < (CV_DEADZONE << 4)) return PITCH_UNITY;
+
+  // Octaves above 0 V, in 1/64 octave steps times 256
+  uint32_t position =
+      (uint32_t)valueQ4 * 64 * 256 / (CV_COUNTS_PER_OCTAVE << 4);
+  uint32_t octaves = position >> 14;
+  return lookup(octaveTable, position & 0x3FFF) << octaves;
+}
+
+uint32_t cvDecayFactor(uint16_t valueQ4) {
+  if (valueQ4 < (CV_DEADZONE << 4)) return DECAY_NONE;
+  return lookup(decayTable,
+                tablePosition(valueQ4, CV_FULL_SCALE_Q4 - (CV_DEADZONE << 4)));
+}
+
+void cvInputSetTarget(uint8_t voiceMask) {
+  targetMask = voiceMask;
+  for (int voice = 0; voice < NUM_VOICES; voice++) {
+    if (voiceMask & (1 << voice)) continue;
+    setVoiceModulation(voice, PITCH_UNITY, DECAY_NONE, 0);
+  }
+}
+
+uint8_t cvInputTarget() { return targetMask; }
+
+void cvInputApply() {
+  uint32_t pitch = cvPitchStep(smoothedQ4[CV_PITCH]);
+  uint32_t decay = cvDecayFactor(smoothedQ4[CV_DECAY]);
+  for (int voice = 0; voice < NUM_VOICES; voice++) {
+    if (!(targetMask & (1 << voice))) continue;
+    setVoiceModulation(voice, pitch, decay, sampleOffset);
+  }
+}
+
+#ifndef SAMPLER_NATIVE
+
+static int cvDmaChannel = -1;
+
+void cvInputBegin() {
+  adc_init();
+  adc_gpio_init(26);
+  adc_gpio_init(27);
+  adc_gpio_init(28);
+  adc_select_input(0);  // Round robin starts at ADC0, matching ring slot 0
+  adc_set_round_robin((1 << CV_CHANNELS) - 1);
+  adc_fifo_setup(true, true, 1, false, false);  // DREQ on every conversion
+  adc_set_clkdiv(48000000.0f / (CV_FRAME_RATE * CV_CHANNELS) - 1);
+
+  cvDmaChannel = dma_claim_unused_channel(true);
+  dma_channel_config config = dma_channel_get_default_config(cvDmaChannel);
+  channel_config_set_transfer_data_size(&config, DMA_SIZE_16);
+  channel_config_set_read_increment(&config, false);
+  channel_config_set_write_increment(&config, true);
+  channel_config_set_ring(&config, true, CV_RING_BITS);
+  channel_config_set_dreq(&config, DREQ_ADC);
+  dma_channel_configure(cvDmaChannel, &config, cvRing, &adc_hw->fifo,
+                        0xFFFFFFFF, true);
+  adc_run(true);
+}
+
+void cvInputUpdate() {
+  // The longest transfer lasts about 37 hours; start another when it ends
+  if (!dma_channel_is_busy(cvDmaChannel)) {
+    dma_channel_set_trans_count(cvDmaChannel, 0xFFFFFFFF, true);
+  }
+
+  uint32_t written =
+      dma_channel_hw_addr(cvDmaChannel)->write_addr - (uintptr_t)cvRing;
+  cvInputProcess(cvRing, written / 2);
+  cvInputApply();
+}
+
+#endif
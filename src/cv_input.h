@@ -0,0 +1,78 @@
+/*
+  CV inputs for voice pitch, decay and sample select.
+
+  The ADC free-runs in round-robin over ADC0-3 and a DMA channel streams
+  every conversion into cvRing, a circular buffer the DMA wraps by itself,
+  so no CPU time goes to starting or polling conversions. Once per audio
+  block cvInputUpdate() averages the newest CV_DECIMATE frames of each
+  channel, smooths the result with a one-pole filter and applies it to the
+  voices in the target mask:
+
+    CV1 (ADC0, GPIO26)  pitch: 1 V/octave up from the voice's own pitch
+    CV2 (ADC1, GPIO27)  decay: none added at 0 V, then 2 s down to 20 ms
+    CV3 (ADC2, GPIO28)  sample select: shifts each pad through the samples
+
+  The CVs modulate each voice's settings (setVoiceModulation()) rather than
+  replace them, so pitch, decay and sample set over serial or recalled from
+  a preset still hold with the CVs patched or not.
+
+  ADC3 (GPIO29, VSYS/3 on a Pico) is converted only to keep the round-robin
+  frame a power of two, so frames stay aligned as the ring wraps. Inputs
+  near 0 V map exactly to 1.0x and no decay, so unpatched jacks leave the
+  voices untouched.
+
+  The filtering and mapping are shared with the native host build, which
+  measures the jitter they leave on synthetic ADC traces (program cv).
+*/
+
+#ifndef CV_INPUT_H
+#define CV_INPUT_H
+
+#include <Arduino.h>
+
+#define CV_CHANNELS 4  // ADC0-3 in round-robin order
+#define CV_PITCH 0
+#define CV_DECAY 1
+#define CV_SELECT 2
+#define CV_RING_FRAMES 64  // Round-robin frames in the DMA ring
+#define CV_RING_SAMPLES (CV_RING_FRAMES * CV_CHANNELS)
+#define CV_FRAME_RATE 8000         // Conversions per second per channel
+#define CV_DECIMATE 16             // Frames averaged per block, power of two
+#define CV_SMOOTH_SHIFT 2          // One-pole smoothing, 1/4 per block
+#define CV_DEADZONE 16             // ADC counts that still count as 0 V
+#define CV_COUNTS_PER_OCTAVE 1241  // 1 V with 3.3 V full scale
+#define CV_SELECT_HYSTERESIS 32    // ADC counts past a zone edge to switch
+
+// Conversions, written by DMA, oldest overwritten first
+extern uint16_t cvRing[CV_RING_SAMPLES];
+
+// Start the ADC and DMA (firmware only)
+void cvInputBegin();
+
+// Filter the newest frames and apply them to the target voices. Call once
+// per audio block (firmware only).
+void cvInputUpdate();
+
+// Voices the CVs control; the rest drop the CV modulation and play their
+// own settings
+void cvInputSetTarget(uint8_t voiceMask);
+uint8_t cvInputTarget();
+
+// Apply the smoothed values to the target voices as modulation
+void cvInputApply();
+
+// Average the CV_DECIMATE frames before writeIndex (the ring slot the DMA
+// writes next) into the smoothed values
+void cvInputProcess(const uint16_t* ring, uint32_t writeIndex);
+
+// Smoothed value of a channel, ADC counts in Q12.4
+uint16_t cvInputValue(int channel);
+
+// Sample offset from CV3, with hysteresis, 0 to NUM_SAMPLES - 1
+int cvInputSampleOffset();
+
+// Mappings from a smoothed value (Q12.4)
+uint32_t cvPitchStep(uint16_t valueQ4);    // Q16.16 playback rate
+uint32_t cvDecayFactor(uint16_t valueQ4);  // Q16 per-block level factor
+
+#endif  // CV_INPUT_H
@@ -0,0 +1,31 @@
+/*
+  Portable cycle counter for profiling the audio path.
+
+  On the RP2040 this is the SysTick-backed CPU cycle count from the
+  arduino-pico core; on the native host build it is a nanosecond clock.
+  Differences of two readings are valid across wrap-around as long as the
+  interval is shorter than 2^32 ticks (~30s at 133MHz).
+*/
+
+#ifndef CYCLE_COUNTER_H
+#define CYCLE_COUNTER_H
+
+#include <Arduino.h>
+
+#ifdef SAMPLER_NATIVE
+#include <chrono>
+
+inline uint32_t readCycleCounter() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+inline uint32_t cycleCounterHz() { return 1000000000UL; }
+#else
+inline uint32_t readCycleCounter() { return rp2040.getCycleCount(); }
+
+inline uint32_t cycleCounterHz() { return rp2040.f_cpu(); }
+#endif
+
+#endif  // CYCLE_COUNTER_H
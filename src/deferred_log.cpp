@@ -0,0 +1,121 @@
+/*
+  Non-blocking deferred logger - see deferred_log.h
+*/
+
+#include "deferred_log.h"
+
+#include <stdio.h>
+
+#ifndef SAMPLER_NATIVE
+#include <hardware/sync.h>
+#include <pico/platform.h>
+#endif
+
+// Formats understand %d (integer) and %s (string pointer)
+static const char* const logFormats[LOG_MESSAGE_COUNT] = {
+    "Button %d (%s) triggered!",
+    "Playing %s (Button %d)",
+    "Sample triggered via spacebar: %s",
+    "Sequencer %s",
+    "Sequencer %s: %d",
+    "Clock %s: %s",
+    "CV controls %s",
+    "Pico DAC Sampler - Ready for button triggers",
+    "[log] %d messages dropped",
+};
+
+struct LogRecord {
+  LogMessageId id;
+  intptr_t args[2];
+};
+
+struct LogRing {
+  LogRecord records[LOG_RING_SIZE];
+  volatile uint32_t head;  // Written by the producing core
+  volatile uint32_t tail;  // Written by logFlush()
+  volatile uint32_t dropped;
+  uint32_t droppedReported;
+};
+
+static LogRing logRings[LOG_CORES];
+
+void logMessage(LogMessageId id, intptr_t arg0, intptr_t arg1) {
+#ifdef SAMPLER_NATIVE
+  LogRing& ring = logRings[0];
+#else
+  LogRing& ring = logRings[get_core_num()];
+#endif
+
+  uint32_t head = ring.head;
+  if (head - ring.tail >= LOG_RING_SIZE) {
+    ring.dropped++;
+    return;
+  }
+
+  LogRecord& record = ring.records[head & (LOG_RING_SIZE - 1)];
+  record.id = id;
+  record.args[0] = arg0;
+  record.args[1] = arg1;
+
+#ifndef SAMPLER_NATIVE
+  __dmb();  // Record must be visible before the other core sees the head
+#endif
+  ring.head = head + 1;
+}
+
+// Expand %d and %s with the record's arguments
+static size_t formatRecord(const LogRecord& record, char* line) {
+  const char* format = logFormats[record.id];
+  size_t length = 0;
+  int arg = 0;
+
+  for (const char* p = format; *p && length < LOG_LINE_MAX - 1; p++) {
+    if (p[0] == '%' && (p[1] == 'd' || p[1] == 's') && arg < 2) {
+      if (p[1] == 'd') {
+        length += snprintf(line + length, LOG_LINE_MAX - length, "%ld",
+                           (long)record.args[arg++]);
+      } else {
+        length += snprintf(line + length, LOG_LINE_MAX - length, "%s",
+                           (const char*)record.args[arg++]);
+      }
+      if (length >= LOG_LINE_MAX) length = LOG_LINE_MAX - 1;
+      p++;
+    } else {
+      line[length++] = *p;
+    }
+  }
+
+  line[length] = '\0';
+  return length;
+}
+
+void logFlush(LogWriteFn write) {
+  char line[LOG_LINE_MAX];
+
+  for (int core = 0; core < LOG_CORES; core++) {
+    LogRing& ring = logRings[core];
+
+    // Report drops first so they appear near where messages went missing
+    uint32_t dropped = ring.dropped;
+    if (dropped != ring.droppedReported) {
+      LogRecord record = {LOG_DROPPED,
+                          {(intptr_t)(dropped - ring.droppedReported), 0}};
+      size_t length = formatRecord(record, line);
+      if (!write(line, length)) return;
+      ring.droppedReported = dropped;
+    }
+
+    while (ring.tail != ring.head) {
+      const LogRecord& record = ring.records[ring.tail & (LOG_RING_SIZE - 1)];
+      size_t length = formatRecord(record, line);
+      if (!write(line, length)) return;  // Transport busy, try again later
+      ring.tail = ring.tail + 1;
+    }
+  }
+}
+
+uint32_t logDroppedCount() {
+  uint32_t total = 0;
+  for (int core = 0; core < LOG_CORES; core++) total += logRings[core].dropped;
+  return total;
+}
@@ -0,0 +1,53 @@
+/*
+  Non-blocking deferred logger for the control path.
+
+  logMessage() stores a message ID and up to two arguments in a ring buffer
+  and returns; it never formats and never touches Serial. logFlush(), called
+  from idle time in loop(), formats queued messages and hands them to the
+  transport one whole line at a time, stopping as soon as the transport has
+  no room. When a ring is full new messages are dropped and counted, and the
+  count is reported by the next flush.
+
+  Each core has its own single-producer ring, so a core may log without
+  locking. Do not log from interrupt handlers.
+*/
+
+#ifndef DEFERRED_LOG_H
+#define DEFERRED_LOG_H
+
+#include <Arduino.h>
+
+#define LOG_RING_SIZE 32  // Messages per core, power of two
+#define LOG_CORES 2
+#define LOG_LINE_MAX 96   // Longest formatted message
+
+// Message formats live in deferred_log.cpp, in the same order
+enum LogMessageId : uint8_t {
+  LOG_BUTTON_TRIGGERED,   // button number, name
+  LOG_PLAYING,            // name, button number
+  LOG_SERIAL_TRIGGER,     // name
+  LOG_SEQUENCER_STATE,    // "running"/"stopped", "recording"/"playing"
+  LOG_SEQUENCER_SETTING,  // setting name, value
+  LOG_CLOCK_SETTING,      // setting name, value name
+  LOG_CV_TARGET,          // pad name or "all pads"
+  LOG_STATUS,
+  LOG_DROPPED,            // count (internal)
+  LOG_MESSAGE_COUNT
+};
+
+// Writes a whole line (without newline) or nothing. Returns false when the
+// transport cannot take the line right now.
+typedef bool (*LogWriteFn)(const char* line, size_t length);
+
+// Queue a message. Integer arguments are passed as-is, %s arguments as
+// pointers to strings that outlive the queue (names, literals).
+void logMessage(LogMessageId id, intptr_t arg0 = 0, intptr_t arg1 = 0);
+
+// Format and write queued messages until the rings are empty or write()
+// reports the transport is busy
+void logFlush(LogWriteFn write);
+
+// Messages dropped because a ring was full (since boot)
+uint32_t logDroppedCount();
+
+#endif  // DEFERRED_LOG_H
@@ -0,0 +1,125 @@
+/*
+  OLED frame scheduler - see display_scheduler.h
+*/
+
+#include "display_scheduler.h"
+
+#include <stdio.h>
+
+#include <atomic>
+
+static bool dirty = false;
+static uint32_t lastFrameMs = 0;
+static bool anyFrame = false;
+static uint32_t frameIntervalMs = DISPLAY_MIN_FRAME_MS;
+static uint32_t costEma = 0;  // Frame cost in us, scaled by 2^shift
+
+// Report window, display core only
+static uint32_t windowFrames = 0;
+static uint32_t windowUpdates = 0;
+static uint64_t windowComposeUs = 0;
+static uint64_t windowFlushUs = 0;
+static uint32_t windowComposeMax = 0;
+static uint32_t windowFlushMax = 0;
+
+// A closed window, handed from core 1 to the report on core 0
+struct DisplayWindow {
+  uint32_t frames;
+  uint32_t updates;
+  uint64_t composeUs;
+  uint64_t flushUs;
+  uint32_t composeMax;
+  uint32_t flushMax;
+  uint32_t frameIntervalMs;
+};
+static DisplayWindow reportWindow;
+static volatile bool reportRequested = false;  // Set by core 0
+static volatile bool reportReady = false;      // Set by core 1
+
+void displayMarkDirty() {
+  dirty = true;
+  windowUpdates++;
+}
+
+bool displayFrameDue(uint32_t nowMs) {
+  if (!dirty) return false;
+  return !anyFrame || nowMs - lastFrameMs >= frameIntervalMs;
+}
+
+void displayFrameDone(uint32_t composeUs, uint32_t flushUs, uint32_t nowMs) {
+  dirty = false;
+  anyFrame = true;
+  lastFrameMs = nowMs;
+
+  uint32_t cost = composeUs + flushUs;
+  if (costEma == 0) costEma = cost << DISPLAY_COST_EMA_SHIFT;
+  costEma += cost - (costEma >> DISPLAY_COST_EMA_SHIFT);
+
+  // Spacing that keeps frames within the duty cycle
+  uint32_t averageUs = costEma >> DISPLAY_COST_EMA_SHIFT;
+  uint32_t interval = averageUs * 100 / DISPLAY_MAX_DUTY_PCT / 1000;
+  if (interval < DISPLAY_MIN_FRAME_MS) interval = DISPLAY_MIN_FRAME_MS;
+  if (interval > DISPLAY_MAX_FRAME_MS) interval = DISPLAY_MAX_FRAME_MS;
+  frameIntervalMs = interval;
+
+  windowFrames++;
+  windowComposeUs += composeUs;
+  windowFlushUs += flushUs;
+  if (composeUs > windowComposeMax) windowComposeMax = composeUs;
+  if (flushUs > windowFlushMax) windowFlushMax = flushUs;
+}
+
+uint32_t displayFrameIntervalMs() { return frameIntervalMs; }
+
+void displaySchedulerService() {
+  if (!reportRequested || reportReady) return;
+
+  reportWindow.frames = windowFrames;
+  reportWindow.updates = windowUpdates;
+  reportWindow.composeUs = windowComposeUs;
+  reportWindow.flushUs = windowFlushUs;
+  reportWindow.composeMax = windowComposeMax;
+  reportWindow.flushMax = windowFlushMax;
+  reportWindow.frameIntervalMs = frameIntervalMs;
+
+  windowFrames = 0;
+  windowUpdates = 0;
+  windowComposeUs = 0;
+  windowFlushUs = 0;
+  windowComposeMax = 0;
+  windowFlushMax = 0;
+
+  // Window must be visible before core 0 sees it is ready
+  std::atomic_thread_fence(std::memory_order_release);
+  reportReady = true;
+}
+
+bool displaySchedulerReport(ReportLineFn emit) {
+  if (!reportReady) {
+    reportRequested = true;
+    return false;
+  }
+  std::atomic_thread_fence(std::memory_order_acquire);
+
+  char line[128];
+  snprintf(line, sizeof(line),
+           "# display,min_frame_ms=%d,max_frame_ms=%d,duty_pct=%d",
+           DISPLAY_MIN_FRAME_MS, DISPLAY_MAX_FRAME_MS, DISPLAY_MAX_DUTY_PCT);
+  emit(line);
+  emit("frames,updates,coalesced,compose_us_avg,compose_us_max,flush_us_avg,"
+       "flush_us_max,frame_ms");
+
+  const DisplayWindow& w = reportWindow;
+  snprintf(line, sizeof(line), "%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu",
+           (unsigned long)w.frames, (unsigned long)w.updates,
+           (unsigned long)(w.updates > w.frames ? w.updates - w.frames : 0),
+           (unsigned long)(w.frames ? w.composeUs / w.frames : 0),
+           (unsigned long)w.composeMax,
+           (unsigned long)(w.frames ? w.flushUs / w.frames : 0),
+           (unsigned long)w.flushMax, (unsigned long)w.frameIntervalMs);
+  emit(line);
+
+  reportRequested = false;
+  reportReady = false;
+  return true;
+}
@@ -0,0 +1,49 @@
+/*
+  Frame scheduler for the OLED (display core).
+
+  Anything that changes what the screen shows calls displayMarkDirty();
+  displayFrameDue() then says when to draw. Changes that arrive before the
+  next frame is due collapse into that one frame, so a burst of triggers
+  costs one redraw. The minimum spacing between frames follows the measured
+  cost of composing and flushing them: the display may use at most
+  DISPLAY_MAX_DUTY_PCT of its core, within a 30 Hz to 5 Hz frame rate.
+
+  Report (serial 'd' command). The counters belong to the display core:
+  core 0 asks for them, and core 1 hands the window over and starts a new
+  one on its next pass, so they are never read while being updated:
+    # display,min_frame_ms=<ms>,max_frame_ms=<ms>,duty_pct=<pct>
+    frames,updates,coalesced,compose_us_avg,compose_us_max,flush_us_avg,flush_us_max,frame_ms
+*/
+
+#ifndef DISPLAY_SCHEDULER_H
+#define DISPLAY_SCHEDULER_H
+
+#include <Arduino.h>
+
+#include "report.h"
+
+#define DISPLAY_MIN_FRAME_MS 33   // Fastest frame rate, ~30 Hz
+#define DISPLAY_MAX_FRAME_MS 200  // Slowest frame rate under load, 5 Hz
+#define DISPLAY_MAX_DUTY_PCT 25   // Share of the core frames may take
+#define DISPLAY_COST_EMA_SHIFT 3  // Frame cost averages ~8 frames
+
+// Something visible changed
+void displayMarkDirty();
+
+// True when a frame should be drawn now
+bool displayFrameDue(uint32_t nowMs);
+
+// Record a drawn frame's cost and adapt the frame spacing
+void displayFrameDone(uint32_t composeUs, uint32_t flushUs, uint32_t nowMs);
+
+// Current minimum spacing between frames
+uint32_t displayFrameIntervalMs();
+
+// Display core, once per pass: hand the report window over if asked for
+void displaySchedulerService();
+
+// Prints the window core 1 handed over. Until it has, asks for it and
+// returns false; call again on a later pass.
+bool displaySchedulerReport(ReportLineFn emit);
+
+#endif  // DISPLAY_SCHEDULER_H
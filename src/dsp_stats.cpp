@@ -0,0 +1,77 @@
+/*
+  DSP load and underrun instrumentation - see dsp_stats.h
+*/
+
+#include "dsp_stats.h"
+
+#include <stdio.h>
+
+#include "sample_engine.h"
+
+#define LOAD_EMA_SHIFT 5  // Rolling load averages ~32 blocks (~60ms)
+
+static uint32_t budgetCycles = 1;
+static uint32_t windowBlocks = 0;
+static uint32_t windowMin = UINT32_MAX;
+static uint32_t windowMax = 0;
+static uint64_t windowTotal = 0;
+static uint32_t loadEma = 0;  // Block cycles scaled by 2^LOAD_EMA_SHIFT
+static volatile uint32_t underrunCount = 0;
+static uint32_t lateBlockCount = 0;
+static uint8_t voicesHighWater = 0;
+
+void dspStatsBegin(uint32_t budgetCyclesPerBlock) {
+  budgetCycles = budgetCyclesPerBlock ? budgetCyclesPerBlock : 1;
+}
+
+void dspStatsRecordBlock(uint32_t cycles, int activeVoices) {
+  windowBlocks++;
+  windowTotal += cycles;
+  if (cycles < windowMin) windowMin = cycles;
+  if (cycles > windowMax) windowMax = cycles;
+  if (cycles > budgetCycles) lateBlockCount++;
+  if (activeVoices > voicesHighWater) voicesHighWater = activeVoices;
+
+  loadEma += cycles - (loadEma >> LOAD_EMA_SHIFT);
+}
+
+void dspStatsRecordUnderrun() { underrunCount++; }
+
+void dspStatsTakeSnapshot(DspStatsSnapshot& snapshot) {
+  snapshot.blocks = windowBlocks;
+  snapshot.cyclesMin = windowBlocks ? windowMin : 0;
+  snapshot.cyclesAvg = windowBlocks ? (uint32_t)(windowTotal / windowBlocks) : 0;
+  snapshot.cyclesMax = windowMax;
+  snapshot.budgetCycles = budgetCycles;
+  snapshot.loadPercentX10 =
+      (uint16_t)(((uint64_t)(loadEma >> LOAD_EMA_SHIFT) * 1000) / budgetCycles);
+  snapshot.peakPercentX10 = (uint16_t)(((uint64_t)windowMax * 1000) / budgetCycles);
+  snapshot.underruns = underrunCount;
+  snapshot.lateBlocks = lateBlockCount;
+  snapshot.voicesHighWater = voicesHighWater;
+
+  windowBlocks = 0;
+  windowMin = UINT32_MAX;
+  windowMax = 0;
+  windowTotal = 0;
+}
+
+void dspStatsReport(ReportLineFn emit) {
+  DspStatsSnapshot s;
+  dspStatsTakeSnapshot(s);
+
+  char line[128];
+  snprintf(line, sizeof(line), "# dsp,block_size=%d,budget_cycles=%lu",
+           AUDIO_BLOCK_SIZE, (unsigned long)s.budgetCycles);
+  emit(line);
+  emit("blocks,cycles_min,cycles_avg,cycles_max,load_pct,peak_load_pct,"
+       "underruns,late_blocks,voices_hwm");
+  snprintf(line, sizeof(line), "%lu,%lu,%lu,%lu,%u.%u,%u.%u,%lu,%lu,%u",
+           (unsigned long)s.blocks, (unsigned long)s.cyclesMin,
+           (unsigned long)s.cyclesAvg, (unsigned long)s.cyclesMax,
+           s.loadPercentX10 / 10, s.loadPercentX10 % 10,
+           s.peakPercentX10 / 10, s.peakPercentX10 % 10,
+           (unsigned long)s.underruns, (unsigned long)s.lateBlocks,
+           s.voicesHighWater);
+  emit(line);
+}
@@ -0,0 +1,48 @@
+/*
+  DSP load and underrun instrumentation.
+
+  The audio path records each rendered block's cycle cost and the number of
+  voices playing, and audioOutput() records underruns. Recording is a handful
+  of adds and compares; all division happens when a report is produced.
+
+  Report (serial 's' command), the window resets after every report:
+    # dsp,block_size=<samples>,budget_cycles=<cycles per block>
+    blocks,cycles_min,cycles_avg,cycles_max,load_pct,peak_load_pct,underruns,late_blocks,voices_hwm
+*/
+
+#ifndef DSP_STATS_H
+#define DSP_STATS_H
+
+#include <Arduino.h>
+
+#include "report.h"
+
+struct DspStatsSnapshot {
+  uint32_t blocks;         // Blocks rendered in this window
+  uint32_t cyclesMin;      // Cheapest block in this window
+  uint32_t cyclesAvg;      // Mean block cost in this window
+  uint32_t cyclesMax;      // Most expensive block in this window
+  uint32_t budgetCycles;   // Cycles available per block in real time
+  uint16_t loadPercentX10; // Rolling render load, 0.1% units
+  uint16_t peakPercentX10; // cyclesMax relative to the budget, 0.1% units
+  uint32_t underruns;      // Output found no rendered audio (since boot)
+  uint32_t lateBlocks;     // Blocks that took longer than real time (since boot)
+  uint8_t voicesHighWater; // Most voices playing at once (since boot)
+};
+
+// Call once the cycle counter runs, before audio starts
+void dspStatsBegin(uint32_t budgetCyclesPerBlock);
+
+// Hot path: one call per rendered block
+void dspStatsRecordBlock(uint32_t cycles, int activeVoices);
+
+// Hot path: audioOutput() ran with nothing rendered
+void dspStatsRecordUnderrun();
+
+// Copy the current numbers and start a new min/avg/max window
+void dspStatsTakeSnapshot(DspStatsSnapshot& snapshot);
+
+// Emit a snapshot as the CSV report
+void dspStatsReport(ReportLineFn emit);
+
+#endif  // DSP_STATS_H
@@ -0,0 +1,57 @@
+/*
+  Radix-2 fixed-point FFT - see fft_q15.h
+*/
+
+#include "fft_q15.h"
+
+// A RAM copy of the constexpr tables, so the analyzer doesn't compete with
+// sample playback for the flash cache
+static FftTables tables = FFT_TABLES;
+
+static uint32_t bitReverse(uint32_t index) {
+  uint32_t reversed = 0;
+  for (int bit = 0; bit < FFT_LOG2_SIZE; bit++) {
+    reversed = (reversed << 1) | (index & 1);
+    index >>= 1;
+  }
+  return reversed;
+}
+
+void fftLoadQ15(const int8_t* samples, int16_t* re, int16_t* im) {
+  for (uint32_t n = 0; n < FFT_SIZE; n++) {
+    uint32_t slot = bitReverse(n);
+    int32_t sample = (int32_t)samples[n] << 7;  // Half scale
+    re[slot] = (int16_t)((sample * tables.window[n]) >> 15);
+    im[slot] = 0;
+  }
+}
+
+void fftStageQ15(int16_t* re, int16_t* im, int stage) {
+  int half = 1 << (stage - 1);
+  int twiddleStep = FFT_SIZE >> stage;
+
+  for (int j = 0; j < half; j++) {
+    int32_t c = tables.cosine[j * twiddleStep];
+    int32_t s = tables.sine[j * twiddleStep];
+
+    for (int top = j; top < FFT_SIZE; top += 2 * half) {
+      int bottom = top + half;
+
+      // (re + j im) * (cos - j sin)
+      int32_t tr = (re[bottom] * c + im[bottom] * s) >> 15;
+      int32_t ti = (im[bottom] * c - re[bottom] * s) >> 15;
+
+      re[bottom] = (int16_t)((re[top] - tr) >> 1);
+      im[bottom] = (int16_t)((im[top] - ti) >> 1);
+      re[top] = (int16_t)((re[top] + tr) >> 1);
+      im[top] = (int16_t)((im[top] + ti) >> 1);
+    }
+  }
+}
+
+void fftQ15(const int8_t* samples, int16_t* re, int16_t* im) {
+  fftLoadQ15(samples, re, im);
+  for (int stage = 1; stage <= FFT_LOG2_SIZE; stage++) {
+    fftStageQ15(re, im, stage);
+  }
+}
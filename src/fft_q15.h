@@ -0,0 +1,83 @@
+/*
+  Radix-2 fixed-point FFT (Q15), for the spectrum display.
+
+  Decimation in time, in place, with a right shift after every stage so
+  values never overflow: the result is the DFT divided by FFT_SIZE. The
+  twiddle factors and the Hann window are computed at compile time.
+
+  The transform is split into stages so a caller can spread one FFT over
+  several time slices (see spectrum.cpp).
+*/
+
+#ifndef FFT_Q15_H
+#define FFT_Q15_H
+
+#include <Arduino.h>
+
+#define FFT_LOG2_SIZE 8
+#define FFT_SIZE (1 << FFT_LOG2_SIZE)
+
+struct FftTables {
+  int16_t cosine[FFT_SIZE / 2];  // cos(2 pi k / N), Q15
+  int16_t sine[FFT_SIZE / 2];    // sin(2 pi k / N), Q15
+  int16_t window[FFT_SIZE];      // Hann window, Q15
+
+  constexpr FftTables();
+};
+
+// Load 8-bit samples into re/im in bit-reversed order, Hann windowed and
+// scaled to half of Q15 full scale for headroom
+void fftLoadQ15(const int8_t* samples, int16_t* re, int16_t* im);
+
+// Run butterfly stage 1..FFT_LOG2_SIZE in place
+void fftStageQ15(int16_t* re, int16_t* im, int stage);
+
+// Whole transform: load then every stage
+void fftQ15(const int8_t* samples, int16_t* re, int16_t* im);
+
+// ---------------------------------------------------------------------------
+// Compile-time table generation
+
+namespace fft_detail {
+
+constexpr double pi = 3.14159265358979323846;
+
+// Taylor series, accurate to well under one Q15 step on [-pi, pi]
+constexpr double sine(double x) {
+  while (x > pi) x -= 2 * pi;
+  while (x < -pi) x += 2 * pi;
+  double term = x, sum = x;
+  for (int n = 1; n < 14; n++) {
+    term *= -x * x / ((2 * n) * (2 * n + 1));
+    sum += term;
+  }
+  return sum;
+}
+
+constexpr double cosine(double x) { return sine(x + pi / 2); }
+
+constexpr int16_t q15(double x) {
+  double scaled = x * 32768.0;
+  scaled += scaled < 0 ? -0.5 : 0.5;
+  if (scaled > 32767) return 32767;
+  if (scaled < -32768) return -32768;
+  return (int16_t)scaled;
+}
+
+}  // namespace fft_detail
+
+constexpr FftTables::FftTables() : cosine(), sine(), window() {
+  for (int k = 0; k < FFT_SIZE / 2; k++) {
+    double angle = 2 * fft_detail::pi * k / FFT_SIZE;
+    cosine[k] = fft_detail::q15(fft_detail::cosine(angle));
+    sine[k] = fft_detail::q15(fft_detail::sine(angle));
+  }
+  for (int n = 0; n < FFT_SIZE; n++) {
+    double angle = 2 * fft_detail::pi * n / FFT_SIZE;
+    window[n] = fft_detail::q15(0.5 - 0.5 * fft_detail::cosine(angle));
+  }
+}
+
+constexpr FftTables FFT_TABLES{};
+
+#endif  // FFT_Q15_H
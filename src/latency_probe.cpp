@@ -0,0 +1,152 @@
+/*
+  Trigger-to-sound latency probes - see latency_probe.h
+*/
+
+#include "latency_probe.h"
+
+#include <Mozzi.h>
+#include <stdio.h>
+
+#include "sample_engine.h"
+
+static const char* const latencyIntervalNames[LATENCY_INTERVAL_COUNT] = {
+    "edge_to_detected", "detected_to_triggered", "triggered_to_sound",
+    "edge_to_sound"};
+
+// Measurements that never reach the sound stage (a bounce the debouncer
+// rejected, a silent sample) are abandoned after the histogram range
+#define LATENCY_TIMEOUT_SAMPLES (LATENCY_BINS * LATENCY_BIN_SAMPLES)
+
+// One measurement in flight per voice
+struct LatencyPending {
+  uint32_t start;  // Sample clock of the first stage stamped
+  uint32_t stamp[LATENCY_STAGE_COUNT];
+  volatile uint8_t stages;  // Bit per stage stamped so far
+};
+
+static LatencyPending pending[NUM_VOICES];
+static volatile uint8_t onsetArmed = 0;  // Voices waiting for their onset
+
+static uint16_t histogram[LATENCY_INTERVAL_COUNT][LATENCY_BINS];
+static uint32_t intervalCount[LATENCY_INTERVAL_COUNT];
+static uint32_t intervalMax[LATENCY_INTERVAL_COUNT];
+
+static void recordInterval(int interval, const LatencyPending& p, int from,
+                           int to) {
+  if (!(p.stages & (1 << from)) || !(p.stages & (1 << to))) return;
+
+  uint32_t samples = p.stamp[to] - p.stamp[from];
+  uint32_t bin = samples / LATENCY_BIN_SAMPLES;
+  if (bin >= LATENCY_BINS) bin = LATENCY_BINS - 1;
+
+  if (histogram[interval][bin] < UINT16_MAX) histogram[interval][bin]++;
+  intervalCount[interval]++;
+  if (samples > intervalMax[interval]) intervalMax[interval] = samples;
+}
+
+void latencyProbeMark(int voice, LatencyStage stage, uint32_t sampleClock) {
+  if (voice < 0 || voice >= NUM_VOICES) return;
+  LatencyPending& p = pending[voice];
+
+  if (p.stages && sampleClock - p.start > LATENCY_TIMEOUT_SAMPLES) {
+    p.stages = 0;
+  }
+
+  if (stage == LATENCY_EDGE && p.stages) {
+    return;  // Bounce, or still measuring the last press
+  }
+  if (stage == LATENCY_TRIGGERED) {
+    onsetArmed &= ~(1 << voice);  // A retrigger restarts the onset wait
+  }
+
+  if (!p.stages) p.start = sampleClock;
+  p.stamp[stage] = sampleClock;
+  p.stages |= 1 << stage;
+}
+
+void latencyProbeOnset(int voice, uint32_t sampleClock) {
+  LatencyPending& p = pending[voice];
+  if (!(p.stages & (1 << LATENCY_TRIGGERED))) return;
+
+  p.stamp[LATENCY_SOUND] = sampleClock;
+  onsetArmed |= 1 << voice;
+}
+
+void latencyProbeOutput(uint32_t sampleClock) {
+  if (!onsetArmed) return;  // Common case: a single load and compare
+
+  for (int i = 0; i < NUM_VOICES; i++) {
+    if (!(onsetArmed & (1 << i))) continue;
+
+    LatencyPending& p = pending[i];
+    if ((int32_t)(sampleClock - p.stamp[LATENCY_SOUND]) < 0) continue;
+
+    p.stages |= 1 << LATENCY_SOUND;
+    recordInterval(LATENCY_EDGE_TO_DETECTED, p, LATENCY_EDGE, LATENCY_DETECTED);
+    recordInterval(LATENCY_DETECTED_TO_TRIGGERED, p, LATENCY_DETECTED,
+                   LATENCY_TRIGGERED);
+    recordInterval(LATENCY_TRIGGERED_TO_SOUND, p, LATENCY_TRIGGERED,
+                   LATENCY_SOUND);
+    recordInterval(LATENCY_EDGE_TO_SOUND, p, LATENCY_EDGE, LATENCY_SOUND);
+
+    onsetArmed &= ~(1 << i);
+    p.stages = 0;
+  }
+}
+
+void latencyProbeSummary(LatencyInterval interval, LatencySummary& summary) {
+  summary.count = intervalCount[interval];
+  summary.max = intervalMax[interval];
+  summary.p50 = 0;
+  summary.p99 = 0;
+  if (!summary.count) return;
+
+  // Percentiles report the upper edge of the bin they fall in
+  uint32_t p50Target = (summary.count * 50 + 99) / 100;
+  uint32_t p99Target = (summary.count * 99 + 99) / 100;
+  uint32_t seen = 0;
+  bool haveP50 = false;
+  for (int bin = 0; bin < LATENCY_BINS; bin++) {
+    seen += histogram[interval][bin];
+    uint32_t edge = (bin + 1) * LATENCY_BIN_SAMPLES - 1;
+    if (edge > summary.max) edge = summary.max;
+    if (!haveP50 && seen >= p50Target) {
+      summary.p50 = edge;
+      haveP50 = true;
+    }
+    if (seen >= p99Target) {
+      summary.p99 = edge;
+      break;
+    }
+  }
+}
+
+void latencyProbeReset() {
+  for (int i = 0; i < LATENCY_INTERVAL_COUNT; i++) {
+    for (int bin = 0; bin < LATENCY_BINS; bin++) histogram[i][bin] = 0;
+    intervalCount[i] = 0;
+    intervalMax[i] = 0;
+  }
+  for (int i = 0; i < NUM_VOICES; i++) pending[i].stages = 0;
+  onsetArmed = 0;
+}
+
+void latencyProbeReport(ReportLineFn emit) {
+  char line[112];
+  double msPerSample = 1000.0 / MOZZI_AUDIO_RATE;
+
+  snprintf(line, sizeof(line), "# latency,unit=samples,sample_us=%.2f,bin=%d",
+           msPerSample * 1000.0, LATENCY_BIN_SAMPLES);
+  emit(line);
+  emit("interval,count,p50,p99,max,p50_ms,p99_ms,max_ms");
+
+  for (int i = 0; i < LATENCY_INTERVAL_COUNT; i++) {
+    LatencySummary s;
+    latencyProbeSummary((LatencyInterval)i, s);
+    snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu,%.2f,%.2f,%.2f",
+             latencyIntervalNames[i], (unsigned long)s.count,
+             (unsigned long)s.p50, (unsigned long)s.p99, (unsigned long)s.max,
+             s.p50 * msPerSample, s.p99 * msPerSample, s.max * msPerSample);
+    emit(line);
+  }
+}
@@ -0,0 +1,70 @@
+/*
+  Trigger-to-sound latency probes.
+
+  Each trigger is timestamped on the audio sample clock at four stages:
+
+    edge      GPIO falling edge (pin interrupt)
+    detected  updateButtons() accepted the debounced press
+    triggered processButtonTriggers() started the voice
+    sound     audioOutput() played the voice's first non-zero sample
+
+  When the sound stage arrives the stage-to-stage intervals are added to
+  histograms with LATENCY_BIN_SAMPLES resolution. Stages that a trigger
+  skips (serial triggers have no edge) leave their intervals out.
+
+  Report (serial 'l' command):
+    # latency,unit=samples,sample_us=<us>,bin=<samples>
+    interval,count,p50,p99,max,p50_ms,p99_ms,max_ms
+*/
+
+#ifndef LATENCY_PROBE_H
+#define LATENCY_PROBE_H
+
+#include <Arduino.h>
+
+#include "report.h"
+
+#define LATENCY_BIN_SAMPLES 4  // Histogram resolution (~244us)
+#define LATENCY_BINS 256       // Range ~62ms, longer goes in the last bin
+
+enum LatencyStage {
+  LATENCY_EDGE,
+  LATENCY_DETECTED,
+  LATENCY_TRIGGERED,
+  LATENCY_SOUND,
+  LATENCY_STAGE_COUNT
+};
+
+enum LatencyInterval {
+  LATENCY_EDGE_TO_DETECTED,
+  LATENCY_DETECTED_TO_TRIGGERED,
+  LATENCY_TRIGGERED_TO_SOUND,
+  LATENCY_EDGE_TO_SOUND,
+  LATENCY_INTERVAL_COUNT
+};
+
+// Timestamp a stage for a voice. An edge only starts a new measurement when
+// none is in flight, so contact bounce keeps the first edge.
+void latencyProbeMark(int voice, LatencyStage stage, uint32_t sampleClock);
+
+// Engine onset hook: the sample that will make the voice audible
+void latencyProbeOnset(int voice, uint32_t sampleClock);
+
+// audioOutput() hook: completes measurements whose onset sample has played
+void latencyProbeOutput(uint32_t sampleClock);
+
+// Percentiles of one interval, in samples
+struct LatencySummary {
+  uint32_t count;
+  uint32_t p50;
+  uint32_t p99;
+  uint32_t max;
+};
+
+void latencyProbeSummary(LatencyInterval interval, LatencySummary& summary);
+
+void latencyProbeReset();
+
+void latencyProbeReport(ReportLineFn emit);
+
+#endif  // LATENCY_PROBE_H
@@ -0,0 +1,27 @@
+/*
+  Level meter ballistics - see level_meter.h
+*/
+
+#include "level_meter.h"
+
+static uint8_t decay(uint8_t value) {
+  return value > METER_DECAY_PER_FRAME ? value - METER_DECAY_PER_FRAME : 0;
+}
+
+bool updateLevelMeter(LevelMeter& meter, uint8_t peak) {
+  LevelMeter before = meter;
+
+  meter.level = peak > meter.level ? peak : decay(meter.level);
+
+  if (peak >= meter.hold) {
+    meter.hold = peak;
+    meter.holdAge = 0;
+  } else if (meter.holdAge < METER_HOLD_FRAMES) {
+    meter.holdAge++;
+  } else {
+    meter.hold = decay(meter.hold);
+    if (meter.hold < meter.level) meter.hold = meter.level;
+  }
+
+  return meter.level != before.level || meter.hold != before.hold;
+}
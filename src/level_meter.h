@@ -0,0 +1,33 @@
+/*
+  Level meter ballistics, run once per display frame.
+
+  Input is a voice's peak since the previous frame (from takeVoicePeaks()),
+  so metering never makes its own pass over sample data. The bar jumps up to
+  new peaks and falls linearly; a peak-hold marker stays put for a while and
+  then falls with the bar.
+*/
+
+#ifndef LEVEL_METER_H
+#define LEVEL_METER_H
+
+#include <Arduino.h>
+
+#define METER_FULL_SCALE 128     // Peak of a full-scale 8-bit sample
+#define METER_DECAY_PER_FRAME 8  // Level lost per display frame
+#define METER_HOLD_FRAMES 20     // Frames the hold marker stays put
+
+struct LevelMeter {
+  uint8_t level;    // Bar, 0..METER_FULL_SCALE
+  uint8_t hold;     // Peak-hold marker
+  uint8_t holdAge;  // Frames since the marker was set
+};
+
+// Advance one display frame. Returns true if the bar or marker moved.
+bool updateLevelMeter(LevelMeter& meter, uint8_t peak);
+
+// Scale a meter value to a bar of at most height pixels
+inline int meterPixels(uint8_t value, int height) {
+  return value * height / METER_FULL_SCALE;
+}
+
+#endif  // LEVEL_METER_H
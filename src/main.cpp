@@ -5,7 +5,7 @@
   Generates a 440Hz sine wave using Mozzi audio library with I2S output
 
   Hardware: RP2040 with PCM5102A I2S DAC
-  I2S Pins: BCK=GPIO26, LCK=GPIO27, DIN=GPIO28
+  I2S Pins: BCK=GPIO20, LCK=GPIO21, DIN=GPIO22
 
   Next: Multi-voice sample playback for drum machine functionality
 */
@@ -16,16 +16,38 @@
 #include <I2S.h>    // For I2S output on RP2040
 #include <Mozzi.h>  // Use Mozzi.h instead of MozziGuts.h for Mozzi 2.0
 #include <Wire.h>
-
-#include "hihat_sample.h"  // Hi-hat sample
-#include "kick_sample.h"   // Kick drum sample
-#include "snare_sample.h"  // Snare drum sample
-#include "tom_sample.h"    // Tom sample
+#include <hardware/irq.h>
+#include <hardware/uart.h>
+#ifdef USE_TINYUSB
+#include <Adafruit_TinyUSB.h>  // USB-MIDI alongside the serial port
+#endif
+
+#include "audio_bench.h"        // Audio hot path benchmarks
+#include "audio_clock.h"        // Rendered/output sample counters
+#include "clock_input.h"        // External clock tracking for the sequencer
+#include "cv_input.h"           // DMA-sampled CVs for pitch, decay, sample
+#include "cycle_counter.h"      // Cycle timing for the audio path
+#include "deferred_log.h"       // Non-blocking logging for the control path
+#include "display_scheduler.h"  // Coalesced, cost-adaptive OLED frames
+#include "dsp_stats.h"          // Render load and underrun statistics
+#include "latency_probe.h"      // Trigger-to-sound latency histograms
+#include "memory_stats.h"       // Stack and memory high-water marks
+#include "midi_input.h"         // MIDI notes to timestamped pad triggers
+#include "oled_flush.h"         // Send only the changed parts of the OLED
+#include "preset_store.h"       // Kit presets in wear-levelled flash
+#include "sample_engine.h"      // Multi-voice sample playback engine
+#include "sequencer.h"          // Sample-accurate internal step sequencer
+#include "serial_protocol.h"    // Framed binary commands from a host
+#include "spectrum.h"           // FFT spectrum of the master output
+#include "trace_ring.h"         // Binary hot-path event trace
+#include "trigger_input.h"      // Button debouncing
+#include "ui_frame.h"           // OLED layout, drawn straight into page format
+#include "xip_stats.h"          // Flash cache hits per voice combination
 
 // I2S configuration for custom pins
-#define I2S_BCK_PIN 26   // Bit clock
-#define I2S_LCK_PIN 27   // Word select (automatically BCK+1 on RP2040)
-#define I2S_DATA_PIN 28  // Data output
+#define I2S_BCK_PIN 20   // Bit clock
+#define I2S_LCK_PIN 21   // Word select (automatically BCK+1 on RP2040)
+#define I2S_DATA_PIN 22  // Data output
 
 // OLED configuration
 #define SCREEN_WIDTH 128  // OLED display width, in pixels
@@ -38,34 +60,42 @@
 #define SDA_PIN 4  // GPIO4 for I2C SDA
 #define SCL_PIN 5  // GPIO5 for I2C SCL
 
+#define DISPLAY_POLL_MS 5  // How often core 1 checks for a new UI state
+#define METER_FRAME_MS 33  // Meter ballistics and playhead frame rate
+#define SPECTRUM_BUDGET_US 250  // Analyzer time per core 1 loop pass
+
 // Button/Trigger input pins (with future eurorack compatibility)
 #define BUTTON_1_PIN 6  // GPIO6 - Sample 1 (Kick)
 #define BUTTON_2_PIN 7  // GPIO7 - Sample 2 (Snare)
 #define BUTTON_3_PIN 8  // GPIO8 - Sample 3 (Hihat)
 #define BUTTON_4_PIN 9  // GPIO9 - Sample 4 (Tom)
 
-// Debounce settings
-#define DEBOUNCE_DELAY 20    // 20ms debounce delay
-#define TRIGGER_MIN_PULSE 5  // Minimum 5ms pulse for eurorack triggers
-
-// Multi-voice sample player structure
-struct SamplePlayer {
-  const int8_t* data;
-  uint32_t length;
-  uint32_t position;
-  bool playing;
-  const char* name;
-};
-
-// Initialize sample players for each drum
-SamplePlayer samplePlayers[4] = {
-    {kick_sample_data, kick_sample_length, 0, false, "Kick"},
-    {snare_sample_data, snare_sample_length, 0, false, "Snare"},
-    {hihat_sample_data, hihat_sample_length, 0, false, "Hihat"},
-    {tom_sample_data, tom_sample_length, 0, false, "Tom"}};
+// MIDI input (receive only, through the usual optocoupler)
+#define MIDI_UART uart0
+#define MIDI_UART_IRQ UART0_IRQ
+#define MIDI_UART_RX_PIN 1  // GPIO1 - UART0 RX
+#define MIDI_BAUD 31250
 
 // Track last triggered sample for display
 int lastTriggeredSample = 0;
+int clockInputPad = -1;  // Pad input used as the external clock, -1 for none
+int cvTargetPad = -1;    // Pad the CV inputs control, -1 for all of them
+UiView displayView = UI_VIEW_PADS;  // Serial 'v' cycles through the views
+
+// Everything the display shows, packed so it crosses cores in one store:
+// bits 0-3 playing voice mask, bits 8-15 last triggered sample, bits 16-23
+// view
+#define UI_STATE(mask, last, view) \
+  ((uint32_t)(mask) | ((uint32_t)(last) << 8) | ((uint32_t)(view) << 16))
+#define UI_STATE_VIEW(state) ((UiView)(((state) >> 16) & 0xFF))
+#define UI_STATE_NONE 0xFFFFFFFFu  // Never published, forces the first draw
+
+// Display handoff: core 0 publishes, core 1 draws and owns the I2C bus
+volatile uint32_t publishedUiState = UI_STATE(0, 0, UI_VIEW_PADS);
+uint32_t seenUiState = UI_STATE_NONE;  // Core 1 only
+LevelMeter meters[NUM_VOICES];         // Core 1 only
+int shownPlayhead = -1;                // Core 1 only
+uint32_t spectrumBudgetCycles = 0;     // Core 1 only
 
 // Create OLED display object
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
@@ -73,18 +103,20 @@ Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, OLED_RESET);
 // I2S output object
 I2S i2s(OUTPUT, I2S_BCK_PIN, I2S_DATA_PIN);
 
+#ifdef USE_TINYUSB
+Adafruit_USBD_MIDI usbMidi;
+#endif
+
 // Control variables
-bool oledWorking = false;  // Track if OLED is functional
-
-// Button/Trigger state tracking
-struct ButtonState {
-  int pin;
-  bool lastState;
-  bool currentState;
-  unsigned long lastDebounceTime;
-  bool triggered;
-  const char* name;
-};
+bool oledWorking = false;  // Track if OLED is functional (core 1)
+char pendingReport = 0;    // Report command for loop() to run, outside Mozzi
+
+// Binary serial protocol state (core 0)
+SerialLink serialLink;
+uint32_t serialCommands = 0;         // Commands run from good frames
+uint32_t serialTriggersDropped = 0;  // Triggers the engine queue refused
+bool statsReplyPending = false;      // Stats frame for loop() to send
+uint32_t serialLastByteMs = 0;       // When the port last had data
 
 // Initialize button states for 4 sample triggers
 ButtonState buttons[4] = {{BUTTON_1_PIN, HIGH, HIGH, 0, false, "Kick"},
@@ -92,11 +124,31 @@ ButtonState buttons[4] = {{BUTTON_1_PIN, HIGH, HIGH, 0, false, "Kick"},
                           {BUTTON_3_PIN, HIGH, HIGH, 0, false, "Hihat"},
                           {BUTTON_4_PIN, HIGH, HIGH, 0, false, "Tom"}};
 
+// Output sample clock of each button's latest press edge, for recording
+volatile uint32_t buttonEdgeClock[4];
+
 // Sample playback state (will expand for multi-voice later)
 int currentSampleIndex = 0;  // Which sample to play (0-3)
 
+// Engine output, rendered AUDIO_BLOCK_SIZE samples at a time
+int8_t audioBlock[AUDIO_BLOCK_SIZE];
+int audioBlockPosition = AUDIO_BLOCK_SIZE;  // Start empty
+
+#define STATS_REPLY_BYTES 28
+
 // Forward declarations
-void updateDisplay();
+void composeDisplay(uint32_t uiState);
+
+// Report sink for the shared diagnostic modules
+void serialReportLine(const char* line) { Serial.println(line); }
+
+// Deferred log transport: only write when the whole line fits right now
+bool serialLogWrite(const char* line, size_t length) {
+  if (Serial.availableForWrite() < (int)length + 2) return false;
+  Serial.write((const uint8_t*)line, length);
+  Serial.write((const uint8_t*)"\r\n", 2);
+  return true;
+}
 
 // Required audioOutput function for Mozzi 2.0 external audio mode
 void audioOutput(const AudioOutput f) {
@@ -104,39 +156,49 @@ void audioOutput(const AudioOutput f) {
   int16_t sample =
       f.l();  // Get the left channel sample from Mozzi (note the parentheses)
 
+  // Nothing left that updateAudio() rendered: the DAC is being starved
+  if (audioSamplesBuffered() <= 0) {
+    dspStatsRecordUnderrun();
+    traceEvent(TRACE_UNDERRUN);
+  }
+  latencyProbeOutput(audioSamplesOutput);
+  audioSamplesOutput++;
+
   // Write stereo samples (same sample for both channels)
   i2s.write16(sample, sample);
 }
 
+// Pin interrupt: timestamp the raw edge for the latency probes, or for the
+// clock tracker when the input is the external clock
+void buttonEdgeInterrupt(void* param) {
+  int pad = (int)(intptr_t)param;
+  traceEvent(TRACE_EDGE, (uint8_t)pad);
+  if (pad == clockInputPad) {
+    clockInputEdge(audioSamplesOutput);
+    return;
+  }
+  latencyProbeMark(pad, LATENCY_EDGE, audioSamplesOutput);
+  buttonEdgeClock[pad] = audioSamplesOutput;
+}
+
+// MIDI UART receive interrupt: parse each byte the moment it arrives
+void midiUartInterrupt() {
+  while (uart_is_readable(MIDI_UART)) {
+    midiInputByte(MIDI_PORT_UART, uart_getc(MIDI_UART), audioSamplesOutput);
+  }
+}
+
 // Button debouncing and trigger detection
 void updateButtons() {
   for (int i = 0; i < 4; i++) {
-    int reading = digitalRead(buttons[i].pin);
+    if (i == clockInputPad) continue;  // Pulses go to the clock tracker
 
-    // Check if button state changed (for debouncing)
-    if (reading != buttons[i].lastState) {
-      buttons[i].lastDebounceTime = millis();
-    }
+    int reading = digitalRead(buttons[i].pin);
 
-    // If enough time has passed since last state change
-    if ((millis() - buttons[i].lastDebounceTime) > DEBOUNCE_DELAY) {
-      // If the button state has actually changed
-      if (reading != buttons[i].currentState) {
-        buttons[i].currentState = reading;
-
-        // Trigger on falling edge (button press) - active LOW with pullup
-        if (buttons[i].currentState == LOW) {
-          buttons[i].triggered = true;
-          Serial.print("Button ");
-          Serial.print(i + 1);
-          Serial.print(" (");
-          Serial.print(buttons[i].name);
-          Serial.println(") triggered!");
-        }
-      }
+    if (debounceButton(buttons[i], reading, millis())) {
+      latencyProbeMark(i, LATENCY_DETECTED, audioSamplesOutput);
+      logMessage(LOG_BUTTON_TRIGGERED, i + 1, (intptr_t)buttons[i].name);
     }
-
-    buttons[i].lastState = reading;
   }
 }
 
@@ -147,70 +209,70 @@ void processButtonTriggers() {
       buttons[i].triggered = false;  // Clear trigger flag
 
       // Trigger the corresponding sample
-      samplePlayers[i].position = 0;
-      samplePlayers[i].playing = true;
+      traceEvent(TRACE_TRIGGER, i, TRACE_SOURCE_BUTTON);
+      triggerSample(i);
+      latencyProbeMark(i, LATENCY_TRIGGERED, audioSamplesOutput);
       lastTriggeredSample = i;
 
-      Serial.print("Playing ");
-      Serial.print(samplePlayers[i].name);
-      Serial.print(" (Button ");
-      Serial.print(i + 1);
-      Serial.println(")");
+      // Record at the press, heard against the sequencer's output
+      sequencerRecord(i, buttonEdgeClock[i], VELOCITY_MAX);
 
-      // Update display if OLED is working
-      if (oledWorking) {
-        updateDisplay();
-      }
+      logMessage(LOG_PLAYING, (intptr_t)samplePlayers[i].name, i + 1);
     }
   }
 }
 
-// Display functions
-void updateDisplay() {
-  display.clearDisplay();
-  display.setTextSize(1);
-  display.setTextColor(SSD1306_WHITE);
-  display.setCursor(0, 0);
+// Hand the current UI state to core 1. Never waits: if a frame is still
+// being sent, core 1 picks up the newest state when it is done.
+void publishUiState() {
+  publishedUiState =
+      UI_STATE(activeSampleMask(), lastTriggeredSample, displayView);
+}
 
-  // Title
-  display.println("Pico DAC Sampler");
+// Display functions (core 1)
 
-  // Show playing samples
-  bool anyPlaying = false;
-  for (int i = 0; i < 4; i++) {
-    if (samplePlayers[i].playing) {
-      anyPlaying = true;
-      break;
-    }
-  }
+// Overview column under the last triggered pad's playhead
+int currentPlayhead(uint32_t uiState) {
+  return wavePlayheadColumn((uiState >> 8) & 0xFF);
+}
 
-  if (anyPlaying) {
-    display.println("Playing:");
-    for (int i = 0; i < 4; i++) {
-      if (samplePlayers[i].playing) {
-        display.print(samplePlayers[i].name);
-        display.print(" ");
-      }
-    }
-    display.println();
-  } else {
-    display.println("Ready");
-    display.print("Last: ");
-    display.println(samplePlayers[lastTriggeredSample].name);
+// Draw the UI into the framebuffer; oledFlush() sends it
+void composeDisplay(uint32_t uiState) {
+  if (UI_STATE_VIEW(uiState) == UI_VIEW_SPECTRUM) {
+    composeSpectrumFrame(display.getBuffer(), spectrumBars());
+    return;
   }
 
-  display.display();
+  int last = (uiState >> 8) & 0xFF;
+  shownPlayhead = currentPlayhead(uiState);
+
+  UiFrameState frame;
+  frame.playingMask = uiState & 0xFF;
+  frame.lastName = samplePlayers[last].name;
+  frame.wave = waveOverview(last);
+  frame.playhead = shownPlayhead;
+  frame.meters = meters;
+  composeUiFrame(display.getBuffer(), frame);
 }
 
 void setup() {
+  // Paint the stack before anything deep runs, for the high-water mark
+  paintCurrentStack();
+
+#ifdef USE_TINYUSB
+  usbMidi.begin();  // Before Serial, so the host sees both interfaces
+#endif
   Serial.begin(115200);
   delay(500);
 
   Serial.println("Pico DAC Sampler Starting...");
+  serialLinkReset(serialLink);
 
   // Initialize button pins with internal pull-up resistors
   for (int i = 0; i < 4; i++) {
     pinMode(buttons[i].pin, INPUT_PULLUP);
+    attachInterruptParam(digitalPinToInterrupt(buttons[i].pin),
+                         buttonEdgeInterrupt, FALLING, (void*)(intptr_t)i);
     Serial.print("Initialized button ");
     Serial.print(i + 1);
     Serial.print(" (");
@@ -219,6 +281,85 @@ void setup() {
     Serial.println(buttons[i].pin);
   }
 
+  // MIDI in. With the FIFO off every byte interrupts as it completes, so
+  // notes are stamped on arrival rather than at a FIFO threshold.
+  uart_init(MIDI_UART, MIDI_BAUD);
+  gpio_set_function(MIDI_UART_RX_PIN, GPIO_FUNC_UART);
+  uart_set_fifo_enabled(MIDI_UART, false);
+  irq_set_exclusive_handler(MIDI_UART_IRQ, midiUartInterrupt);
+  irq_set_enabled(MIDI_UART_IRQ, true);
+  uart_set_irq_enables(MIDI_UART, true, false);
+
+  // CV inputs: the ADC and a DMA channel run on their own from here
+  cvInputBegin();
+
+  // Index the preset log (formats it on first boot, before audio starts)
+  if (!presetStoreBegin()) {
+    Serial.println("No flash set aside for presets, saving disabled");
+  }
+
+  // Initialize I2S with 16-bit samples
+  i2s.setBitsPerSample(16);
+
+  // Start I2S at the configured sample rate
+  if (!i2s.begin(MOZZI_AUDIO_RATE)) {
+    Serial.println("Failed to initialize I2S!");
+    while (1);  // Stop execution
+  }
+
+  // Report when each triggered voice becomes audible
+  setVoiceOnsetHandler(latencyProbeOnset);
+
+  // Per-block cycle budget for the load statistics
+  readCycleCounter();  // Make sure the counter is running
+  dspStatsBegin(cycleCounterHz() / MOZZI_AUDIO_RATE * AUDIO_BLOCK_SIZE);
+
+  // Initialize Mozzi (will use external audio output via audioOutput function)
+  startMozzi();
+
+  Serial.println("Pico DAC Sampler initialized - 4-button drum machine!");
+  Serial.println("Commands:");
+  Serial.println("  SPACE: Trigger sample via serial");
+  Serial.println("  b: Run audio benchmarks (interrupts audio)");
+  Serial.println("  s: DSP load and underrun statistics (CSV)");
+  Serial.println("  l: Trigger latency histogram (CSV)");
+  Serial.println("  t: Dump the hot-path event trace (hex)");
+  Serial.println("  m: Stack, static and heap memory usage (CSV)");
+  Serial.println("  x: XIP flash cache hits by playing voices (CSV)");
+  Serial.println("  d: Display frame rate and cost (CSV)");
+  Serial.println("  v: Switch the display between pads and spectrum");
+  Serial.println("  p: Start/stop the step sequencer");
+  Serial.println("  +/-: Sequencer tempo up/down 5 BPM");
+  Serial.println("  w: Sequencer swing (50, 58, 66, 74%)");
+  Serial.println("  n: Sequencer pattern length (16, 32, 64 steps)");
+  Serial.println("  r: Record button and trigger hits into the pattern");
+  Serial.println("  q: Record grid (1, 2, 4 steps)");
+  Serial.println("  e: Erase the pattern");
+  Serial.println("  c: External clock input (off, button 1-4)");
+  Serial.println("  k: External clock ratio (x1, x2, x4, /2, /4, /6)");
+  Serial.println("  a: Pads the CV inputs control (all, pad 1-4)");
+  Serial.println("  Binary frames: see tools/sampler_link.py");
+  Serial.println("Hardware Buttons:");
+  Serial.println("  Button 1 (GPIO6): Kick sample");
+  Serial.println("  Button 2 (GPIO7): Snare sample");
+  Serial.println("  Button 3 (GPIO8): Hihat sample");
+  Serial.println("  Button 4 (GPIO9): Tom sample");
+  Serial.println("Ready for button triggers...");
+
+  // Show the initial state once core 1 has the display up
+  publishUiState();
+}
+
+// Core 1 runs the display, so I2C transfers never hold up audio or control
+void setup1() {
+  paintCurrentStack();
+
+  // The only time the display reads sample data
+  buildWaveOverviews();
+
+  readCycleCounter();  // Make sure this core's counter is running too
+  spectrumBudgetCycles = cycleCounterHz() / 1000000 * SPECTRUM_BUDGET_US;
+
   // Initialize I2C for OLED
   Wire.setSDA(SDA_PIN);
   Wire.setSCL(SCL_PIN);
@@ -237,33 +378,269 @@ void setup() {
     display.println("Pico DAC Sampler");
     display.println("Initializing...");
     display.display();
+    oledFlushBegin(display, Wire, SCREEN_ADDRESS);
+    oledWorking = true;
     delay(1000);
   }
+}
 
-  // Initialize I2S with 16-bit samples
-  i2s.setBitsPerSample(16);
+// Advance the meters from the peaks the renderer collected since last time
+bool updateMeters() {
+  uint8_t peaks[NUM_VOICES];
+  takeVoicePeaks(peaks);
 
-  // Start I2S at the configured sample rate
-  if (!i2s.begin(MOZZI_AUDIO_RATE)) {
-    Serial.println("Failed to initialize I2S!");
-    while (1);  // Stop execution
+  bool moved = false;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    moved |= updateLevelMeter(meters[i], peaks[i]);
   }
+  return moved;
+}
 
-  // Initialize Mozzi (will use external audio output via audioOutput function)
-  startMozzi();
+void loop1() {
+  displaySchedulerService();
 
-  Serial.println("Pico DAC Sampler initialized - 4-button drum machine!");
-  Serial.println("Commands:");
-  Serial.println("  SPACE: Trigger sample via serial");
-  Serial.println("Hardware Buttons:");
-  Serial.println("  Button 1 (GPIO6): Kick sample");
-  Serial.println("  Button 2 (GPIO7): Snare sample");
-  Serial.println("  Button 3 (GPIO8): Hihat sample");
-  Serial.println("  Button 4 (GPIO9): Tom sample");
-  Serial.println("Ready for button triggers...");
+  uint32_t uiState = publishedUiState;
+  if (uiState != seenUiState) {
+    seenUiState = uiState;
+    displayMarkDirty();
+  }
+
+  // Meters and playhead animate at a fixed rate, whatever the frame rate
+  static unsigned long lastMeterFrame = 0;
+  if (millis() - lastMeterFrame >= METER_FRAME_MS) {
+    bool moved = updateMeters();
+    moved |= currentPlayhead(uiState) != shownPlayhead;
+    if (moved) displayMarkDirty();
+    lastMeterFrame = millis();
+  }
+
+  // The analyzer gets a slice per pass, so a frame's FFT never holds up
+  // redraws for new triggers
+  if (UI_STATE_VIEW(uiState) == UI_VIEW_SPECTRUM &&
+      spectrumStep(spectrumBudgetCycles)) {
+    displayMarkDirty();
+  }
+
+  // Everything that changed since the last frame goes out in one frame
+  if (oledWorking && displayFrameDue(millis())) {
+    uint32_t start = micros();
+    composeDisplay(uiState);
+    uint32_t composed = micros();
+    oledFlush();
+    uint32_t flushed = micros();
+
+    displayFrameDone(composed - start, flushed - composed, millis());
+  }
+  delay(DISPLAY_POLL_MS);
+}
+
+// One-key serial commands, typed outside any binary frame
+void handleKey(char input) {
+  switch (input) {
+    case ' ':  // Spacebar to trigger last sample
+      traceEvent(TRACE_TRIGGER, lastTriggeredSample, TRACE_SOURCE_SERIAL);
+      triggerSample(lastTriggeredSample);
+      latencyProbeMark(lastTriggeredSample, LATENCY_TRIGGERED,
+                       audioSamplesOutput);
+      sequencerRecord(lastTriggeredSample, audioSamplesOutput, VELOCITY_MAX);
+      logMessage(LOG_SERIAL_TRIGGER,
+                 (intptr_t)samplePlayers[lastTriggeredSample].name);
+      break;
+    case 'p':  // Start/stop the sequencer
+      if (sequencerRunning()) {
+        sequencerStop();
+      } else {
+        // Start on the block after the next one, so step 0 isn't late
+        sequencerStart(engineSampleClock() + 2 * AUDIO_BLOCK_SIZE);
+      }
+      logMessage(LOG_SEQUENCER_STATE,
+                 (intptr_t)(sequencerRunning() ? "running" : "stopped"));
+      break;
+    case '+':  // Sequencer tempo up/down
+    case '-':
+      sequencerSetTempo(sequencerTempo() + (input == '+' ? 5 : -5));
+      logMessage(LOG_SEQUENCER_SETTING, (intptr_t)"tempo", sequencerTempo());
+      break;
+    case 'w':  // Cycle swing: straight, light, triplet, hard
+      sequencerSetSwing(sequencerSwing() + 8 > SEQ_SWING_MAX
+                            ? SEQ_SWING_STRAIGHT
+                            : sequencerSwing() + 8);
+      logMessage(LOG_SEQUENCER_SETTING, (intptr_t)"swing", sequencerSwing());
+      break;
+    case 'n':  // Cycle pattern length: 16, 32, 64 steps
+      if (sequencerPattern.length >= SEQ_MAX_STEPS) {
+        sequencerPattern.length = 16;
+      } else {
+        sequencerPattern.length *= 2;
+      }
+      logMessage(LOG_SEQUENCER_SETTING, (intptr_t)"steps",
+                 sequencerPattern.length);
+      break;
+    case 'r':  // Record live hits into the pattern on/off
+      sequencerSetRecording(!sequencerRecording());
+      logMessage(LOG_SEQUENCER_STATE,
+                 (intptr_t)(sequencerRecording() ? "recording" : "playing"));
+      break;
+    case 'q':  // Cycle the record grid: 1/16, 1/8, 1/4
+      sequencerSetRecordGrid(sequencerRecordGrid() >= SEQ_GRID_MAX
+                                 ? 1
+                                 : sequencerRecordGrid() * 2);
+      logMessage(LOG_SEQUENCER_SETTING, (intptr_t)"grid",
+                 sequencerRecordGrid());
+      break;
+    case 'e':  // Erase the pattern, to record from scratch
+      memset(sequencerPattern.steps, 0, sizeof sequencerPattern.steps);
+      memset(sequencerPattern.velocity, 0, sizeof sequencerPattern.velocity);
+      logMessage(LOG_SEQUENCER_STATE, (intptr_t)"erased");
+      break;
+    case 'c':  // Next clock input: off, pad 1-4
+      clockInputPad++;
+      if (clockInputPad == NUM_VOICES) clockInputPad = -1;
+      clockInputReset();
+      if (clockInputPad < 0) {
+        sequencerSetTempo(sequencerTempo());  // Back to the internal tempo
+      }
+      logMessage(LOG_CLOCK_SETTING, (intptr_t)"input",
+                 (intptr_t)(clockInputPad < 0
+                                ? "off"
+                                : samplePlayers[clockInputPad].name));
+      break;
+    case 'k':  // Next clock multiply/divide ratio
+      clockInputSetRatio((clockInputRatio() + 1) % CLOCK_RATIO_COUNT);
+      logMessage(LOG_CLOCK_SETTING, (intptr_t)"ratio",
+                 (intptr_t)clockRatios[clockInputRatio()].name);
+      break;
+    case 'a':  // Next CV target: all pads, then pad 1-4
+      cvTargetPad++;
+      if (cvTargetPad == NUM_VOICES) cvTargetPad = -1;
+      cvInputSetTarget(cvTargetPad < 0 ? (1 << NUM_VOICES) - 1
+                                       : 1 << cvTargetPad);
+      logMessage(LOG_CV_TARGET,
+                 (intptr_t)(cvTargetPad < 0 ? "all pads"
+                                            : buttons[cvTargetPad].name));
+      break;
+    case 'v':  // Next display view
+      displayView = (UiView)((displayView + 1) % UI_VIEW_COUNT);
+      break;
+    case 'b':  // Benchmark the audio hot path
+    case 's':  // Render load, underruns and voice high-water mark
+    case 'l':  // Trigger-to-sound latency percentiles
+    case 't':  // Flight recorder of recent hot-path events
+    case 'm':  // Stack high-water marks and memory usage
+    case 'x':  // Flash cache behaviour of sample playback
+    case 'd':  // Display frame rate and cost
+      // Printed from loop(), never from here; one report at a time, since
+      // the trace and display reports take several passes
+      if (!pendingReport) pendingReport = input;
+      break;
+    default:
+      // Ignore other input
+      break;
+  }
+}
 
-  // Update display with initial state
-  updateDisplay();
+// Commands from a good binary frame, in order
+void handleCommand(const SerialCommand& command) {
+  serialCommands++;
+  int voice = command.detail;
+  int32_t value = (int32_t)command.value;
+
+  switch (command.opcode) {
+    case SERIAL_CMD_TRIGGER:
+      if (command.target >= NUM_VOICES) break;
+      // A trigger the full queue turned away never sounds, so it is
+      // neither shown nor recorded into the pattern
+      if (!scheduleTrigger(command.target, command.value, command.detail)) {
+        serialTriggersDropped++;
+        break;
+      }
+      lastTriggeredSample = command.target;
+      sequencerRecord(command.target, command.value, command.detail);
+      break;
+    case SERIAL_CMD_STATS:
+      statsReplyPending = true;  // Sent from loop() when the port has room
+      break;
+    case SERIAL_CMD_SET:
+      switch (command.target) {
+        case SERIAL_PARAM_TEMPO:
+          sequencerSetTempo(value);
+          break;
+        case SERIAL_PARAM_SWING:
+          sequencerSetSwing(value);
+          break;
+        case SERIAL_PARAM_STEPS:
+          if (value == 16 || value == 32 || value == 64) {
+            sequencerPattern.length = value;
+          }
+          break;
+        case SERIAL_PARAM_RUNNING:
+          if (value && !sequencerRunning()) {
+            sequencerStart(engineSampleClock() + 2 * AUDIO_BLOCK_SIZE);
+          } else if (!value && sequencerRunning()) {
+            sequencerStop();
+          }
+          break;
+        case SERIAL_PARAM_PITCH:
+          setVoicePitch(voice, value);
+          break;
+        case SERIAL_PARAM_DECAY:
+          setVoiceDecay(voice, value);
+          break;
+        case SERIAL_PARAM_SAMPLE:
+          setVoiceSample(voice, value);
+          break;
+        case SERIAL_PARAM_CV_TARGET:
+          cvInputSetTarget(value & ((1 << NUM_VOICES) - 1));
+          break;
+        case SERIAL_PARAM_LEVEL:
+          setVoiceLevel(voice, value);
+          break;
+        case SERIAL_PARAM_PRESET:
+          presetRecall(value);
+          break;
+        case SERIAL_PARAM_PRESET_SAVE:
+          presetSave(value);  // Written from loop(), a page at a time
+          break;
+        case SERIAL_PARAM_RECORD:
+          sequencerSetRecording(value);
+          break;
+        case SERIAL_PARAM_RECORD_GRID:
+          sequencerSetRecordGrid(value);
+          break;
+      }
+      break;
+  }
+}
+
+static void putU32(uint8_t* out, uint32_t value) {
+  out[0] = value;
+  out[1] = value >> 8;
+  out[2] = value >> 16;
+  out[3] = value >> 24;
+}
+
+// Answer a stats query, only once the whole frame fits in the USB buffer
+bool sendStatsReply() {
+  uint8_t frame[SERIAL_ENCODED_MAX(STATS_REPLY_BYTES)];
+  if (Serial.availableForWrite() < (int)sizeof(frame)) return false;
+
+  DspStatsSnapshot dsp;
+  dspStatsTakeSnapshot(dsp);
+  uint8_t payload[STATS_REPLY_BYTES];
+  payload[0] = SERIAL_REPLY_STATS;
+  putU32(payload + 1, engineSampleClock());
+  putU32(payload + 5, serialLink.framesOk);
+  putU32(payload + 9, serialLink.framesBad);
+  putU32(payload + 13, serialCommands);
+  putU32(payload + 17, serialTriggersDropped);
+  payload[21] = dsp.loadPercentX10;
+  payload[22] = dsp.loadPercentX10 >> 8;
+  putU32(payload + 23, dsp.underruns);
+  payload[27] = activeSampleMask();
+
+  size_t length = serialEncodeFrame(payload, sizeof(payload), frame);
+  Serial.write(frame, length);
+  return true;
 }
 
 void updateControl() {
@@ -274,77 +651,122 @@ void updateControl() {
   updateButtons();
   processButtonTriggers();
 
-  // Check for serial input
-  if (Serial.available()) {
-    char input = Serial.read();
-
-    switch (input) {
-      case ' ':  // Spacebar to trigger last sample
-        samplePlayers[lastTriggeredSample].position = 0;
-        samplePlayers[lastTriggeredSample].playing = true;
-        Serial.print("Sample triggered via spacebar: ");
-        Serial.println(samplePlayers[lastTriggeredSample].name);
-        updateDisplay();
-        break;
-      default:
-        // Ignore other input
-        break;
+  // Drain every received byte: binary frames and one-key commands
+  uint32_t now = millis();
+  while (Serial.available()) {
+    serialLastByteMs = now;
+    uint8_t byte = Serial.read();
+    SerialEvent event = serialLinkByte(serialLink, byte);
+    if (event == SERIAL_KEY) {
+      handleKey(byte);
+    } else if (event == SERIAL_FRAME) {
+      SerialCommand command;
+      while (serialNextCommand(serialLink, command)) handleCommand(command);
     }
   }
+
+  // Quiet since a frame: anything held after it was typed, not framed
+  if (now - serialLastByteMs >= SERIAL_KEY_GAP_MS) {
+    int keys = serialLinkIdle(serialLink);
+    for (int i = 0; i < keys; i++) handleKey(serialLink.buffer[i]);
+  }
+
+  // Latest triggers and finished voices, for the display core
+  publishUiState();
 }
 
 AudioOutput updateAudio() {
   // This function is called at AUDIO_RATE (16384Hz)
   // Return the next audio sample as AudioOutput
 
-  int16_t mixedSample = 0;  // Use 16-bit for mixing to prevent overflow
-
-  // Mix all playing samples
-  for (int i = 0; i < 4; i++) {
-    if (samplePlayers[i].playing &&
-        samplePlayers[i].position < samplePlayers[i].length) {
-      // Read sample from PROGMEM and add to mix
-      int8_t sample =
-          pgm_read_byte(&samplePlayers[i].data[samplePlayers[i].position]);
-      mixedSample += sample;
-      samplePlayers[i].position++;
-    } else if (samplePlayers[i].playing) {
-      // Sample finished playing
-      samplePlayers[i].playing = false;
+  // Render a new block once the previous one has been handed out
+  if (audioBlockPosition >= AUDIO_BLOCK_SIZE) {
+    // MIDI notes go into the engine a fixed delay after they arrived
+#ifdef USE_TINYUSB
+    while (usbMidi.available()) {
+      midiInputByte(MIDI_PORT_USB, usbMidi.read(), audioSamplesOutput);
+    }
+#endif
+    int midiPad = midiInputSchedule();
+    if (midiPad >= 0) lastTriggeredSample = midiPad;
+
+    // Lock to the external clock, then queue sequencer steps for this
+    // block and the next one
+    if (clockInputPad >= 0) {
+      ClockEvent event = clockInputUpdate(audioSamplesOutput);
+      if (event != CLOCK_NO_CHANGE) {
+        logMessage(LOG_SEQUENCER_STATE,
+                   (intptr_t)(event == CLOCK_STARTED ? "following the clock"
+                                                     : "stopped, no clock"));
+      }
     }
+    sequencerSchedule(engineSampleClock() + 2 * AUDIO_BLOCK_SIZE);
+
+    // Pitch, decay and sample select from the CVs, once per block
+    cvInputUpdate();
+
+    uint8_t voices = activeSampleMask();
+    xipStatsBlockBegin();
+    uint32_t start = readCycleCounter();
+    renderBlock(audioBlock, AUDIO_BLOCK_SIZE);
+    uint32_t cycles = readCycleCounter() - start;
+    xipStatsBlockEnd(voices);
+    dspStatsRecordBlock(cycles, activeSampleCount());
+    spectrumCapture(audioBlock, AUDIO_BLOCK_SIZE);
+    audioBlockPosition = 0;
   }
 
-  // Clamp mixed sample to 8-bit range and convert
-  mixedSample = max(-128, min(127, mixedSample));
-
-  return MonoOutput::from8Bit((int8_t)mixedSample);
+  audioSamplesRendered++;
+  return MonoOutput::from8Bit(audioBlock[audioBlockPosition++]);
 }
 
 void loop() {
   // audioHook() must be called regularly for Mozzi to work
   audioHook();
 
-  // Update display periodically to show sample progress
-  static unsigned long lastDisplayUpdate = 0;
-  if (millis() - lastDisplayUpdate > 100) {  // Every 100ms
-    // Check if any samples are playing
-    bool anyPlaying = false;
-    for (int i = 0; i < 4; i++) {
-      if (samplePlayers[i].playing) {
-        anyPlaying = true;
-        break;
-      }
-    }
-    if (anyPlaying) {
-      updateDisplay();  // Update display when samples are playing
-    }
-    lastDisplayUpdate = millis();
+  // Reports print a lot (and benchmarks stall audio), so they run here
+  // rather than in updateControl()
+  bool reportDone = true;
+  switch (pendingReport) {
+    case 'b':
+      runAudioBenchmarks(serialReportLine);
+      break;
+    case 's':
+      dspStatsReport(serialReportLine);
+      break;
+    case 'l':
+      latencyProbeReport(serialReportLine);
+      break;
+    case 't':
+      // A few lines per pass, as the port has room
+      reportDone = traceDump(serialLogWrite);
+      break;
+    case 'm':
+      memoryStatsReport(serialReportLine);
+      break;
+    case 'x':
+      xipStatsReport(serialReportLine);
+      break;
+    case 'd':
+      // Stays pending until core 1 hands its counters over
+      reportDone = displaySchedulerReport(serialReportLine);
+      break;
   }
+  if (reportDone) pendingReport = 0;
+
+  if (statsReplyPending && sendStatsReply()) statsReplyPending = false;
+
+  // Preset flash writes, one operation per pass. A sector erase stalls
+  // audio for ~45 ms, so it waits for silence.
+  presetStoreService(!anySamplePlaying() && !sequencerRunning());
 
   // Optional: Print status occasionally
   static unsigned long lastPrint = 0;
   if (millis() - lastPrint > 5000) {  // Every 5 seconds
-    Serial.println("Pico DAC Sampler - Ready for button triggers");
+    logMessage(LOG_STATUS);
     lastPrint = millis();
   }
+
+  // Send queued log messages while the USB host is reading, never block
+  logFlush(serialLogWrite);
 }
@@ -0,0 +1,87 @@
+/*
+  Stack and memory high-water instrumentation - see memory_stats.h
+*/
+
+#include "memory_stats.h"
+
+#include <pico/platform.h>
+#include <stdio.h>
+
+// Linker script symbols (pico-sdk memmap_default.ld)
+extern uint32_t __StackBottom;
+extern uint32_t __StackTop;
+extern uint32_t __StackOneBottom;
+extern uint32_t __StackOneTop;
+extern uint32_t __data_start__;
+extern uint32_t __data_end__;
+extern uint32_t __bss_start__;
+extern uint32_t __bss_end__;
+
+#define RP2040_RAM_SIZE (264 * 1024)
+
+static inline uint32_t* currentStackPointer() {
+  uint32_t* sp;
+  asm volatile("mov %0, sp" : "=r"(sp));
+  return sp;
+}
+
+static void stackBounds(int core, uint32_t*& bottom, uint32_t*& top) {
+  bottom = core == 0 ? &__StackBottom : &__StackOneBottom;
+  top = core == 0 ? &__StackTop : &__StackOneTop;
+}
+
+static void paintStack(uint32_t* bottom, uint32_t* end) {
+  for (uint32_t* p = bottom; p < end; p++) {
+    *p = STACK_PAINT_PATTERN;
+  }
+}
+
+void paintCurrentStack() {
+  uint32_t *bottom, *top;
+  stackBounds(get_core_num(), bottom, top);
+
+  uint32_t* end = currentStackPointer() - STACK_PAINT_MARGIN / 4;
+  if (end > bottom && end <= top) paintStack(bottom, end);
+}
+
+uint32_t stackHighWater(int core, uint32_t& stackSize) {
+  uint32_t *bottom, *top;
+  stackBounds(core, bottom, top);
+  stackSize = (top - bottom) * 4;
+
+  // The stack grows down, so the first overwritten word from the bottom up
+  // marks the deepest point reached
+  uint32_t* p = bottom;
+  while (p < top && *p == STACK_PAINT_PATTERN) p++;
+  return (top - p) * 4;
+}
+
+static void emitRegion(ReportLineFn emit, const char* name, uint32_t size,
+                       uint32_t used) {
+  char line[80];
+  uint32_t percentX10 = size ? (uint32_t)((uint64_t)used * 1000 / size) : 0;
+  snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu.%lu", name,
+           (unsigned long)size, (unsigned long)used,
+           (unsigned long)(size - used), (unsigned long)(percentX10 / 10),
+           (unsigned long)(percentX10 % 10));
+  emit(line);
+}
+
+void memoryStatsReport(ReportLineFn emit) {
+  char line[48];
+  snprintf(line, sizeof(line), "# memory,ram=%d", RP2040_RAM_SIZE);
+  emit(line);
+  emit("region,size,used,free,used_pct");
+
+  for (int core = 0; core < 2; core++) {
+    uint32_t size;
+    uint32_t used = stackHighWater(core, size);
+    emitRegion(emit, core == 0 ? "core0_stack" : "core1_stack", size, used);
+  }
+
+  uint32_t dataSize = (uint8_t*)&__data_end__ - (uint8_t*)&__data_start__;
+  uint32_t bssSize = (uint8_t*)&__bss_end__ - (uint8_t*)&__bss_start__;
+  emitRegion(emit, "static", RP2040_RAM_SIZE, dataSize + bssSize);
+
+  emitRegion(emit, "heap", rp2040.getTotalHeap(), rp2040.getUsedHeap());
+}
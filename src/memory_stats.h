@@ -0,0 +1,40 @@
+/*
+  Stack and memory high-water instrumentation (RP2040 only).
+
+  Both core stacks are painted with a known pattern at startup; the deepest
+  word that no longer holds the pattern is the stack high-water mark. Stack
+  regions come from the pico-sdk linker script (SCRATCH_Y for core0,
+  SCRATCH_X for core1).
+
+  Report (serial 'm' command):
+    # memory,ram=<bytes>
+    region,size,used,free,used_pct
+    core0_stack,...   high-water since boot
+    core1_stack,...   high-water since boot
+    static,...        .data + .bss
+    heap,...          current heap usage
+
+  For the static buffers behind the "static" line, see the build-time report
+  from tools/memory_report.py.
+*/
+
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <Arduino.h>
+
+#include "report.h"
+
+#define STACK_PAINT_PATTERN 0xA5A5A5A5u
+#define STACK_PAINT_MARGIN 64  // Bytes left unpainted below the live SP
+
+// Paint the calling core's stack below its current stack pointer. Call
+// first thing in setup() (core0) and setup1() (core1).
+void paintCurrentStack();
+
+// Deepest stack use seen so far for a core, in bytes
+uint32_t stackHighWater(int core, uint32_t& stackSize);
+
+void memoryStatsReport(ReportLineFn emit);
+
+#endif  // MEMORY_STATS_H
@@ -0,0 +1,91 @@
+/*
+  MIDI note input - see midi_input.h
+*/
+
+#include "midi_input.h"
+
+#include "sequencer.h"
+#include "trace_ring.h"
+
+struct MidiNote {
+  uint32_t sampleClock;  // Arrival of the message's last byte
+  uint8_t pad;
+  uint8_t velocity;
+};
+
+struct MidiPort {
+  MidiParser parser;
+  MidiNote queue[MIDI_EVENT_QUEUE];
+  volatile uint32_t head;  // Written by the receiving context
+  uint32_t tail;           // Written by midiInputSchedule()
+};
+
+static MidiPort midiPorts[MIDI_PORTS];
+
+int midiNotePad(uint8_t note) {
+  switch (note) {
+    case 35:  // Acoustic bass drum
+    case 36:  // Bass drum 1
+      return 0;
+    case 37:  // Side stick
+    case 38:  // Acoustic snare
+    case 39:  // Hand clap
+    case 40:  // Electric snare
+      return 1;
+    case 42:  // Closed hi-hat
+    case 44:  // Pedal hi-hat
+    case 46:  // Open hi-hat
+      return 2;
+    case 41:  // Low floor tom
+    case 43:  // High floor tom
+    case 45:  // Low tom
+    case 47:  // Low-mid tom
+    case 48:  // Hi-mid tom
+    case 50:  // High tom
+      return 3;
+    default:
+      return -1;
+  }
+}
+
+bool midiNoteTrigger(const MidiMessage& message, int& pad, uint8_t& velocity) {
+  // Note-on with velocity 0 is a note-off
+  if (midiType(message) != MIDI_NOTE_ON || message.data[1] == 0) return false;
+  if (MIDI_CHANNEL != 0 && midiChannel(message) != MIDI_CHANNEL) return false;
+
+  pad = midiNotePad(message.data[0]);
+  velocity = message.data[1];
+  return pad >= 0;
+}
+
+void midiInputByte(int port, uint8_t byte, uint32_t sampleClock) {
+  MidiPort& p = midiPorts[port];
+  MidiMessage message;
+  if (!midiParse(p.parser, byte, message)) return;
+
+  int pad;
+  uint8_t velocity;
+  if (!midiNoteTrigger(message, pad, velocity)) return;
+
+  traceEvent(TRACE_MIDI_NOTE, pad, velocity);
+  uint32_t head = p.head;
+  if (head - p.tail >= MIDI_EVENT_QUEUE) return;  // Audio path stalled
+  p.queue[head % MIDI_EVENT_QUEUE] = {sampleClock, (uint8_t)pad, velocity};
+  p.head = head + 1;
+}
+
+int midiInputSchedule() {
+  int lastPad = -1;
+  for (int port = 0; port < MIDI_PORTS; port++) {
+    MidiPort& p = midiPorts[port];
+    while (p.tail != p.head) {
+      const MidiNote& note = p.queue[p.tail % MIDI_EVENT_QUEUE];
+      scheduleTrigger(note.pad, note.sampleClock + MIDI_TRIGGER_DELAY,
+                      note.velocity);
+      sequencerRecord(note.pad, note.sampleClock, note.velocity);
+      lastPad = note.pad;
+      p.tail++;
+    }
+  }
+  return lastPad;
+}
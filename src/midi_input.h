@@ -0,0 +1,51 @@
+/*
+  MIDI note input for the pads.
+
+  Each port (the MIDI UART and USB-MIDI) has its own parser and its own
+  single-producer event queue, so the UART receive interrupt and the USB
+  poll never share state. midiInputByte() parses a byte as it arrives and
+  stamps any note-on that maps to a pad with the sample clock at that
+  moment. midiInputSchedule(), called before each audio block, hands the
+  notes to the engine's trigger queue MIDI_TRIGGER_DELAY samples after they
+  arrived. The delay is constant, so notes keep their exact spacing instead
+  of snapping to block or control-rate boundaries.
+
+  Notes follow the General MIDI drum map on MIDI_CHANNEL; velocity scales
+  the pad's level.
+*/
+
+#ifndef MIDI_INPUT_H
+#define MIDI_INPUT_H
+
+#include <Arduino.h>
+
+#include "midi_parser.h"
+#include "sample_engine.h"
+
+#define MIDI_PORT_UART 0
+#define MIDI_PORT_USB 1
+#define MIDI_PORTS 2
+
+#define MIDI_CHANNEL 10      // Drum channel, 1-16 (0 listens to all)
+#define MIDI_EVENT_QUEUE 16  // Notes per port waiting for the audio path
+
+// Arrival to sound: Mozzi's output buffer, plus a block for the queue to be
+// read and one being rendered. Notes arriving later than this behind the
+// engine still play, on the next sample.
+#define MIDI_TRIGGER_DELAY (256 + 2 * AUDIO_BLOCK_SIZE)
+
+// Pad for a General MIDI drum note, or -1
+int midiNotePad(uint8_t note);
+
+// True, with the pad and velocity, when the message should trigger a pad
+bool midiNoteTrigger(const MidiMessage& message, int& pad, uint8_t& velocity);
+
+// Parse a byte received on a port at sampleClock (the clock reaching the
+// DAC). Call from the port's receive interrupt or poll, one caller per port.
+void midiInputByte(int port, uint8_t byte, uint32_t sampleClock);
+
+// Queue the pending notes of every port in the engine. Returns the last pad
+// queued, or -1 if there were none.
+int midiInputSchedule();
+
+#endif  // MIDI_INPUT_H
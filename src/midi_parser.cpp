@@ -0,0 +1,68 @@
+/*
+  Byte-at-a-time MIDI parser - see midi_parser.h
+*/
+
+#include "midi_parser.h"
+
+// Data bytes that follow a status byte
+static uint8_t dataLength(uint8_t status) {
+  if (status < 0xF0) {
+    uint8_t type = status & 0xF0;
+    return type == MIDI_PROGRAM_CHANGE || type == MIDI_CHANNEL_PRESSURE ? 1 : 2;
+  }
+  switch (status) {
+    case 0xF1:  // MTC quarter frame
+    case 0xF3:  // Song select
+      return 1;
+    case 0xF2:  // Song position
+      return 2;
+    default:  // Tune request, undefined
+      return 0;
+  }
+}
+
+void midiParserReset(MidiParser& parser) {
+  parser.status = 0;
+  parser.needed = 0;
+  parser.received = 0;
+  parser.inSysex = false;
+}
+
+bool midiParse(MidiParser& parser, uint8_t byte, MidiMessage& message) {
+  // Real-time bytes stand alone and never disturb the message in progress
+  if (byte >= MIDI_REALTIME_FIRST) {
+    message = {byte, {0, 0}};
+    return true;
+  }
+
+  if (byte & 0x80) {
+    parser.inSysex = byte == MIDI_SYSEX_START;
+    parser.received = 0;
+    if (byte >= 0xF0) {
+      // System common: no running status, and it may complete right here
+      parser.status = 0;
+      if (parser.inSysex || byte == MIDI_SYSEX_END) return false;
+      if (dataLength(byte) == 0) {
+        message = {byte, {0, 0}};
+        return true;
+      }
+    }
+    parser.status = byte;
+    parser.needed = dataLength(byte);
+    return false;
+  }
+
+  // Data byte
+  if (parser.inSysex || parser.status == 0) return false;
+  parser.data[parser.received++] = byte;
+  if (parser.received < parser.needed) return false;
+
+  message.status = parser.status;
+  message.data[0] = parser.data[0];
+  message.data[1] = parser.needed == 2 ? parser.data[1] : 0;
+  parser.received = 0;
+
+  // Only channel messages keep running status
+  if (parser.status >= 0xF0) parser.status = 0;
+  return true;
+}
@@ -0,0 +1,68 @@
+/*
+  Byte-at-a-time MIDI parser.
+
+  Fed one byte at a time, straight from a receive interrupt, it keeps just
+  enough state to assemble complete messages:
+
+    - running status: data bytes after a complete message reuse the last
+      channel status byte
+    - real-time bytes (0xF8-0xFF) may appear anywhere, even between the
+      data bytes of another message; they are returned on their own and
+      leave the message in progress untouched
+    - system exclusive data is skipped up to 0xF7 or the next status byte
+    - system common messages cancel running status
+    - data bytes with no status to belong to are dropped
+
+  Shared with the native host build, which checks it against recorded byte
+  streams (see src/native/midi_check.h).
+*/
+
+#ifndef MIDI_PARSER_H
+#define MIDI_PARSER_H
+
+#include <Arduino.h>
+
+// Channel voice message types (status high nibble)
+#define MIDI_NOTE_OFF 0x80
+#define MIDI_NOTE_ON 0x90
+#define MIDI_POLY_PRESSURE 0xA0
+#define MIDI_CONTROL_CHANGE 0xB0
+#define MIDI_PROGRAM_CHANGE 0xC0
+#define MIDI_CHANNEL_PRESSURE 0xD0
+#define MIDI_PITCH_BEND 0xE0
+
+// System messages
+#define MIDI_SYSEX_START 0xF0
+#define MIDI_SYSEX_END 0xF7
+#define MIDI_REALTIME_FIRST 0xF8  // Clock, start, continue, stop, ...
+
+struct MidiMessage {
+  uint8_t status;   // Status byte, including the channel for voice messages
+  uint8_t data[2];  // Unused data bytes are 0
+};
+
+struct MidiParser {
+  uint8_t status;      // Running status, 0 when there is none
+  uint8_t needed;      // Data bytes the current status takes
+  uint8_t received;    // Data bytes collected so far
+  uint8_t data[2];
+  bool inSysex;
+};
+
+// Forget any message in progress and the running status
+void midiParserReset(MidiParser& parser);
+
+// Feed one byte. Returns true and fills message when it completes one.
+bool midiParse(MidiParser& parser, uint8_t byte, MidiMessage& message);
+
+// Channel 1-16 of a channel voice message
+inline uint8_t midiChannel(const MidiMessage& message) {
+  return (message.status & 0x0F) + 1;
+}
+
+// Message type: high nibble for channel messages, the status byte otherwise
+inline uint8_t midiType(const MidiMessage& message) {
+  return message.status < 0xF0 ? message.status & 0xF0 : message.status;
+}
+
+#endif  // MIDI_PARSER_H
@@ -16,8 +16,8 @@
 
 // Custom I2S pin definitions for RP2040
 // These will be used in the main code to configure I2S manually
-#define CUSTOM_I2S_BCK_PIN 26   // Bit clock pin (BCK)
-#define CUSTOM_I2S_LRCK_PIN 27  // Word select pin (LCK/LRCK)
-#define CUSTOM_I2S_DATA_PIN 28  // Data out pin (DIN/DOUT)
+#define CUSTOM_I2S_BCK_PIN 20   // Bit clock pin (BCK)
+#define CUSTOM_I2S_LRCK_PIN 21  // Word select pin (LCK/LRCK)
+#define CUSTOM_I2S_DATA_PIN 22  // Data out pin (DIN/DOUT)
 
 #endif  // MOZZI_CONFIG_H_
@@ -0,0 +1,51 @@
+/*
+  Host clock and PROGMEM bounds checking for the Arduino shim.
+  millis()/micros() report the position of the offline render, not
+  wall-clock time.
+*/
+
+#include <Arduino.h>
+#include <Mozzi.h>
+
+static uint64_t hostClockSamples = 0;
+
+void hostClockSetSamples(uint64_t samples) { hostClockSamples = samples; }
+
+unsigned long millis() {
+  return (unsigned long)(hostClockSamples * 1000 / MOZZI_AUDIO_RATE);
+}
+
+unsigned long micros() {
+  return (unsigned long)(hostClockSamples * 1000000 / MOZZI_AUDIO_RATE);
+}
+
+// PROGMEM regions that reads may legally touch
+#define HOST_PROGMEM_MAX_REGIONS 16
+
+struct HostProgmemRegion {
+  const uint8_t* start;
+  size_t length;
+};
+
+bool hostProgmemChecking = false;
+static HostProgmemRegion hostProgmemRegions[HOST_PROGMEM_MAX_REGIONS];
+static int hostProgmemRegionCount = 0;
+static uint32_t hostProgmemViolationCount = 0;
+
+void hostProgmemRegisterRegion(const void* start, size_t length) {
+  if (hostProgmemRegionCount < HOST_PROGMEM_MAX_REGIONS) {
+    hostProgmemRegions[hostProgmemRegionCount++] = {(const uint8_t*)start,
+                                                    length};
+  }
+}
+
+void hostProgmemCheckRead(const void* addr) {
+  const uint8_t* p = (const uint8_t*)addr;
+  for (int i = 0; i < hostProgmemRegionCount; i++) {
+    const HostProgmemRegion& region = hostProgmemRegions[i];
+    if (p >= region.start && p < region.start + region.length) return;
+  }
+  hostProgmemViolationCount++;
+}
+
+uint32_t hostProgmemViolations() { return hostProgmemViolationCount; }
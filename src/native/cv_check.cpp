@@ -0,0 +1,261 @@
+/*
+  CV input jitter check - see cv_check.h
+*/
+
+#include "cv_check.h"
+
+#include <Mozzi.h>
+#include <math.h>
+#include <stdio.h>
+
+#include "../cv_input.h"
+#include "../sample_engine.h"
+
+#define CV_CHECK_SECONDS 1.0
+#define CV_CHECK_WARMUP 0.1       // Seconds before anything is measured
+#define CV_CHECK_STEP_TIME 0.5    // When the step scenario's CV1 jumps
+#define CV_CHECK_SETTLE_SPAN 0.1  // Seconds after the step left out of rms
+#define CV_CHECK_NOISE 8          // Uniform noise, +/- ADC counts
+#define CV_CHECK_HUM_HZ 50.0
+#define CV_CHECK_SETTLE_CENTS 10.0
+
+enum CvCheckKind { CV_JITTER, CV_ZERO, CV_SETTLE, CV_SELECT_EDGE };
+
+struct CvScenario {
+  const char* name;
+  CvCheckKind kind;
+  double counts[3];  // Pitch, decay and select inputs, ADC counts
+  double hum;        // 50 Hz amplitude on every input, ADC counts
+  double step;       // Added to the pitch input at CV_CHECK_STEP_TIME
+  double maxRatio;   // CV_JITTER: out_rms / in_rms must stay below this
+};
+
+static const CvScenario scenarios[] = {
+    {"dc_noise", CV_JITTER, {1.5 * CV_COUNTS_PER_OCTAVE, 0, 0}, 0, 0, 0.25},
+    {"hum_50hz", CV_JITTER, {1.5 * CV_COUNTS_PER_OCTAVE, 0, 0}, 8, 0, 0.5},
+    {"zero", CV_ZERO, {0, 0, 0}, 0, 0, 0},
+    {"step", CV_SETTLE, {CV_COUNTS_PER_OCTAVE, 0, 0}, 0,
+     CV_COUNTS_PER_OCTAVE, 0},
+    {"select_edge", CV_SELECT_EDGE, {0, 0, 4096.0 / NUM_SAMPLES}, 0, 0, 0},
+};
+
+// Small deterministic PRNG, so every run sees the same traces
+struct CvRandom {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+// Ideal (noise-free) input on a channel at time t
+static double idealCounts(const CvScenario& scenario, int channel, double t,
+                          bool withHum) {
+  if (channel >= 3) return 0;  // ADC3 only pads the round-robin frame
+  double value = scenario.counts[channel];
+  if (channel == CV_PITCH && t >= CV_CHECK_STEP_TIME) value += scenario.step;
+  if (withHum) value += scenario.hum * sin(2 * M_PI * CV_CHECK_HUM_HZ * t);
+  return value;
+}
+
+static double pitchCents(uint32_t step) {
+  return 1200.0 * log2((double)step / PITCH_UNITY);
+}
+
+// Run one scenario and report it, returning true when it passed
+static bool runCvScenario(const CvScenario& scenario, ReportLineFn emit) {
+  static uint16_t ring[CV_RING_SAMPLES];
+  CvRandom random = {0x2545F491u};
+  int watch = scenario.kind == CV_SELECT_EDGE ? CV_SELECT : CV_PITCH;
+  double blockSeconds = (double)AUDIO_BLOCK_SIZE / MOZZI_AUDIO_RATE;
+  int blocks = (int)(CV_CHECK_SECONDS / blockSeconds);
+
+  uint64_t written = 0;
+  double inSquares = 0, outSquares = 0;
+  int inCount = 0, outCount = 0;
+  double centsSum = 0, centsSquares = 0, centsMin = 1e9, centsMax = -1e9;
+  int centsCount = 0;
+  double lastUnsettled = -1;
+  int switches = 0, lastOffset = -1;
+  bool exact = true;
+
+  for (int block = 0; block < blocks; block++) {
+    // Conversions the ADC finished by the end of this block, usually
+    // stopping partway through a frame
+    double end = (block + 1) * blockSeconds;
+    uint64_t due = (uint64_t)(end * CV_FRAME_RATE * CV_CHANNELS);
+    for (; written < due; written++) {
+      int channel = written % CV_CHANNELS;
+      double t = (double)(written / CV_CHANNELS) / CV_FRAME_RATE;
+      double ideal = idealCounts(scenario, channel, t, true);
+      int noise =
+          (int)(random.next() % (2 * CV_CHECK_NOISE + 1)) - CV_CHECK_NOISE;
+      long value = lround(ideal) + noise;
+      if (value < 0) value = 0;
+      if (value > 4095) value = 4095;
+      ring[written % CV_RING_SAMPLES] = (uint16_t)value;
+
+      if (channel == watch && t >= CV_CHECK_WARMUP) {
+        double error = value - idealCounts(scenario, channel, t, false);
+        inSquares += error * error;
+        inCount++;
+      }
+    }
+    cvInputProcess(ring, written % CV_RING_SAMPLES);
+    if (end < CV_CHECK_WARMUP) continue;
+
+    double target = idealCounts(scenario, watch, end, false);
+    uint32_t pitch = cvPitchStep(cvInputValue(CV_PITCH));
+    double cents = pitchCents(pitch) - 1200.0 * target / CV_COUNTS_PER_OCTAVE;
+
+    if (scenario.kind == CV_SETTLE && end >= CV_CHECK_STEP_TIME &&
+        fabs(cents) >= CV_CHECK_SETTLE_CENTS) {
+      lastUnsettled = end;
+    }
+    if (scenario.kind == CV_ZERO &&
+        (pitch != PITCH_UNITY ||
+         cvDecayFactor(cvInputValue(CV_DECAY)) != DECAY_NONE ||
+         cvInputSampleOffset() != 0)) {
+      exact = false;
+    }
+    if (lastOffset >= 0 && cvInputSampleOffset() != lastOffset) switches++;
+    lastOffset = cvInputSampleOffset();
+
+    // Jitter only where the input holds still
+    bool settling = scenario.step != 0 && end >= CV_CHECK_STEP_TIME &&
+                    end < CV_CHECK_STEP_TIME + CV_CHECK_SETTLE_SPAN;
+    if (settling) continue;
+    double error = cvInputValue(watch) / 16.0 - target;
+    outSquares += error * error;
+    outCount++;
+    if (watch == CV_PITCH) {
+      centsSum += cents;
+      centsSquares += cents * cents;
+      if (cents < centsMin) centsMin = cents;
+      if (cents > centsMax) centsMax = cents;
+      centsCount++;
+    }
+  }
+
+  double inRms = sqrt(inSquares / inCount);
+  double outRms = sqrt(outSquares / outCount);
+  double centsRms = 0, centsPeak = 0;
+  if (centsCount > 0) {
+    double mean = centsSum / centsCount;
+    centsRms = sqrt(centsSquares / centsCount - mean * mean);
+    centsPeak = centsMax - centsMin;
+  }
+  double settleMs =
+      lastUnsettled < 0
+          ? 0
+          : (lastUnsettled + blockSeconds - CV_CHECK_STEP_TIME) * 1000;
+
+  bool passed = true;
+  switch (scenario.kind) {
+    case CV_JITTER:
+      passed = outRms < inRms * scenario.maxRatio;
+      break;
+    case CV_ZERO:
+      passed = exact;
+      break;
+    case CV_SETTLE:
+      passed = lastUnsettled < CV_CHECK_SECONDS - CV_CHECK_SETTLE_SPAN &&
+               settleMs < CV_CHECK_SETTLE_SPAN * 1000;
+      break;
+    case CV_SELECT_EDGE:
+      passed = switches == 0;
+      break;
+  }
+
+  char line[160];
+  snprintf(line, sizeof(line), "%s,%.2f,%.2f,%.2f,%.2f,%.1f,%d,%s",
+           scenario.name, inRms, outRms, centsRms, centsPeak, settleMs,
+           switches, passed ? "ok" : "FAIL");
+  emit(line);
+  return passed;
+}
+
+// Hold every input at a level long enough for the smoothing to settle,
+// applying the CVs to the voices once per block as the firmware does
+static void holdCvInputs(double pitchCounts, double decayCounts) {
+  static uint16_t ring[CV_RING_SAMPLES];
+  for (int i = 0; i < CV_RING_SAMPLES; i++) {
+    int channel = i % CV_CHANNELS;
+    double counts = channel == CV_PITCH   ? pitchCounts
+                    : channel == CV_DECAY ? decayCounts
+                                          : 0;
+    ring[i] = (uint16_t)lround(counts);
+  }
+  for (int block = 0; block < 64; block++) {
+    cvInputProcess(ring, 0);
+    cvInputApply();
+  }
+}
+
+// Samples a voice advances through in one block at its current rate
+static int32_t voiceAdvance(int voice) {
+  int8_t block[AUDIO_BLOCK_SIZE];
+  triggerSample(voice);
+  renderBlock(block, AUDIO_BLOCK_SIZE);
+  return voicePosition(voice);
+}
+
+// Pitch, decay and sample set over serial or recalled from a preset must
+// survive the CVs being applied every block, patched or not
+static bool runSettingsCheck(ReportLineFn emit) {
+  const uint32_t setPitch = PITCH_UNITY * 3 / 2;
+  const VoiceSettings recalled = {PITCH_UNITY * 3 / 4, 60000, LEVEL_UNITY, 3};
+  cvInputSetTarget((1 << NUM_VOICES) - 1);
+  setVoicePitch(0, setPitch);     // SERIAL_PARAM_PITCH
+  setVoiceSettings(1, recalled);  // presetRecall()
+
+  bool passed = true;
+  const double volts[] = {0, 1};
+  for (double volt : volts) {
+    holdCvInputs(volt * CV_COUNTS_PER_OCTAVE, 0);
+    VoiceSettings set = voiceSettings(0);
+    VoiceSettings recall = voiceSettings(1);
+    passed = passed && set.pitch == setPitch &&
+             recall.pitch == recalled.pitch &&
+             recall.decay == recalled.decay &&
+             recall.sample == recalled.sample;
+
+    // What plays is the setting shifted up an octave per volt, give or take
+    // the few counts the smoothing settles short of the input
+    double scale = volt == 0 ? 1 : 2;
+    double setRate = voiceAdvance(0) / (scale * AUDIO_BLOCK_SIZE);
+    double recalledRate = voiceAdvance(1) / (scale * AUDIO_BLOCK_SIZE);
+    passed = passed && fabs(setRate - 1.5) < 0.05 &&
+             fabs(recalledRate - 0.75) < 0.05 &&
+             voiceSample(1) == recalled.sample;
+  }
+
+  holdCvInputs(0, 0);
+  stopAllSamples();
+  for (int voice = 0; voice < NUM_VOICES; voice++) {
+    setVoiceSettings(voice, {PITCH_UNITY, DECAY_NONE, LEVEL_UNITY,
+                             (uint8_t)voice});
+  }
+
+  emit(passed ? "keeps_settings,0.00,0.00,0.00,0.00,0.0,0,ok"
+              : "keeps_settings,0.00,0.00,0.00,0.00,0.0,0,FAIL");
+  return passed;
+}
+
+int runCvChecks(ReportLineFn emit) {
+  char line[96];
+  snprintf(line, sizeof(line), "# cv_check,frame_rate=%d,block=%d",
+           CV_FRAME_RATE, AUDIO_BLOCK_SIZE);
+  emit(line);
+  emit("scenario,in_rms,out_rms,cents_rms,cents_pp,settle_ms,switches,result");
+
+  int failures = 0;
+  for (const CvScenario& scenario : scenarios) {
+    if (!runCvScenario(scenario, emit)) failures++;
+  }
+  if (!runSettingsCheck(emit)) failures++;
+  return failures;
+}
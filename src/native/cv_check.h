@@ -0,0 +1,37 @@
+/*
+  CV input jitter check on synthetic ADC traces.
+
+  Streams round-robin conversions into a ring the way the ADC's DMA channel
+  does (8000 frames/s, stopping mid-frame wherever a block boundary falls)
+  and runs the firmware's decimation, smoothing and mapping once per audio
+  block. Each scenario drives the inputs with a known voltage plus noise and
+  compares the jitter before and after filtering:
+
+    dc_noise    CV1 at 1.5 V with +/-8 LSB of noise
+    hum_50hz    CV1 at 1.5 V with 8 LSB of 50 Hz hum and noise
+    zero        every input at 0 V with noise: exactly 1.0x and no decay
+    step        CV1 jumps 1 V; time until the pitch is within 10 cents
+    select_edge CV3 on a sample select boundary with noise: no switching
+    keeps_settings  pitch set over serial and settings recalled from a
+                preset hold with the CVs applied every block, at 0 V and
+                1 V, and what plays is the setting shifted by the CV
+
+  Output (CSV):
+    # cv_check,frame_rate=<n>,block=<n>
+    scenario,in_rms,out_rms,cents_rms,cents_pp,settle_ms,switches,result
+    dc_noise,...
+    ...
+
+  in_rms and out_rms are the error from the ideal value in ADC counts, raw
+  conversions against the smoothed value.
+*/
+
+#ifndef CV_CHECK_H
+#define CV_CHECK_H
+
+#include "../report.h"
+
+// Returns the number of scenarios that failed
+int runCvChecks(ReportLineFn emit);
+
+#endif  // CV_CHECK_H
@@ -0,0 +1,118 @@
+/*
+  Fixed-point FFT accuracy checks - see fft_check.h
+*/
+
+#include "fft_check.h"
+
+#include <math.h>
+#include <stdio.h>
+
+#include "../fft_q15.h"
+
+// Small deterministic PRNG so failures reproduce
+struct FftRandom {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+};
+
+static int8_t clampSample(double value) {
+  long rounded = lround(value);
+  if (rounded > 127) rounded = 127;
+  if (rounded < -128) rounded = -128;
+  return (int8_t)rounded;
+}
+
+static void makeSilence(int8_t* samples) {
+  for (int n = 0; n < FFT_SIZE; n++) samples[n] = 0;
+}
+
+static void makeDc(int8_t* samples) {
+  for (int n = 0; n < FFT_SIZE; n++) samples[n] = 100;
+}
+
+static void makeImpulse(int8_t* samples) {
+  makeSilence(samples);
+  samples[FFT_SIZE / 2] = 127;  // Where the window is 1
+}
+
+static void makeTone(int8_t* samples) {
+  for (int n = 0; n < FFT_SIZE; n++) {
+    samples[n] = clampSample(127 * sin(2 * M_PI * 19 * n / FFT_SIZE));
+  }
+}
+
+static void makeTwoTones(int8_t* samples) {
+  for (int n = 0; n < FFT_SIZE; n++) {
+    samples[n] = clampSample(80 * sin(2 * M_PI * 7.5 * n / FFT_SIZE) +
+                             40 * cos(2 * M_PI * 63.3 * n / FFT_SIZE));
+  }
+}
+
+static void makeSquare(int8_t* samples) {
+  for (int n = 0; n < FFT_SIZE; n++) {
+    samples[n] = (n / 8) & 1 ? -128 : 127;
+  }
+}
+
+static void makeNoise(int8_t* samples) {
+  FftRandom random = {0xFF7};
+  for (int n = 0; n < FFT_SIZE; n++) samples[n] = (int8_t)random.next();
+}
+
+// Largest error over all bins against the reference, in LSB
+static double maxBinError(const int8_t* samples) {
+  static int16_t re[FFT_SIZE], im[FFT_SIZE];
+  fftQ15(samples, re, im);
+
+  double input[FFT_SIZE];
+  for (int n = 0; n < FFT_SIZE; n++) {
+    double window = 0.5 - 0.5 * cos(2 * M_PI * n / FFT_SIZE);
+    input[n] = samples[n] * 128.0 * window;  // fftLoadQ15()'s half scale
+  }
+
+  double worst = 0;
+  for (int k = 0; k < FFT_SIZE; k++) {
+    double sumRe = 0, sumIm = 0;
+    for (int n = 0; n < FFT_SIZE; n++) {
+      double angle = 2 * M_PI * (double)k * n / FFT_SIZE;
+      sumRe += input[n] * cos(angle);
+      sumIm -= input[n] * sin(angle);
+    }
+    worst = fmax(worst, fabs(re[k] - sumRe / FFT_SIZE));
+    worst = fmax(worst, fabs(im[k] - sumIm / FFT_SIZE));
+  }
+  return worst;
+}
+
+int runFftChecks() {
+  struct Signal {
+    const char* name;
+    void (*make)(int8_t* samples);
+  };
+  const Signal signals[] = {
+      {"silence", makeSilence},     {"dc", makeDc},
+      {"impulse", makeImpulse},     {"tone", makeTone},
+      {"two_tones", makeTwoTones},  {"square", makeSquare},
+      {"noise", makeNoise},
+  };
+
+  int failures = 0;
+  for (const Signal& signal : signals) {
+    int8_t samples[FFT_SIZE];
+    signal.make(samples);
+    double error = maxBinError(samples);
+    bool ok = error <= FFT_CHECK_MAX_LSB;
+    printf("%-4s %-9s max_err=%.2f lsb\n", ok ? "ok" : "FAIL", signal.name,
+           error);
+    if (!ok) failures++;
+  }
+  printf("%zu FFT signals, %d failed (limit %d lsb)\n",
+         sizeof signals / sizeof signals[0], failures, FFT_CHECK_MAX_LSB);
+  return failures;
+}
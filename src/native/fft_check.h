@@ -0,0 +1,26 @@
+/*
+  Fixed-point FFT accuracy checks.
+
+  Runs fftQ15() on test signals and compares every bin with a
+  double-precision DFT of the same input, Hann windowed and scaled the way
+  fftLoadQ15() loads it, divided by FFT_SIZE like the fixed-point result.
+  Signals: silence, DC, an impulse, a full-scale tone on a bin, two tones
+  between bins, a full-scale square wave and white noise.
+
+  Prints "ok   <name> max_err=<lsb>" or "FAIL ..." per signal. A bin fails
+  when its real or imaginary part is more than FFT_CHECK_MAX_LSB off.
+*/
+
+#ifndef FFT_CHECK_H
+#define FFT_CHECK_H
+
+#include "../fft_q15.h"
+
+// Every stage truncates twice (the twiddle product and the halving), which
+// biases a bin by up to about 1 LSB per stage; DC shows it in full
+#define FFT_CHECK_MAX_LSB (FFT_LOG2_SIZE + 1)
+
+// Returns the number of failed signals
+int runFftChecks();
+
+#endif  // FFT_CHECK_H
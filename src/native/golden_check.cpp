@@ -0,0 +1,130 @@
+/*
+  Golden-output regression checks - see golden_check.h
+*/
+
+#include "golden_check.h"
+
+#include <Mozzi.h>
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "offline_render.h"
+#include "trigger_script.h"
+#include "wav_file.h"
+
+static std::vector<std::string> listGoldenCases(const std::string& directory) {
+  std::vector<std::string> names;
+  DIR* dir = opendir(directory.c_str());
+  if (!dir) return names;
+
+  while (struct dirent* entry = readdir(dir)) {
+    std::string file = entry->d_name;
+    if (file.size() > 4 && file.compare(file.size() - 4, 4, ".txt") == 0) {
+      names.push_back(file.substr(0, file.size() - 4));
+    }
+  }
+  closedir(dir);
+
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Compare one render against its reference, writing diff files on failure
+static bool checkGoldenCase(const std::string& base,
+                            const std::vector<int16_t>& actual,
+                            const std::vector<int16_t>& reference,
+                            int tolerance) {
+  size_t length = std::max(actual.size(), reference.size());
+  std::vector<int16_t> diff(length);
+  size_t mismatches = 0;
+  size_t firstMismatch = 0;
+  int maxError = 0;
+
+  for (size_t i = 0; i < length; i++) {
+    int a = i < actual.size() ? actual[i] : 0;
+    int r = i < reference.size() ? reference[i] : 0;
+    int error = a - r;
+    diff[i] = (int16_t)std::max(-32768, std::min(32767, error));
+
+    if (abs(error) > tolerance) {
+      if (mismatches == 0) firstMismatch = i;
+      mismatches++;
+    }
+    maxError = std::max(maxError, abs(error));
+  }
+
+  if (mismatches == 0 && actual.size() == reference.size()) return true;
+
+  if (actual.size() != reference.size()) {
+    printf("  length %zu, expected %zu\n", actual.size(), reference.size());
+  }
+  if (mismatches) {
+    printf("  %zu samples differ (first at %zu = %.1fms), max error %d\n",
+           mismatches, firstMismatch,
+           firstMismatch * 1000.0 / MOZZI_AUDIO_RATE, maxError);
+  }
+
+  writeWavFile(base + ".diff.wav", diff, MOZZI_AUDIO_RATE);
+  writeWavFile(base + ".actual.wav", actual, MOZZI_AUDIO_RATE);
+  printf("  wrote %s.diff.wav and %s.actual.wav\n", base.c_str(), base.c_str());
+  return false;
+}
+
+int runGoldenChecks(const std::string& directory, const GoldenOptions& options) {
+  std::vector<std::string> names = listGoldenCases(directory);
+  if (names.empty()) {
+    printf("No golden cases (*.txt) in %s\n", directory.c_str());
+    return 1;
+  }
+
+  int failures = 0;
+  for (const std::string& name : names) {
+    std::string base = directory + "/" + name;
+    std::vector<ScriptTrigger> triggers;
+    std::string error;
+    if (!loadTriggerScript(base + ".txt", triggers, error)) {
+      printf("FAIL %s: %s\n", name.c_str(), error.c_str());
+      failures++;
+      continue;
+    }
+
+    std::vector<int16_t> actual;
+    if (options.update) {
+      renderTriggers(triggers, 0, actual);
+      if (!writeWavFile(base + ".wav", actual, MOZZI_AUDIO_RATE)) {
+        printf("FAIL %s: cannot write reference\n", name.c_str());
+        failures++;
+      } else {
+        printf("UPDATED %s (%zu samples)\n", name.c_str(), actual.size());
+      }
+      continue;
+    }
+
+    std::vector<int16_t> reference;
+    uint32_t sampleRate = 0;
+    if (!readWavFile(base + ".wav", reference, sampleRate) ||
+        sampleRate != MOZZI_AUDIO_RATE) {
+      printf("FAIL %s: missing or unreadable reference %s.wav\n", name.c_str(),
+             base.c_str());
+      failures++;
+      continue;
+    }
+
+    // Render exactly as long as the reference so tails are compared too
+    renderTriggers(triggers, reference.size(), actual);
+    bool ok = checkGoldenCase(base, actual, reference, options.tolerance);
+    if (!ok) {
+      printf("FAIL %s\n", name.c_str());
+      failures++;
+    } else {
+      printf("ok   %s\n", name.c_str());
+    }
+  }
+
+  printf("%zu golden cases, %d failed\n", names.size(), failures);
+  return failures;
+}
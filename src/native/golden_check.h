@@ -0,0 +1,26 @@
+/*
+  Golden-output regression checks for the sample engine.
+
+  A golden directory holds trigger lists (<name>.txt) next to reference
+  renders (<name>.wav). Each list is rendered through the engine and compared
+  with its reference, bit-exactly by default or within a per-sample
+  tolerance. A failing case writes <name>.diff.wav (actual minus reference)
+  and <name>.actual.wav alongside the reference for listening/inspection.
+*/
+
+#ifndef GOLDEN_CHECK_H
+#define GOLDEN_CHECK_H
+
+#include <stdint.h>
+
+#include <string>
+
+struct GoldenOptions {
+  int tolerance;  // Largest allowed per-sample difference (16-bit scale)
+  bool update;    // Rewrite the references instead of comparing
+};
+
+// Check every case in the directory, returning the number of failures
+int runGoldenChecks(const std::string& directory, const GoldenOptions& options);
+
+#endif  // GOLDEN_CHECK_H
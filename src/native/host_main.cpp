@@ -0,0 +1,278 @@
+/*
+  Pico DAC Sampler - native host build
+
+  Runs the sample playback engine on Linux/macOS without the module, for
+  offline rendering and for profiling with perf, valgrind and friends.
+
+  Usage:
+    program render <triggers.txt> <out.wav> [--length-ms N] [--trace F]
+    program bench
+    program golden [dir] [--tolerance N] [--update]
+    program latency <triggers.txt> [--buffer N] [--press-ms N]
+    program stress [--seed N] [--seconds N] [--min-speed X]
+    program uibench
+    program midi [dir] | --decode <capture.bin>
+    program cv
+    program serial
+    program presets
+    program oled
+    program fft
+*/
+
+#include <Arduino.h>
+#include <Mozzi.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../audio_bench.h"
+#include "../latency_probe.h"
+#include "../trace_ring.h"
+#include "cv_check.h"
+#include "fft_check.h"
+#include "golden_check.h"
+#include "latency_sim.h"
+#include "midi_check.h"
+#include "offline_render.h"
+#include "oled_check.h"
+#include "preset_check.h"
+#include "serial_check.h"
+#include "stress_harness.h"
+#include "trigger_script.h"
+#include "ui_bench.h"
+#include "wav_file.h"
+
+static void printUsage() {
+  fprintf(stderr,
+          "Pico DAC Sampler native host build\n"
+          "\n"
+          "Usage:\n"
+          "  program render <triggers.txt> <out.wav> [--length-ms N]\n"
+          "                 [--trace F]     Also write the event trace dump\n"
+          "  program bench                  Audio hot path benchmarks (CSV)\n"
+          "  program golden [dir] [--tolerance N] [--update]\n"
+          "                                 Compare renders with references\n"
+          "                                 (default dir test/golden)\n"
+          "  program latency <triggers.txt> [--buffer N] [--press-ms N]\n"
+          "                                 Trigger latency histogram (CSV)\n"
+          "  program stress [--seed N] [--seconds N] [--min-speed X]\n"
+          "                                 Randomized trigger stress test\n"
+          "  program uibench                OLED composition and I2C (CSV)\n"
+          "  program midi [dir]             Check the MIDI parser against\n"
+          "                                 byte streams (default test/midi)\n"
+          "  program midi --decode <file>   Print the messages in a raw\n"
+          "                                 MIDI capture\n"
+          "  program cv                     CV input jitter on synthetic\n"
+          "                                 ADC traces (CSV)\n"
+          "  program serial                 Check the binary serial protocol\n"
+          "  program presets                Check the preset store on a\n"
+          "                                 simulated flash\n"
+          "  program oled                   Check OLED dirty-span planning\n"
+          "  program fft                    Check the Q15 FFT against a DFT\n"
+          "\n"
+          "Trigger files list one \"<time_ms> <pad>\" per line, where pad is\n"
+          "1-4 or kick/snare/hihat/tom.\n");
+}
+
+static FILE* traceFile = nullptr;
+
+static bool writeTraceLine(const char* line, size_t length) {
+  fprintf(traceFile, "%.*s\n", (int)length, line);
+  return true;
+}
+
+static int commandRender(int argc, char** argv) {
+  if (argc < 2) {
+    printUsage();
+    return 2;
+  }
+
+  uint32_t lengthSamples = 0;
+  const char* tracePath = nullptr;
+  for (int i = 2; i < argc; i++) {
+    if (strcmp(argv[i], "--length-ms") == 0 && i + 1 < argc) {
+      lengthSamples = (uint32_t)(atof(argv[++i]) * MOZZI_AUDIO_RATE / 1000.0);
+    } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+      tracePath = argv[++i];
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  std::vector<ScriptTrigger> triggers;
+  std::string error;
+  if (!loadTriggerScript(argv[0], triggers, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  std::vector<int16_t> samples;
+  auto start = std::chrono::steady_clock::now();
+  renderTriggers(triggers, lengthSamples, samples);
+  auto end = std::chrono::steady_clock::now();
+
+  if (!writeWavFile(argv[1], samples, MOZZI_AUDIO_RATE)) {
+    fprintf(stderr, "cannot write %s\n", argv[1]);
+    return 1;
+  }
+
+  if (tracePath) {
+    traceFile = fopen(tracePath, "w");
+    if (!traceFile) {
+      fprintf(stderr, "cannot write %s\n", tracePath);
+      return 1;
+    }
+    while (!traceDump(writeTraceLine)) {
+    }
+    fclose(traceFile);
+  }
+
+  double seconds = std::chrono::duration<double>(end - start).count();
+  double audioSeconds = (double)samples.size() / MOZZI_AUDIO_RATE;
+  printf("Rendered %zu triggers, %zu samples (%.2fs) in %.3fms (%.0fx real time)\n",
+         triggers.size(), samples.size(), audioSeconds, seconds * 1000.0,
+         seconds > 0 ? audioSeconds / seconds : 0.0);
+  return 0;
+}
+
+static int commandGolden(int argc, char** argv) {
+  std::string directory = "test/golden";
+  GoldenOptions options = {0, false};
+
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc) {
+      options.tolerance = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--update") == 0) {
+      options.update = true;
+    } else if (argv[i][0] != '-') {
+      directory = argv[i];
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  return runGoldenChecks(directory, options) == 0 ? 0 : 1;
+}
+
+static int commandStress(int argc, char** argv) {
+  StressOptions options = {1, 60, 10.0};
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+      options.seed = (uint32_t)strtoul(argv[++i], nullptr, 0);
+    } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+      options.seconds = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--min-speed") == 0 && i + 1 < argc) {
+      options.minSpeed = atof(argv[++i]);
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  return runStressScenarios(options) == 0 ? 0 : 1;
+}
+
+static int commandMidi(int argc, char** argv) {
+  std::string directory = "test/midi";
+  for (int i = 0; i < argc; i++) {
+    if (strcmp(argv[i], "--decode") == 0 && i + 1 < argc) {
+      return decodeMidiFile(argv[i + 1]);
+    } else if (argv[i][0] != '-') {
+      directory = argv[i];
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  return runMidiChecks(directory) == 0 ? 0 : 1;
+}
+
+static void printReportLine(const char* line) { printf("%s\n", line); }
+
+static int commandLatency(int argc, char** argv) {
+  if (argc < 1) {
+    printUsage();
+    return 2;
+  }
+
+  // Mozzi's default output buffer, and a press well past the debounce time
+  LatencySimOptions options = {256, MOZZI_AUDIO_RATE * 50 / 1000};
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--buffer") == 0 && i + 1 < argc) {
+      options.bufferSamples = (uint32_t)atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--press-ms") == 0 && i + 1 < argc) {
+      options.pressSamples =
+          (uint32_t)(atof(argv[++i]) * MOZZI_AUDIO_RATE / 1000.0);
+    } else {
+      printUsage();
+      return 2;
+    }
+  }
+
+  std::vector<ScriptTrigger> triggers;
+  std::string error;
+  if (!loadTriggerScript(argv[0], triggers, error)) {
+    fprintf(stderr, "%s\n", error.c_str());
+    return 1;
+  }
+
+  latencyProbeReset();
+  simulateTriggerLatency(triggers, options);
+  latencyProbeReport(printReportLine);
+  return 0;
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    printUsage();
+    return 2;
+  }
+
+  if (strcmp(argv[1], "render") == 0) {
+    return commandRender(argc - 2, argv + 2);
+  }
+  if (strcmp(argv[1], "golden") == 0) {
+    return commandGolden(argc - 2, argv + 2);
+  }
+  if (strcmp(argv[1], "latency") == 0) {
+    return commandLatency(argc - 2, argv + 2);
+  }
+  if (strcmp(argv[1], "stress") == 0) {
+    return commandStress(argc - 2, argv + 2);
+  }
+  if (strcmp(argv[1], "midi") == 0) {
+    return commandMidi(argc - 2, argv + 2);
+  }
+  if (strcmp(argv[1], "bench") == 0) {
+    runAudioBenchmarks(printReportLine);
+    return 0;
+  }
+  if (strcmp(argv[1], "uibench") == 0) {
+    return runUiBenchmarks(printReportLine) == 0 ? 0 : 1;
+  }
+  if (strcmp(argv[1], "cv") == 0) {
+    return runCvChecks(printReportLine) == 0 ? 0 : 1;
+  }
+  if (strcmp(argv[1], "serial") == 0) {
+    return runSerialChecks() == 0 ? 0 : 1;
+  }
+  if (strcmp(argv[1], "presets") == 0) {
+    return runPresetChecks() == 0 ? 0 : 1;
+  }
+  if (strcmp(argv[1], "oled") == 0) {
+    return runOledChecks() == 0 ? 0 : 1;
+  }
+  if (strcmp(argv[1], "fft") == 0) {
+    return runFftChecks() == 0 ? 0 : 1;
+  }
+
+  printUsage();
+  return 2;
+}
@@ -0,0 +1,85 @@
+/*
+  Host simulation of the trigger path - see latency_sim.h
+*/
+
+#include "latency_sim.h"
+
+#include <Mozzi.h>
+
+#include "../latency_probe.h"
+#include "../sample_engine.h"
+#include "../trigger_input.h"
+
+#define CONTROL_PERIOD (MOZZI_AUDIO_RATE / MOZZI_CONTROL_RATE)
+
+// Pad input level at an output sample time, given the scripted presses
+static int padReading(const std::vector<ScriptTrigger>& triggers, int voice,
+                      uint32_t now, uint32_t pressSamples) {
+  for (const ScriptTrigger& trigger : triggers) {
+    if (trigger.sample > now) break;
+    if (trigger.voice == voice && now < trigger.sample + pressSamples) {
+      return LOW;
+    }
+  }
+  return HIGH;
+}
+
+void simulateTriggerLatency(const std::vector<ScriptTrigger>& triggers,
+                            const LatencySimOptions& options) {
+  ButtonState buttons[NUM_VOICES];
+  for (int i = 0; i < NUM_VOICES; i++) {
+    buttons[i] = {-1, HIGH, HIGH, 0, false, samplePlayers[i].name};
+  }
+
+  stopAllSamples();
+  setEngineSampleClock(0);
+  setVoiceOnsetHandler(latencyProbeOnset);
+
+  uint32_t end = triggers.empty() ? 0 : triggers.back().sample;
+  end += options.pressSamples + MOZZI_AUDIO_RATE;  // Let the last hit sound
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  size_t nextEdge = 0;
+  uint32_t rendered = 0;  // Engine (render) clock
+  uint32_t played = 0;    // Output clock: samples the DAC has played
+
+  while (played < end) {
+    // Mozzi runs updateControl() every CONTROL_PERIOD rendered samples,
+    // while the DAC is a full buffer behind
+    if (rendered % CONTROL_PERIOD == 0) {
+      uint32_t now = rendered >= options.bufferSamples
+                         ? rendered - options.bufferSamples
+                         : 0;
+
+      // Pin interrupts fired at the exact edge time since the last tick
+      while (nextEdge < triggers.size() && triggers[nextEdge].sample <= now) {
+        latencyProbeMark(triggers[nextEdge].voice, LATENCY_EDGE,
+                         triggers[nextEdge].sample);
+        nextEdge++;
+      }
+
+      // updateButtons() + processButtonTriggers()
+      for (int i = 0; i < NUM_VOICES; i++) {
+        int reading = padReading(triggers, i, now, options.pressSamples);
+        unsigned long nowMs = (unsigned long)((uint64_t)now * 1000 / MOZZI_AUDIO_RATE);
+        if (debounceButton(buttons[i], reading, nowMs)) {
+          latencyProbeMark(i, LATENCY_DETECTED, now);
+          buttons[i].triggered = false;
+          triggerSample(i);
+          latencyProbeMark(i, LATENCY_TRIGGERED, now);
+        }
+      }
+    }
+
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+    rendered += AUDIO_BLOCK_SIZE;
+
+    // audioOutput() for every sample the DAC has now played
+    while (rendered - played > options.bufferSamples) {
+      latencyProbeOutput(played);
+      played++;
+    }
+  }
+
+  setVoiceOnsetHandler(nullptr);
+}
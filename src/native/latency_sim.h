@@ -0,0 +1,29 @@
+/*
+  Host simulation of the trigger path for the latency probes.
+
+  Scripted triggers become button presses on the output sample clock. The
+  simulation runs the firmware's control loop at MOZZI_CONTROL_RATE with the
+  shared debouncer, renders ahead of playback by a fixed Mozzi output buffer
+  depth, and feeds the same latency probes the module uses.
+*/
+
+#ifndef LATENCY_SIM_H
+#define LATENCY_SIM_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "trigger_script.h"
+
+struct LatencySimOptions {
+  uint32_t bufferSamples;  // Audio rendered ahead of the DAC
+  uint32_t pressSamples;   // How long each press holds the input LOW
+};
+
+// Run the triggers through the simulated control and audio path. Results
+// accumulate in the latency probe histograms.
+void simulateTriggerLatency(const std::vector<ScriptTrigger>& triggers,
+                            const LatencySimOptions& options);
+
+#endif  // LATENCY_SIM_H
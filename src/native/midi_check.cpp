@@ -0,0 +1,219 @@
+/*
+  MIDI parser checks - see midi_check.h
+*/
+
+#include "midi_check.h"
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "../midi_input.h"
+#include "../midi_parser.h"
+
+static const char* const padNames[NUM_VOICES] = {"kick", "snare", "hihat",
+                                                 "tom"};
+
+// The message as an "out" line body
+static std::string formatMessage(const MidiMessage& message) {
+  char text[64];
+  int ch = midiChannel(message);
+  int d0 = message.data[0];
+  int d1 = message.data[1];
+
+  switch (midiType(message)) {
+    case MIDI_NOTE_OFF:
+      snprintf(text, sizeof text, "note_off ch=%d note=%d vel=%d", ch, d0, d1);
+      break;
+    case MIDI_NOTE_ON:
+      snprintf(text, sizeof text, "note_on ch=%d note=%d vel=%d", ch, d0, d1);
+      break;
+    case MIDI_POLY_PRESSURE:
+      snprintf(text, sizeof text, "poly_pressure ch=%d note=%d value=%d", ch,
+               d0, d1);
+      break;
+    case MIDI_CONTROL_CHANGE:
+      snprintf(text, sizeof text, "control ch=%d number=%d value=%d", ch, d0,
+               d1);
+      break;
+    case MIDI_PROGRAM_CHANGE:
+      snprintf(text, sizeof text, "program ch=%d number=%d", ch, d0);
+      break;
+    case MIDI_CHANNEL_PRESSURE:
+      snprintf(text, sizeof text, "channel_pressure ch=%d value=%d", ch, d0);
+      break;
+    case MIDI_PITCH_BEND:
+      snprintf(text, sizeof text, "pitch_bend ch=%d value=%d", ch,
+               d0 | d1 << 7);
+      break;
+    case 0xF1:
+      snprintf(text, sizeof text, "mtc_quarter_frame value=%d", d0);
+      break;
+    case 0xF2:
+      snprintf(text, sizeof text, "song_position value=%d", d0 | d1 << 7);
+      break;
+    case 0xF3:
+      snprintf(text, sizeof text, "song_select number=%d", d0);
+      break;
+    case 0xF6:
+      return "tune_request";
+    case 0xF8:
+      return "clock";
+    case 0xFA:
+      return "start";
+    case 0xFB:
+      return "continue";
+    case 0xFC:
+      return "stop";
+    case 0xFE:
+      return "active_sensing";
+    case 0xFF:
+      return "reset";
+    default:
+      snprintf(text, sizeof text, "status=0x%02X", message.status);
+      break;
+  }
+  return text;
+}
+
+static std::string trim(const std::string& text) {
+  size_t start = text.find_first_not_of(" \t\r\n");
+  size_t end = text.find_last_not_of(" \t\r\n");
+  return start == std::string::npos ? "" : text.substr(start, end - start + 1);
+}
+
+// Run one case file; on failure error describes the first difference
+static bool checkMidiCase(const std::string& path, std::string& error) {
+  FILE* file = fopen(path.c_str(), "r");
+  if (!file) {
+    error = "cannot read " + path;
+    return false;
+  }
+
+  MidiParser parser;
+  midiParserReset(parser);
+  std::vector<std::string> expected, actual;
+  uint32_t clock = 0;
+  char line[256];
+  int lineNumber = 0;
+
+  while (fgets(line, sizeof line, file)) {
+    lineNumber++;
+    std::string text = line;
+    size_t comment = text.find('#');
+    if (comment != std::string::npos) text.erase(comment);
+    text = trim(text);
+    if (text.empty()) continue;
+
+    if (text.compare(0, 4, "out ") == 0 ||
+        text.compare(0, 8, "trigger ") == 0) {
+      expected.push_back(text);
+      continue;
+    }
+    if (text.compare(0, 3, "in ") != 0) {
+      error = "line " + std::to_string(lineNumber) + ": unknown keyword";
+      fclose(file);
+      return false;
+    }
+
+    const char* p = text.c_str() + 3;
+    while (*p) {
+      char* end;
+      if (*p == '@') {
+        clock = (uint32_t)strtoul(p + 1, &end, 10);
+      } else {
+        unsigned long byte = strtoul(p, &end, 16);
+        if (end == p || byte > 0xFF) {
+          error = "line " + std::to_string(lineNumber) + ": bad byte";
+          fclose(file);
+          return false;
+        }
+
+        MidiMessage message;
+        if (midiParse(parser, (uint8_t)byte, message)) {
+          actual.push_back("out " + formatMessage(message));
+          int pad;
+          uint8_t velocity;
+          if (midiNoteTrigger(message, pad, velocity)) {
+            char trigger[64];
+            snprintf(trigger, sizeof trigger, "trigger %s vel=%d at=%lu",
+                     padNames[pad], velocity,
+                     (unsigned long)(clock + MIDI_TRIGGER_DELAY));
+            actual.push_back(trigger);
+          }
+        }
+      }
+      p = end;
+      while (*p == ' ' || *p == '\t') p++;
+    }
+  }
+  fclose(file);
+
+  size_t length = std::max(expected.size(), actual.size());
+  for (size_t i = 0; i < length; i++) {
+    std::string want = i < expected.size() ? expected[i] : "(nothing)";
+    std::string got = i < actual.size() ? actual[i] : "(nothing)";
+    if (want != got) {
+      error = "line " + std::to_string(i + 1) + " of the output: expected \"" +
+              want + "\", got \"" + got + "\"";
+      return false;
+    }
+  }
+  return true;
+}
+
+int runMidiChecks(const std::string& directory) {
+  std::vector<std::string> names;
+  if (DIR* dir = opendir(directory.c_str())) {
+    while (struct dirent* entry = readdir(dir)) {
+      std::string file = entry->d_name;
+      if (file.size() > 4 && file.compare(file.size() - 4, 4, ".txt") == 0) {
+        names.push_back(file.substr(0, file.size() - 4));
+      }
+    }
+    closedir(dir);
+  }
+  std::sort(names.begin(), names.end());
+  if (names.empty()) {
+    printf("No MIDI cases (*.txt) in %s\n", directory.c_str());
+    return 1;
+  }
+
+  int failures = 0;
+  for (const std::string& name : names) {
+    std::string error;
+    if (checkMidiCase(directory + "/" + name + ".txt", error)) {
+      printf("ok   %s\n", name.c_str());
+    } else {
+      printf("FAIL %s: %s\n", name.c_str(), error.c_str());
+      failures++;
+    }
+  }
+
+  printf("%zu MIDI cases, %d failed\n", names.size(), failures);
+  return failures;
+}
+
+int decodeMidiFile(const std::string& path) {
+  FILE* file = fopen(path.c_str(), "rb");
+  if (!file) {
+    fprintf(stderr, "cannot read %s\n", path.c_str());
+    return 1;
+  }
+
+  MidiParser parser;
+  midiParserReset(parser);
+  int byte;
+  while ((byte = fgetc(file)) != EOF) {
+    MidiMessage message;
+    if (midiParse(parser, (uint8_t)byte, message)) {
+      printf("%s\n", formatMessage(message).c_str());
+    }
+  }
+  fclose(file);
+  return 0;
+}
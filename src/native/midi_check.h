@@ -0,0 +1,30 @@
+/*
+  MIDI parser checks against recorded byte streams.
+
+  A case file (<name>.txt in test/midi/) lists the bytes received and what
+  must come out of them:
+
+    # comment
+    in [@<sample>] <hex bytes>     bytes arriving at a sample clock (default
+                                   the previous in line's, starting at 0)
+    out <message>                  a parsed message, e.g. note_on ch=10
+                                   note=36 vel=100, clock, stop
+    trigger <pad> vel=<n> at=<n>   a pad the message triggers, and the
+                                   sample clock it is scheduled for
+
+  Bytes are fed one at a time through the firmware parser and note mapping,
+  and the out/trigger lines they produce must match the file in order.
+*/
+
+#ifndef MIDI_CHECK_H
+#define MIDI_CHECK_H
+
+#include <string>
+
+// Check every case in the directory, returning the number of failures
+int runMidiChecks(const std::string& directory);
+
+// Print the messages in a raw MIDI capture, one per line
+int decodeMidiFile(const std::string& path);
+
+#endif  // MIDI_CHECK_H
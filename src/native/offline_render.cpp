@@ -0,0 +1,50 @@
+/*
+  Offline rendering - see offline_render.h
+*/
+
+#include "offline_render.h"
+
+#include <Mozzi.h>
+
+#include "../sample_engine.h"
+
+void renderTriggers(const std::vector<ScriptTrigger>& triggers,
+                    uint32_t lengthSamples, std::vector<int16_t>& out) {
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(0);
+  out.clear();
+
+  size_t next = 0;
+  uint32_t sample = 0;
+  int8_t block[AUDIO_BLOCK_SIZE];
+  while (true) {
+    bool done = lengthSamples ? sample >= lengthSamples
+                              : next == triggers.size() && !anySamplePlaying();
+    if (done) break;
+
+    // Queue the block's triggers on their exact samples and render whole
+    // blocks, as updateAudio() does: envelopes and ramps step once per
+    // block, so shorter blocks would change the sound. A full queue leaves
+    // the rest for the next block.
+    uint32_t blockEnd = sample + AUDIO_BLOCK_SIZE;
+    while (next < triggers.size() && triggers[next].sample < blockEnd) {
+      if (!scheduleTrigger(triggers[next].voice, triggers[next].sample)) break;
+      next++;
+    }
+
+    hostClockSetSamples(sample);
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+
+    // Keep to the requested length
+    uint32_t count = AUDIO_BLOCK_SIZE;
+    if (lengthSamples && lengthSamples - sample < count) {
+      count = lengthSamples - sample;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+      AudioOutput output = MonoOutput::from8Bit(block[i]);
+      out.push_back((int16_t)output.l());
+    }
+    sample += AUDIO_BLOCK_SIZE;
+  }
+}
@@ -0,0 +1,20 @@
+/*
+  Offline rendering of trigger lists through the sample engine, as fast as
+  the host can run it.
+*/
+
+#ifndef OFFLINE_RENDER_H
+#define OFFLINE_RENDER_H
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "trigger_script.h"
+
+// Render the triggers from a silent, reset engine. With lengthSamples = 0 the
+// render runs until the last trigger has finished playing.
+void renderTriggers(const std::vector<ScriptTrigger>& triggers,
+                    uint32_t lengthSamples, std::vector<int16_t>& out);
+
+#endif  // OFFLINE_RENDER_H
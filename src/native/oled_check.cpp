@@ -0,0 +1,222 @@
+/*
+  OLED dirty-span checks - see oled_check.h
+*/
+
+#include "oled_check.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+
+#include "../oled_diff.h"
+
+static uint8_t previousFrame[OLED_FRAME_BYTES];
+static uint8_t currentFrame[OLED_FRAME_BYTES];
+static OledSpan spans[OLED_MAX_SPANS];
+
+// Small deterministic PRNG so failures reproduce
+struct OledRandom {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  uint32_t below(uint32_t limit) { return next() % limit; }
+};
+
+static void clearFrames() {
+  memset(previousFrame, 0, sizeof previousFrame);
+  memset(currentFrame, 0, sizeof currentFrame);
+}
+
+static void change(int page, int column) {
+  currentFrame[page * OLED_COLUMNS + column] ^= 0x5A;
+}
+
+static bool sameSpan(const OledSpan& span, int page, int first, int last) {
+  return span.page == page && span.firstColumn == first &&
+         span.lastColumn == last;
+}
+
+static std::string describe(int count) {
+  std::string text = std::to_string(count) + " windows";
+  for (int i = 0; i < count && i < 4; i++) {
+    text += " " + std::to_string(spans[i].page) + ":" +
+            std::to_string(spans[i].firstColumn) + "-" +
+            std::to_string(spans[i].lastColumn);
+  }
+  return text;
+}
+
+static bool checkUnchanged(std::string& error) {
+  clearFrames();
+  int count = planOledSpans(currentFrame, previousFrame, spans);
+  if (count != 0) {
+    error = describe(count);
+    return false;
+  }
+  return true;
+}
+
+static bool checkSingle(std::string& error) {
+  clearFrames();
+  change(2, 77);
+  int count = planOledSpans(currentFrame, previousFrame, spans);
+  if (count != 1 || !sameSpan(spans[0], 2, 77, 77)) {
+    error = describe(count);
+    return false;
+  }
+  return true;
+}
+
+static bool checkMerge(std::string& error) {
+  // Within the gap: one window. One column further: two.
+  clearFrames();
+  change(1, 10);
+  change(1, 10 + OLED_SPAN_MERGE_GAP);
+  int count = planOledSpans(currentFrame, previousFrame, spans);
+  if (count != 1 || !sameSpan(spans[0], 1, 10, 10 + OLED_SPAN_MERGE_GAP)) {
+    error = "within the gap: " + describe(count);
+    return false;
+  }
+
+  clearFrames();
+  change(1, 10);
+  change(1, 11 + OLED_SPAN_MERGE_GAP);
+  count = planOledSpans(currentFrame, previousFrame, spans);
+  if (count != 2 || !sameSpan(spans[0], 1, 10, 10) ||
+      !sameSpan(spans[1], 1, 11 + OLED_SPAN_MERGE_GAP,
+                11 + OLED_SPAN_MERGE_GAP)) {
+    error = "past the gap: " + describe(count);
+    return false;
+  }
+  return true;
+}
+
+static bool checkPageBoundary(std::string& error) {
+  // Adjacent in memory, but on two pages
+  clearFrames();
+  change(0, OLED_COLUMNS - 1);
+  change(1, 0);
+  int count = planOledSpans(currentFrame, previousFrame, spans);
+  if (count != 2 || !sameSpan(spans[0], 0, OLED_COLUMNS - 1, OLED_COLUMNS - 1) ||
+      !sameSpan(spans[1], 1, 0, 0)) {
+    error = describe(count);
+    return false;
+  }
+  return true;
+}
+
+static bool isWholePages(int count) {
+  if (count != OLED_PAGES) return false;
+  for (int page = 0; page < OLED_PAGES; page++) {
+    if (!sameSpan(spans[page], page, 0, OLED_COLUMNS - 1)) return false;
+  }
+  return true;
+}
+
+static bool checkFallback(std::string& error) {
+  // One window more than allowed: every other column spaced past the gap
+  clearFrames();
+  int changes = 0;
+  for (int page = 0; page < OLED_PAGES && changes <= OLED_MAX_SPANS; page++) {
+    for (int column = 0; column < OLED_COLUMNS && changes <= OLED_MAX_SPANS;
+         column += OLED_SPAN_MERGE_GAP + 1) {
+      change(page, column);
+      changes++;
+    }
+  }
+  int count = planOledSpans(currentFrame, previousFrame, spans);
+  if (!isWholePages(count)) {
+    error = "fragmented: " + describe(count);
+    return false;
+  }
+
+  clearFrames();
+  count = planOledSpans(currentFrame, nullptr, spans);
+  if (!isWholePages(count)) {
+    error = "unknown panel: " + describe(count);
+    return false;
+  }
+  return true;
+}
+
+static bool checkRandom(std::string& error) {
+  OledRandom random = {0x0DED};
+  for (int trial = 0; trial < 2000; trial++) {
+    clearFrames();
+    int changes = 1 + random.below(24);
+    for (int i = 0; i < changes; i++) {
+      change(random.below(OLED_PAGES), random.below(OLED_COLUMNS));
+    }
+    int count = planOledSpans(currentFrame, previousFrame, spans);
+
+    uint8_t covered[OLED_FRAME_BYTES] = {};
+    uint32_t bytes = 0;
+    for (int i = 0; i < count; i++) {
+      const OledSpan& span = spans[i];
+      if (span.page >= OLED_PAGES || span.firstColumn > span.lastColumn ||
+          span.lastColumn >= OLED_COLUMNS) {
+        error = "trial " + std::to_string(trial) + ": bad window";
+        return false;
+      }
+      if (i > 0 && spans[i - 1].page == span.page &&
+          span.firstColumn - spans[i - 1].lastColumn <=
+              OLED_SPAN_MERGE_GAP) {
+        error = "trial " + std::to_string(trial) + ": windows not merged";
+        return false;
+      }
+      for (int column = span.firstColumn; column <= span.lastColumn;
+           column++) {
+        covered[span.page * OLED_COLUMNS + column] = 1;
+      }
+      bytes += oledSpanBytes(span.lastColumn - span.firstColumn + 1);
+    }
+    for (int i = 0; i < OLED_FRAME_BYTES; i++) {
+      if (currentFrame[i] != previousFrame[i] && !covered[i]) {
+        error = "trial " + std::to_string(trial) + ": change not sent";
+        return false;
+      }
+    }
+    if (bytes > OLED_PAGES * oledSpanBytes(OLED_COLUMNS)) {
+      error = "trial " + std::to_string(trial) + ": " +
+              std::to_string(bytes) + " bytes, more than a full frame";
+      return false;
+    }
+  }
+  return true;
+}
+
+int runOledChecks() {
+  struct Check {
+    const char* name;
+    bool (*run)(std::string& error);
+  };
+  const Check checks[] = {
+      {"unchanged", checkUnchanged},
+      {"single", checkSingle},
+      {"merge", checkMerge},
+      {"page_boundary", checkPageBoundary},
+      {"fallback", checkFallback},
+      {"random", checkRandom},
+  };
+
+  int failures = 0;
+  for (const Check& check : checks) {
+    std::string error;
+    if (check.run(error)) {
+      printf("ok   %s\n", check.name);
+    } else {
+      printf("FAIL %s: %s\n", check.name, error.c_str());
+      failures++;
+    }
+  }
+  printf("%zu OLED checks, %d failed\n", sizeof checks / sizeof checks[0],
+         failures);
+  return failures;
+}
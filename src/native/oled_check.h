@@ -0,0 +1,27 @@
+/*
+  OLED dirty-span checks.
+
+  Builds frame pairs with known differences and checks the windows
+  planOledSpans() picks for them:
+
+    - identical frames send nothing
+    - a single changed byte is one window of one column on its page
+    - changes up to OLED_SPAN_MERGE_GAP columns apart share a window, and
+      changes further apart do not
+    - windows never cross a page, even for changes on either side of a
+      page boundary
+    - more than OLED_MAX_SPANS windows, or unknown panel contents, fall
+      back to one whole-page window per page
+    - on random frames every changed byte is inside a window, windows on a
+      page are ordered and apart, and they cost no more than a full frame
+
+  Prints "ok   <name>" or "FAIL <name>: <reason>" per check.
+*/
+
+#ifndef OLED_CHECK_H
+#define OLED_CHECK_H
+
+// Returns the number of failed checks
+int runOledChecks();
+
+#endif  // OLED_CHECK_H
@@ -0,0 +1,384 @@
+/*
+  Preset store checks - see preset_check.h
+*/
+
+#include "preset_check.h"
+
+#include <Mozzi.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+
+#include "../cv_input.h"
+#include "../preset_store.h"
+
+// Simulated flash, the area preset_store.cpp sees on the host
+static uint8_t simFlash[PRESET_FLASH_BYTES];
+static uint32_t simErases[PRESET_SECTORS];
+static uint32_t simOperations = 0;  // Erases and programs so far
+static uint32_t simFaults = 0;      // Programs onto pages not erased
+static int64_t simCutAt = -1;       // Operation the power fails during
+static bool simPowerLost = false;
+
+// Small deterministic PRNG so failures reproduce
+struct PresetRandom {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  uint32_t below(uint32_t limit) { return next() % limit; }
+};
+
+static PresetRandom simRandom = {0x5EED};
+
+// True if the power fails during this operation
+static bool simCut() {
+  bool cut = (int64_t)simOperations == simCutAt;
+  simOperations++;
+  if (cut) {
+    simCutAt = -1;
+    simPowerLost = true;
+  }
+  return cut;
+}
+
+const uint8_t* presetFlashData() { return simFlash; }
+
+size_t presetFlashSize() { return sizeof simFlash; }
+
+void presetFlashErase(int sector) {
+  uint8_t* data = simFlash + sector * PRESET_SECTOR_BYTES;
+  simErases[sector]++;
+  if (!simCut()) {
+    memset(data, 0xFF, PRESET_SECTOR_BYTES);
+    return;
+  }
+  // Cut short: some pages erased, one of them only partly
+  int pages = simRandom.below(PRESET_SECTOR_PAGES);
+  memset(data, 0xFF, pages * PRESET_PAGE_BYTES);
+  for (int i = 0; i < PRESET_PAGE_BYTES; i++) {
+    data[pages * PRESET_PAGE_BYTES + i] |= simRandom.next();
+  }
+}
+
+void presetFlashProgram(int page, const uint8_t* data) {
+  uint8_t* flash = simFlash + page * PRESET_PAGE_BYTES;
+  for (int i = 0; i < PRESET_PAGE_BYTES; i++) {
+    if ((flash[i] & data[i]) != data[i]) {
+      simFaults++;
+      break;
+    }
+  }
+  // Bits only ever go from 1 to 0; a cut program stops part way through
+  int length = PRESET_PAGE_BYTES;
+  if (simCut()) length = simRandom.below(PRESET_PAGE_BYTES);
+  for (int i = 0; i < length; i++) flash[i] &= data[i];
+  if (length < PRESET_PAGE_BYTES) {
+    flash[length] &= data[length] | simRandom.next();
+  }
+}
+
+// Fresh, erased flash and a mounted store
+static bool simReset() {
+  memset(simFlash, 0xFF, sizeof simFlash);
+  memset(simErases, 0, sizeof simErases);
+  simOperations = 0;
+  simFaults = 0;
+  simCutAt = -1;
+  simPowerLost = false;
+  return presetStoreBegin();
+}
+
+static bool sameSettings(const PresetSettings& a, const PresetSettings& b) {
+  if (a.cvTarget != b.cvTarget) return false;
+  for (int v = 0; v < NUM_VOICES; v++) {
+    const VoiceSettings& x = a.voices[v];
+    const VoiceSettings& y = b.voices[v];
+    if (x.pitch != y.pitch || x.decay != y.decay || x.level != y.level ||
+        x.sample != y.sample) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Settings as the engine and CV inputs hold them now
+static PresetSettings currentSettings() {
+  PresetSettings settings = {};
+  for (int v = 0; v < NUM_VOICES; v++) settings.voices[v] = voiceSettings(v);
+  settings.cvTarget = cvInputTarget();
+  return settings;
+}
+
+static PresetSettings randomizeSettings(PresetRandom& random) {
+  cvInputSetTarget(random.below(1 << NUM_VOICES));
+  for (int v = 0; v < NUM_VOICES; v++) {
+    VoiceSettings settings;
+    settings.pitch = random.below(PITCH_MAX + 1);
+    settings.decay = random.below(DECAY_NONE + 1);
+    settings.level = random.below(LEVEL_UNITY + 1);
+    settings.sample = random.below(NUM_SAMPLES);
+    setVoiceSettings(v, settings);
+  }
+  return currentSettings();
+}
+
+static void restoreDefaults() {
+  cvInputSetTarget((1 << NUM_VOICES) - 1);
+  for (int v = 0; v < NUM_VOICES; v++) {
+    setVoiceSettings(v, {PITCH_UNITY, DECAY_NONE, LEVEL_UNITY, (uint8_t)v});
+  }
+}
+
+// The store's side of one loop() pass
+static bool moreThanOneOperation = false;
+
+static void service(bool silent) {
+  uint32_t before = simOperations;
+  presetStoreService(silent);
+  if (simOperations - before > 1) moreThanOneOperation = true;
+}
+
+// Save a slot and service the store until the record is written. Returns
+// false if the power failed first.
+static bool saveSlot(int slot, PresetRandom& random, uint32_t silentOneIn) {
+  if (!presetSave(slot)) return false;
+  for (int calls = 0; presetSavePending(); calls++) {
+    if (calls > 4 * PRESET_SECTOR_PAGES) return false;
+    service(silentOneIn && random.below(silentOneIn) == 0);
+    if (simPowerLost) return false;
+  }
+  return true;
+}
+
+// Every slot reads back as the model has it
+static bool checkSlots(const PresetSettings* model, const bool* saved,
+                       std::string& error) {
+  for (int slot = 0; slot < PRESET_SLOTS; slot++) {
+    PresetSettings stored;
+    bool found = presetRead(slot, stored);
+    if (found != saved[slot] ||
+        (found && !sameSettings(stored, model[slot]))) {
+      error = "slot " + std::to_string(slot) + (found ? " differs" : " lost");
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkRoundTrip(std::string& error) {
+  PresetRandom random = {1};
+  simReset();
+  PresetSettings model[PRESET_SLOTS];
+  bool saved[PRESET_SLOTS] = {};
+  for (int slot = 0; slot < PRESET_SLOTS; slot += 2) {
+    model[slot] = randomizeSettings(random);
+    saved[slot] = saveSlot(slot, random, 1);
+  }
+  if (!checkSlots(model, saved, error)) return false;
+
+  // Recall applies the settings, for every voice and the CV target
+  for (int slot = 0; slot < PRESET_SLOTS; slot += 2) {
+    randomizeSettings(random);
+    if (!presetRecall(slot) || !sameSettings(currentSettings(), model[slot])) {
+      error = "recall of slot " + std::to_string(slot) + " differs";
+      return false;
+    }
+  }
+  if (presetRecall(1)) {
+    error = "recalled a slot never saved";
+    return false;
+  }
+
+  presetStoreBegin();
+  if (!checkSlots(model, saved, error)) {
+    error += " after a remount";
+    return false;
+  }
+  return true;
+}
+
+// Many saves; returns false with error set if any check fails
+static bool runSaves(int saves, uint32_t silentOneIn, PresetRandom& random,
+                     std::string& error) {
+  simReset();
+  PresetStoreStats before = presetStoreStats();
+  PresetSettings model[PRESET_SLOTS];
+  bool saved[PRESET_SLOTS] = {};
+  for (int i = 0; i < saves; i++) {
+    // Mostly the same two slots, so wear-levelling has work to do
+    int slot = random.below(4) ? random.below(2) : random.below(PRESET_SLOTS);
+    model[slot] = randomizeSettings(random);
+    if (!saveSlot(slot, random, silentOneIn)) {
+      error = "save " + std::to_string(i) + " never completed";
+      return false;
+    }
+    saved[slot] = true;
+
+    // loop() passes before the next save, some while the module is quiet
+    for (int pass = 0; pass < 4; pass++) {
+      service(silentOneIn && random.below(silentOneIn) == 0);
+    }
+    if (i % 997 == 0) presetStoreBegin();  // An occasional power cycle
+  }
+  presetStoreBegin();
+  if (!checkSlots(model, saved, error)) return false;
+
+  PresetStoreStats after = presetStoreStats();
+  uint32_t forced = after.forcedErases - before.forcedErases;
+  if (silentOneIn && forced) {
+    error = std::to_string(forced) + " erases did not wait for silence";
+    return false;
+  }
+  if (!silentOneIn && forced != after.erases - before.erases) {
+    error = "an erase was not counted as forced";
+    return false;
+  }
+  if (simFaults) {
+    error = std::to_string(simFaults) + " programs onto unerased pages";
+    return false;
+  }
+  return true;
+}
+
+static bool checkWear(std::string& error) {
+  PresetRandom random = {2};
+  int saves = 20000;
+  PresetStoreStats before = presetStoreStats();
+  if (!runSaves(saves, 4, random, error)) return false;
+
+  uint32_t low = *std::min_element(simErases, simErases + PRESET_SECTORS);
+  uint32_t high = *std::max_element(simErases, simErases + PRESET_SECTORS);
+  PresetStoreStats after = presetStoreStats();
+  printf("     %d saves, %u records, %u erases, per sector:", saves,
+         after.records - before.records, after.erases - before.erases);
+  for (int s = 0; s < PRESET_SECTORS; s++) printf(" %u", simErases[s]);
+  printf("\n");
+  if (high - low > 1) {
+    error = "sector erases range from " + std::to_string(low) + " to " +
+            std::to_string(high);
+    return false;
+  }
+  return true;
+}
+
+static bool checkNeverSilent(std::string& error) {
+  PresetRandom random = {3};
+  if (!runSaves(2000, 0, random, error)) return false;
+  if (presetStoreStats().forcedErases == 0) {
+    error = "no erase was forced";
+    return false;
+  }
+  return true;
+}
+
+static bool checkPowerCuts(std::string& error) {
+  PresetRandom random = {4};
+  simReset();
+  PresetSettings model[PRESET_SLOTS];
+  bool saved[PRESET_SLOTS] = {};
+  int cuts = 0;
+  for (int i = 0; i < 5000; i++) {
+    int slot = random.below(PRESET_SLOTS);
+    PresetSettings wanted = randomizeSettings(random);
+
+    // Fail during one of the next few operations: the save itself, or a
+    // copy or erase it sets off
+    simCutAt = simOperations + random.below(3);
+    if (saveSlot(slot, random, 3)) {
+      model[slot] = wanted;
+      saved[slot] = true;
+    }
+    for (int extra = 0; extra < 4 && !simPowerLost; extra++) {
+      service(random.below(3) == 0);
+    }
+    simCutAt = -1;
+    if (!simPowerLost) continue;
+
+    // Reboot: the save in flight may or may not have made it
+    cuts++;
+    simPowerLost = false;
+    presetStoreBegin();
+    PresetSettings stored;
+    if (presetRead(slot, stored) && sameSettings(stored, wanted)) {
+      model[slot] = wanted;
+      saved[slot] = true;
+    }
+    if (!checkSlots(model, saved, error)) {
+      error += " after cut " + std::to_string(cuts);
+      return false;
+    }
+  }
+  if (simFaults) {
+    error = std::to_string(simFaults) + " programs onto unerased pages";
+    return false;
+  }
+  if (cuts < 1000) {
+    error = "only " + std::to_string(cuts) + " power cuts happened";
+    return false;
+  }
+  return true;
+}
+
+static bool checkRecallTime(std::string& error) {
+  PresetRandom random = {5};
+  simReset();
+  for (int slot = 0; slot < PRESET_SLOTS; slot++) {
+    randomizeSettings(random);
+    saveSlot(slot, random, 2);
+  }
+
+  int recalls = 100000;
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < recalls; i++) presetRecall(i % PRESET_SLOTS);
+  auto end = std::chrono::steady_clock::now();
+  double ns =
+      std::chrono::duration<double, std::nano>(end - start).count() / recalls;
+  double blockNs = 1e9 * AUDIO_BLOCK_SIZE / MOZZI_AUDIO_RATE;
+  printf("     recall %.0fns on this host, audio block %.0fns\n", ns, blockNs);
+  if (ns > blockNs) {
+    error = "recall takes longer than an audio block";
+    return false;
+  }
+  return true;
+}
+
+int runPresetChecks() {
+  struct Check {
+    const char* name;
+    bool (*run)(std::string& error);
+  };
+  const Check checks[] = {
+      {"round_trip", checkRoundTrip},   {"wear", checkWear},
+      {"never_silent", checkNeverSilent}, {"power_cuts", checkPowerCuts},
+      {"recall_time", checkRecallTime},
+  };
+
+  int failures = 0;
+  for (const Check& check : checks) {
+    std::string error;
+    if (check.run(error)) {
+      printf("ok   %s\n", check.name);
+    } else {
+      printf("FAIL %s: %s\n", check.name, error.c_str());
+      failures++;
+    }
+  }
+  if (moreThanOneOperation) {
+    printf("FAIL service: a call did more than one flash operation\n");
+    failures++;
+  }
+  restoreDefaults();
+
+  printf("%zu preset checks, %d failed\n", sizeof checks / sizeof checks[0],
+         failures);
+  return failures;
+}
@@ -0,0 +1,29 @@
+/*
+  Preset store checks against a simulated flash.
+
+  The simulation keeps NOR flash rules: erase sets a sector to 0xFF,
+  programming can only clear bits, and programming a page that is not
+  erased counts as a fault. It can cut the power part way through an
+  erase or program, after which the store remounts from what is left.
+  Checks:
+
+    - every slot recalls what was saved, before and after a remount
+    - 20000 saves weighted onto a few slots wear all sectors evenly,
+      with no erase before a silent moment unless the log needed it
+    - with audio never silent, erases are forced and still correct
+    - power cuts during any flash operation lose at most the save in
+      progress, never an older one
+    - each service call does at most one flash operation, and a recall
+      fits easily in one audio block
+
+  Prints "ok   <name>" or "FAIL <name>: <reason>" per check, then the
+  erase count of every sector.
+*/
+
+#ifndef PRESET_CHECK_H
+#define PRESET_CHECK_H
+
+// Returns the number of failed checks
+int runPresetChecks();
+
+#endif  // PRESET_CHECK_H
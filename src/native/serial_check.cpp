@@ -0,0 +1,329 @@
+/*
+  Serial protocol checks - see serial_check.h
+*/
+
+#include "serial_check.h"
+
+#include <stdio.h>
+
+#include <string>
+#include <vector>
+
+#include "../serial_protocol.h"
+
+typedef std::vector<uint8_t> Bytes;
+
+// What the receiver made of a byte stream
+struct Received {
+  std::vector<SerialCommand> commands;
+  std::string keys;
+  int frames = 0;
+  int badFrames = 0;
+};
+
+static Bytes encode(const Bytes& payload) {
+  Bytes frame(SERIAL_ENCODED_MAX(payload.size()));
+  frame.resize(serialEncodeFrame(payload.data(), payload.size(), frame.data()));
+  return frame;
+}
+
+static void feed(SerialLink& link, const Bytes& bytes, Received& received) {
+  for (uint8_t byte : bytes) {
+    switch (serialLinkByte(link, byte)) {
+      case SERIAL_KEY:
+        received.keys += (char)byte;
+        break;
+      case SERIAL_FRAME: {
+        received.frames++;
+        SerialCommand command;
+        while (serialNextCommand(link, command)) {
+          received.commands.push_back(command);
+        }
+        break;
+      }
+      case SERIAL_BAD_FRAME:
+        received.badFrames++;
+        break;
+      case SERIAL_NONE:
+        break;
+    }
+  }
+
+  // Each call is one burst; the port goes quiet after it
+  int keys = serialLinkIdle(link);
+  received.keys.append((const char*)link.buffer, keys);
+}
+
+static void addTrigger(Bytes& payload, int pad, int velocity, uint32_t at) {
+  payload.insert(payload.end(),
+                 {SERIAL_CMD_TRIGGER, (uint8_t)pad, (uint8_t)velocity,
+                  (uint8_t)at, (uint8_t)(at >> 8), (uint8_t)(at >> 16),
+                  (uint8_t)(at >> 24)});
+}
+
+static bool sameTrigger(const SerialCommand& command, int pad, int velocity,
+                        uint32_t at) {
+  return command.opcode == SERIAL_CMD_TRIGGER && command.target == pad &&
+         command.detail == velocity && command.value == at;
+}
+
+static bool checkCrc(std::string& error) {
+  const char* text = "123456789";
+  uint16_t crc = serialCrc16((const uint8_t*)text, 9);
+  if (crc != 0x29B1) {
+    char message[64];
+    snprintf(message, sizeof message, "got 0x%04X, expected 0x29B1", crc);
+    error = message;
+    return false;
+  }
+  return true;
+}
+
+static bool checkZeros(std::string& error) {
+  SerialLink link;
+  serialLinkReset(link);
+  Received received;
+
+  // Zeros everywhere: clock 0, pad 0, and a clock with zero bytes inside
+  Bytes payload;
+  addTrigger(payload, 0, 0, 0);
+  addTrigger(payload, 3, 127, 0x01000100);
+  Bytes frame = encode(payload);
+  for (size_t i = 1; i + 1 < frame.size(); i++) {
+    if (frame[i] == 0) {
+      error = "zero byte inside the encoded frame";
+      return false;
+    }
+  }
+
+  feed(link, frame, received);
+  if (received.commands.size() != 2 ||
+      !sameTrigger(received.commands[0], 0, 0, 0) ||
+      !sameTrigger(received.commands[1], 3, 127, 0x01000100)) {
+    error = "triggers changed on the way through";
+    return false;
+  }
+  return true;
+}
+
+static bool checkBatch(std::string& error) {
+  SerialLink link;
+  serialLinkReset(link);
+  Received received;
+
+  // As many triggers as one frame holds
+  int count = (SERIAL_FRAME_MAX - 2) / 7;
+  Bytes payload;
+  for (int i = 0; i < count; i++) addTrigger(payload, i % 4, i, 1000 + i * 16);
+  feed(link, encode(payload), received);
+
+  if ((int)received.commands.size() != count) {
+    error = "got " + std::to_string(received.commands.size()) + " of " +
+            std::to_string(count) + " triggers";
+    return false;
+  }
+  for (int i = 0; i < count; i++) {
+    if (!sameTrigger(received.commands[i], i % 4, i, 1000 + i * 16)) {
+      error = "trigger " + std::to_string(i) + " differs";
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkLongRun(std::string& error) {
+  SerialLink link;
+  serialLinkReset(link);
+  Received received;
+
+  // No zeros at all, so COBS has to split the run at 254 bytes
+  int count = (SERIAL_FRAME_MAX - 2) / 7;
+  Bytes payload;
+  for (int i = 0; i < count; i++) {
+    payload.insert(payload.end(), {SERIAL_CMD_SET, SERIAL_PARAM_SWING, 1, 0x3A,
+                                   0x01, 0x01, 0x01});
+  }
+  feed(link, encode(payload), received);
+
+  if ((int)received.commands.size() != count) {
+    error = "got " + std::to_string(received.commands.size()) + " of " +
+            std::to_string(count) + " commands";
+    return false;
+  }
+  for (const SerialCommand& command : received.commands) {
+    if (command.opcode != SERIAL_CMD_SET ||
+        command.target != SERIAL_PARAM_SWING || command.detail != 1 ||
+        command.value != 0x0101013A) {
+      error = "command changed on the way through";
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkRejects(std::string& error) {
+  Bytes good;
+  addTrigger(good, 1, 100, 5000);
+  Bytes goodFrame = encode(good);
+
+  Bytes corrupt = goodFrame;
+  corrupt[4] ^= 0x10;
+
+  Bytes truncated = goodFrame;
+  truncated.erase(truncated.end() - 3, truncated.end() - 1);
+
+  Bytes unknown = good;
+  unknown.push_back(0x7F);
+  Bytes unknownFrame = encode(unknown);
+
+  Bytes partial = good;  // A trigger missing its last argument byte
+  partial.pop_back();
+  Bytes partialFrame = encode(partial);
+
+  Bytes oversized(SERIAL_FRAME_MAX + 40, 0x55);
+  oversized.front() = 0;
+  oversized.back() = 0;
+
+  const Bytes* bad[] = {&corrupt, &truncated, &unknownFrame, &partialFrame,
+                        &oversized};
+  const char* names[] = {"corrupt", "truncated", "unknown command",
+                         "partial command", "oversized"};
+  for (int i = 0; i < 5; i++) {
+    SerialLink link;
+    serialLinkReset(link);
+    Received received;
+    feed(link, *bad[i], received);
+    feed(link, goodFrame, received);
+    if (received.badFrames != 1 || received.frames != 1 ||
+        received.commands.size() != 1 ||
+        !sameTrigger(received.commands[0], 1, 100, 5000)) {
+      error = std::string(names[i]) + " frame not dropped cleanly";
+      return false;
+    }
+    if (!received.keys.empty()) {
+      error = std::string(names[i]) + " frame leaked key presses";
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkKeys(std::string& error) {
+  SerialLink link;
+  serialLinkReset(link);
+  Received received;
+
+  // The payload bytes spell out keys; none may escape the frame
+  Bytes payload;
+  addTrigger(payload, 2, 'b', 0x74737062);  // "bpst" little-endian
+  Bytes stream = {'p', '+'};
+  Bytes frame = encode(payload);
+  stream.insert(stream.end(), frame.begin(), frame.end());
+  stream.insert(stream.end(), {'w', '\n'});
+  feed(link, stream, received);
+
+  if (received.keys != "p+w\n" || received.commands.size() != 1) {
+    error = "keys \"" + received.keys + "\"";
+    return false;
+  }
+  return true;
+}
+
+static bool checkResync(std::string& error) {
+  // A frame losing its closing zero, or its tail, runs into the next
+  // frame's opening zero. The frames after it must arrive as frames: their
+  // bytes would otherwise run as key commands (erase, bench, play, clock).
+  const char* names[] = {"lost zero", "cut short"};
+  const int cut[] = {1, 4};
+  const int expectedFrames[] = {10, 9};
+  for (int variant = 0; variant < 2; variant++) {
+    SerialLink link;
+    serialLinkReset(link);
+    Received received;
+    Bytes stream;
+    for (int i = 0; i < 10; i++) {
+      Bytes payload;
+      addTrigger(payload, i % 4, 100, 'e' | 'b' << 8 | 'p' << 16 | 'c' << 24);
+      Bytes frame = encode(payload);
+      if (i == 0) frame.resize(frame.size() - cut[variant]);
+      stream.insert(stream.end(), frame.begin(), frame.end());
+    }
+    feed(link, stream, received);
+    feed(link, {'w', '\n'}, received);
+
+    int expected = expectedFrames[variant];
+    if (received.frames != expected || received.badFrames != 10 - expected ||
+        (int)received.commands.size() != expected || received.keys != "w\n") {
+      error = std::string(names[variant]) + ": " +
+              std::to_string(received.frames) + " frames, " +
+              std::to_string(received.badFrames) + " bad, keys \"" +
+              received.keys + "\"";
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool checkBackToBack(std::string& error) {
+  SerialLink link;
+  serialLinkReset(link);
+  Received received;
+
+  // Frames sent back to back share nothing: 00 frame 00 00 frame 00
+  Bytes stream;
+  for (int i = 0; i < 100; i++) {
+    Bytes payload;
+    addTrigger(payload, i % 4, 64, i);
+    payload.push_back(SERIAL_CMD_STATS);
+    Bytes frame = encode(payload);
+    stream.insert(stream.end(), frame.begin(), frame.end());
+  }
+  feed(link, stream, received);
+
+  if (received.frames != 100 || received.commands.size() != 200 ||
+      link.framesOk != 100 || link.framesBad != 0 || !received.keys.empty()) {
+    error = std::to_string(received.frames) + " frames, " +
+            std::to_string(received.commands.size()) + " commands";
+    return false;
+  }
+  return true;
+}
+
+int runSerialChecks() {
+  struct Check {
+    const char* name;
+    bool (*run)(std::string& error);
+  };
+  const Check checks[] = {
+      {"crc", checkCrc},
+      {"zeros", checkZeros},
+      {"batch", checkBatch},
+      {"long_run", checkLongRun},
+      {"rejects", checkRejects},
+      {"keys", checkKeys},
+      {"resync", checkResync},
+      {"back_to_back", checkBackToBack},
+  };
+
+  int failures = 0;
+  for (const Check& check : checks) {
+    std::string error;
+    if (check.run(error)) {
+      printf("ok   %s\n", check.name);
+    } else {
+      printf("FAIL %s: %s\n", check.name, error.c_str());
+      failures++;
+    }
+  }
+
+  // Wire cost of a full batch, for event rate planning
+  int count = (SERIAL_FRAME_MAX - 2) / 7;
+  Bytes payload;
+  for (int i = 0; i < count; i++) addTrigger(payload, 0, 100, 1 << 20);
+  printf("%d triggers per frame, %zu bytes on the wire (%.1f per trigger)\n",
+         count, encode(payload).size(), (double)encode(payload).size() / count);
+
+  printf("%zu serial checks, %d failed\n", sizeof checks / sizeof checks[0],
+         failures);
+  return failures;
+}
@@ -0,0 +1,29 @@
+/*
+  Serial protocol checks.
+
+  Builds frames with the firmware encoder and feeds them byte by byte
+  through the receiver, checking:
+
+    - the CRC against the CRC-16/CCITT-FALSE check value
+    - payloads full of zeros, and with no zeros for longer than one COBS
+      block, round-trip
+    - a full batch of triggers arrives intact and in order
+    - corrupt, truncated, oversized and unknown-command frames are dropped
+      whole and the next frame is still received
+    - one-key commands outside frames pass through, bytes inside do not
+    - a frame that loses its closing zero or its tail costs at most
+      itself; none of the frames after it become key presses
+    - a frame that loses its closing zero costs only itself and the frame
+      after it; later frames arrive and none of their bytes become keys
+
+  Prints "ok   <name>" or "FAIL <name>: <reason>" per check, then the wire
+  cost of a batch of triggers.
+*/
+
+#ifndef SERIAL_CHECK_H
+#define SERIAL_CHECK_H
+
+// Returns the number of failed checks
+int runSerialChecks();
+
+#endif  // SERIAL_CHECK_H
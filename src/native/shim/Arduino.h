@@ -0,0 +1,42 @@
+/*
+  Minimal Arduino shim for the native host build.
+
+  Only what the shared engine code and the sample headers need is provided:
+  PROGMEM / pgm_read_byte (flash is ordinary memory on the host) and a
+  millis()/micros() clock that follows the offline render position rather
+  than the wall clock, so timing behaves as it would on the module.
+
+  pgm_read_byte can also check every read against registered PROGMEM arrays,
+  which the stress harness uses to catch out-of-bounds sample reads.
+*/
+
+#ifndef SAMPLER_NATIVE_ARDUINO_H
+#define SAMPLER_NATIVE_ARDUINO_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define F(s) (s)
+
+#define HIGH 1
+#define LOW 0
+
+// PROGMEM bounds checking (see arduino_shim.cpp)
+extern bool hostProgmemChecking;
+void hostProgmemCheckRead(const void* addr);
+void hostProgmemRegisterRegion(const void* start, size_t length);
+uint32_t hostProgmemViolations();
+
+inline uint8_t pgm_read_byte(const void* addr) {
+  if (hostProgmemChecking) hostProgmemCheckRead(addr);
+  return *(const uint8_t*)addr;
+}
+
+// Host clock, advanced by the offline renderer (see arduino_shim.cpp)
+unsigned long millis();
+unsigned long micros();
+void hostClockSetSamples(uint64_t samples);
+
+#endif  // SAMPLER_NATIVE_ARDUINO_H
@@ -0,0 +1,42 @@
+/*
+  Minimal Mozzi shim for the native host build.
+
+  Mirrors the Mozzi 2.0 MonoOutput scaling for MOZZI_AUDIO_BITS = 16 so the
+  host renders exactly the values audioOutput() receives on the module.
+*/
+
+#ifndef SAMPLER_NATIVE_MOZZI_H
+#define SAMPLER_NATIVE_MOZZI_H
+
+#include <Arduino.h>
+
+#ifndef MOZZI_AUDIO_RATE
+#define MOZZI_AUDIO_RATE 16384
+#endif
+
+#ifndef MOZZI_CONTROL_RATE
+#define MOZZI_CONTROL_RATE 64
+#endif
+
+#define MOZZI_AUDIO_BITS 16
+
+struct MonoOutput {
+  MonoOutput(int32_t l = 0) : _l(l) {}
+
+  // Scale an N-bit sample up to MOZZI_AUDIO_BITS, as Mozzi's fromNBit() does
+  static MonoOutput fromNBit(uint8_t bits, int32_t l) {
+    return MonoOutput(l << (MOZZI_AUDIO_BITS - bits));
+  }
+  static MonoOutput from8Bit(int16_t l) { return fromNBit(8, l); }
+  static MonoOutput from16Bit(int16_t l) { return MonoOutput(l); }
+
+  int32_t l() const { return _l; }
+  int32_t r() const { return _l; }
+
+ private:
+  int32_t _l;
+};
+
+typedef MonoOutput AudioOutput;
+
+#endif  // SAMPLER_NATIVE_MOZZI_H
@@ -0,0 +1,918 @@
+/*
+  Randomized stress harness - see stress_harness.h
+*/
+
+#include "stress_harness.h"
+
+#include <Mozzi.h>
+#include <stdio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+#include "../clock_input.h"
+#include "../cycle_counter.h"
+#include "../latency_probe.h"
+#include "../sample_engine.h"
+#include "../smoothed_param.h"
+#include "../sequencer.h"
+#include "trigger_script.h"
+
+// Small deterministic PRNG so failures reproduce from the seed
+struct StressRandom {
+  uint32_t state;
+
+  uint32_t next() {
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+  }
+
+  uint32_t below(uint32_t limit) { return next() % limit; }
+};
+
+typedef void (*StressGenerator)(StressRandom& random, uint32_t length,
+                                std::vector<ScriptTrigger>& triggers);
+
+// Dense random hits, ~10x a busy drum part
+static void generateRandom(StressRandom& random, uint32_t length,
+                           std::vector<ScriptTrigger>& triggers) {
+  for (uint32_t t = 0; t < length; t += 1 + random.below(400)) {
+    triggers.push_back({t, (int)random.below(NUM_VOICES)});
+  }
+}
+
+// Rolls: one pad retriggered every 1-64 samples, ~100x real playing
+static void generateRolls(StressRandom& random, uint32_t length,
+                          std::vector<ScriptTrigger>& triggers) {
+  int voice = 0;
+  for (uint32_t t = 0; t < length; t += 1 + random.below(64)) {
+    if (random.below(256) == 0) voice = random.below(NUM_VOICES);
+    triggers.push_back({t, voice});
+  }
+}
+
+// Flams: pairs of hits 0-32 samples apart, including the same pad twice
+static void generateFlams(StressRandom& random, uint32_t length,
+                          std::vector<ScriptTrigger>& triggers) {
+  for (uint32_t t = 0; t + 32 < length; t += 200 + random.below(2000)) {
+    triggers.push_back({t, (int)random.below(NUM_VOICES)});
+    triggers.push_back({t + random.below(33), (int)random.below(NUM_VOICES)});
+  }
+}
+
+// Every pad on the same sample, at random spacing down to one sample
+static void generateAllPads(StressRandom& random, uint32_t length,
+                            std::vector<ScriptTrigger>& triggers) {
+  for (uint32_t t = 0; t < length; t += 1 + random.below(2000)) {
+    for (int v = 0; v < NUM_VOICES; v++) triggers.push_back({t, v});
+  }
+}
+
+// Sparse hits with long gaps, so every voice retires between triggers
+static void generateSparse(StressRandom& random, uint32_t length,
+                           std::vector<ScriptTrigger>& triggers) {
+  for (uint32_t t = 0; t < length; t += 20000 + random.below(40000)) {
+    triggers.push_back({t, (int)random.below(NUM_VOICES)});
+  }
+}
+
+struct StressScenario {
+  const char* name;
+  StressGenerator generate;
+  bool modulate;  // Change pitch, level, decay and sample every block
+};
+
+static const StressScenario stressScenarios[] = {
+    {"random", generateRandom, false},     {"rolls", generateRolls, false},
+    {"flams", generateFlams, false},       {"all_pads", generateAllPads, false},
+    {"sparse", generateSparse, false},     {"modulated", generateRandom, true},
+};
+
+#define STRESS_PITCH_MIN (PITCH_UNITY / 4)  // Slowest modulated playback
+#define STRESS_PITCH_SPAN (PITCH_UNITY * 4 - STRESS_PITCH_MIN)
+
+// New random targets for a few voices, as CVs and serial commands would set
+static void modulateVoices(StressRandom& random) {
+  for (int v = 0; v < NUM_VOICES; v++) {
+    switch (random.below(16)) {
+      case 0:
+        setVoicePitch(v, STRESS_PITCH_MIN + random.below(STRESS_PITCH_SPAN));
+        break;
+      case 1:
+        setVoiceLevel(v, LEVEL_UNITY / 8 + random.below(LEVEL_UNITY));
+        break;
+      case 2:
+        setVoiceDecay(v, random.below(2) ? DECAY_NONE
+                                         : 60000 + random.below(5536));
+        break;
+      case 3:
+        setVoiceSample(v, random.below(NUM_SAMPLES));
+        break;
+    }
+  }
+}
+
+// Back to the defaults, rendering silence until the level ramps settle
+static void resetVoiceParameters() {
+  for (int v = 0; v < NUM_VOICES; v++) {
+    setVoicePitch(v, PITCH_UNITY);
+    setVoiceLevel(v, LEVEL_UNITY);
+    setVoiceDecay(v, DECAY_NONE);
+    setVoiceSample(v, v);
+  }
+  stopAllSamples();
+  int8_t block[AUDIO_BLOCK_SIZE];
+  for (int i = 0; i < 100; i++) renderBlock(block, AUDIO_BLOCK_SIZE);
+}
+
+// Longest run of silence at the start of a sample: a voice's onset can come
+// that much after its trigger
+static uint32_t leadingSilence(const SampleData& sample) {
+  uint32_t i = 0;
+  while (i < sample.length && pgm_read_byte(&sample.data[i]) == 0) i++;
+  return i;
+}
+
+// Trigger clock each voice's latency is being timed from
+static uint32_t probeTriggerClock[NUM_VOICES];
+
+// Triggers are marked when their block is queued, so a voice's previous hit
+// can still sound early in the block, before the clock of the new mark.
+// That onset is not the new trigger's and is left out.
+static void probeOnset(int voice, uint32_t sampleClock) {
+  if ((int32_t)(sampleClock - probeTriggerClock[voice]) < 0) return;
+  latencyProbeOnset(voice, sampleClock);
+}
+
+static bool runScenario(const StressScenario& scenario,
+                        const StressOptions& options, uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t length = options.seconds * MOZZI_AUDIO_RATE;
+  std::vector<ScriptTrigger> triggers;
+  scenario.generate(random, length, triggers);
+  std::stable_sort(triggers.begin(), triggers.end(),
+                   [](const ScriptTrigger& a, const ScriptTrigger& b) {
+                     return a.sample < b.sample;
+                   });
+
+  // Half the run before the sample clock wraps, half after
+  uint32_t clockStart = 0u - length / 2;
+  stopAllSamples();
+  setEngineSampleClock(clockStart);
+  latencyProbeReset();
+  setVoiceOnsetHandler(probeOnset);
+
+  // Any voice may end up on any sample once modulated
+  uint32_t maxSilence = 0;
+  for (int i = 0; i < NUM_SAMPLES; i++) {
+    maxSilence = std::max(maxSilence, leadingSilence(sampleBank[i]));
+  }
+
+  // Modulated voices can play at a quarter speed, so they last longer and
+  // take longer to get through their leading silence
+  uint32_t stretch = scenario.modulate ? PITCH_UNITY / STRESS_PITCH_MIN : 1;
+
+  uint32_t lastTrigger[NUM_VOICES] = {};
+  bool everTriggered[NUM_VOICES] = {};
+  uint32_t retireViolations = 0;
+  uint32_t clockViolations = 0;
+  uint32_t refused = 0;  // Triggers a full queue turned away
+  uint32_t progmemBefore = hostProgmemViolations();
+  std::vector<float> nsPerSample;
+  nsPerSample.reserve(length / AUDIO_BLOCK_SIZE + triggers.size());
+
+  // Drain afterwards so every voice gets the chance to retire
+  uint32_t drain = 0;
+  for (int s = 0; s < NUM_SAMPLES; s++) {
+    drain = std::max(drain, sampleBank[s].length * stretch);
+  }
+  uint32_t total = length + drain + AUDIO_BLOCK_SIZE;
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  size_t next = 0;
+  uint32_t sample = 0;
+  hostProgmemChecking = true;
+  uint32_t wallStart = readCycleCounter();
+
+  while (sample < total) {
+    // Queue the block's triggers on their exact samples and render whole
+    // blocks, as updateAudio() does. The probe follows one trigger per
+    // voice at a time, so a retrigger later in the same block is timed
+    // from the first.
+    uint32_t clock = clockStart + sample;
+    uint8_t marked = 0;
+    while (next < triggers.size() &&
+           triggers[next].sample - sample < AUDIO_BLOCK_SIZE) {
+      int voice = triggers[next].voice;
+      uint32_t at = clockStart + triggers[next].sample;
+      if (!scheduleTrigger(voice, at)) refused++;
+      if (!(marked & (1 << voice))) {
+        latencyProbeMark(voice, LATENCY_TRIGGERED, at);
+        probeTriggerClock[voice] = at;
+        marked |= 1 << voice;
+      }
+      lastTrigger[voice] = at;
+      everTriggered[voice] = true;
+      next++;
+    }
+
+    if (scenario.modulate && sample < length) modulateVoices(random);
+
+    uint32_t start = readCycleCounter();
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+    uint32_t ns = readCycleCounter() - start;
+    nsPerSample.push_back((float)ns / AUDIO_BLOCK_SIZE);
+
+    // The engine clock must advance exactly, straight through the wrap
+    if (engineSampleClock() != clock + AUDIO_BLOCK_SIZE) clockViolations++;
+
+    // The DAC plays the block (latency probes see the output clock)
+    for (uint32_t i = 0; i < AUDIO_BLOCK_SIZE; i++) {
+      latencyProbeOutput(clock + i);
+    }
+
+    sample += AUDIO_BLOCK_SIZE;
+    uint32_t now = clockStart + sample;
+
+    // A voice must stop once its whole sample has been rendered
+    for (int v = 0; v < NUM_VOICES; v++) {
+      if (everTriggered[v] && samplePlayers[v].playing &&
+          now - lastTrigger[v] > samplePlayers[v].length * stretch) {
+        retireViolations++;
+      }
+    }
+  }
+
+  double wallNs = (double)(readCycleCounter() - wallStart);
+  hostProgmemChecking = false;
+  setVoiceOnsetHandler(nullptr);
+  if (anySamplePlaying()) retireViolations++;
+  resetVoiceParameters();
+
+  // Block time: 99.9th percentile must leave minSpeed headroom
+  std::sort(nsPerSample.begin(), nsPerSample.end());
+  float p999 = nsPerSample[nsPerSample.size() * 999 / 1000];
+  float worst = nsPerSample.back();
+  double budgetNs = 1e9 / MOZZI_AUDIO_RATE;
+  double speed = (double)total * budgetNs / wallNs;
+  bool timeOk = p999 * options.minSpeed <= budgetNs;
+
+  // Onsets stay within a block plus the sample's leading silence, even
+  // across the clock wrap
+  LatencySummary onset;
+  latencyProbeSummary(LATENCY_TRIGGERED_TO_SOUND, onset);
+  bool onsetOk = onset.max <= AUDIO_BLOCK_SIZE + maxSilence * stretch;
+
+  uint32_t progmemViolations = hostProgmemViolations() - progmemBefore;
+  bool ok = progmemViolations == 0 && retireViolations == 0 &&
+            clockViolations == 0 && refused == 0 && timeOk && onsetOk;
+
+  printf("%-4s %-9s triggers=%-7zu speed=%.0fx block_ns/sample p99.9=%.1f "
+         "max=%.1f onset_max=%lu\n",
+         ok ? "ok" : "FAIL", scenario.name, triggers.size(), speed, p999,
+         worst, (unsigned long)onset.max);
+  if (progmemViolations) {
+    printf("     %lu out-of-bounds sample reads\n",
+           (unsigned long)progmemViolations);
+  }
+  if (retireViolations) {
+    printf("     %lu checks found a voice that never retired\n",
+           (unsigned long)retireViolations);
+  }
+  if (clockViolations) {
+    printf("     sample clock skipped %lu times\n",
+           (unsigned long)clockViolations);
+  }
+  if (refused) {
+    printf("     %lu triggers refused by a full queue\n",
+           (unsigned long)refused);
+  }
+  if (!timeOk) {
+    printf("     block render too slow for %.0fx real time (budget %.0fns/sample)\n",
+           options.minSpeed, budgetNs);
+  }
+  if (!onsetOk) {
+    printf("     onset %lu samples after trigger, limit %lu\n",
+           (unsigned long)onset.max,
+           (unsigned long)(AUDIO_BLOCK_SIZE + maxSilence * stretch));
+  }
+  return ok;
+}
+
+// Parameter ramps in every mode towards random targets: no step between
+// blocks, no overshoot, arrival on time, and the fast path once settled
+static bool runRampCheck(uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  struct RampCase {
+    ParamRamp mode;
+    uint8_t rate;
+    int maxBlocks;  // Longest a ramp across the whole range may take
+  };
+  const RampCase cases[] = {{PARAM_RAMP_LINEAR, 1, 1},
+                            {PARAM_RAMP_LINEAR, 8, 8},
+                            {PARAM_RAMP_EXPONENTIAL, 2, 80},
+                            {PARAM_RAMP_EXPONENTIAL, 4, 350}};
+
+  uint32_t violations = 0;
+  int ramps = 0;
+  for (const RampCase& test : cases) {
+    SmoothedParam param = SMOOTHED_PARAM(0, test.mode, test.rate);
+    for (int i = 0; i < 2000; i++, ramps++) {
+      int32_t target = (int32_t)(random.next() >> 1) - (1 << 30);
+      if (random.below(4) == 0) target = param.end + random.below(64) - 32;
+      int count = 1 + random.below(AUDIO_BLOCK_SIZE);
+      paramSetTarget(param, target);
+
+      int blocks = 0;
+      while (paramBlockStart(param, count)) {
+        blocks++;
+        int32_t start = param.current;
+        for (int n = 0; n < count; n++) paramTick(param);
+
+        // Ticks end short of the block end by less than one step per
+        // sample, and never go past the target
+        int64_t shortfall = (int64_t)param.end - param.current;
+        if (std::abs(shortfall) >= count) violations++;
+        if ((param.end - start > 0) != (target - start > 0)) violations++;
+        if (blocks > test.maxBlocks) break;
+      }
+      if (param.current != target || blocks > test.maxBlocks) violations++;
+
+      // Settled: the fast path holds the value with no ramp
+      if (paramBlockStart(param, count) || param.step != 0) violations++;
+    }
+  }
+
+  bool ok = violations == 0;
+  printf("%-4s ramps     ramps=%d violations=%lu\n", ok ? "ok" : "FAIL", ramps,
+         (unsigned long)violations);
+  return ok;
+}
+
+// Pitch 0 set directly and reached through modulation: the rate keeps to
+// PITCH_MIN, so a voice with no decay still plays through and retires
+static bool runPitchFloorCheck() {
+  int8_t block[AUDIO_BLOCK_SIZE];
+  int stuck = 0;
+  int cases = 0;
+  for (int modulated = 0; modulated < 2; modulated++) {
+    for (int v = 0; v < NUM_VOICES; v++, cases++) {
+      stopAllSamples();
+      setVoiceDecay(v, DECAY_NONE);
+      if (modulated) {
+        setVoiceModulation(v, 0, DECAY_NONE, 0);
+      } else {
+        setVoicePitch(v, 0);
+      }
+      triggerSample(v);
+
+      uint32_t limit = sampleBank[v].length * (PITCH_UNITY / PITCH_MIN) +
+                       2 * AUDIO_BLOCK_SIZE;
+      for (uint32_t n = 0; n < limit && samplePlayers[v].playing;
+           n += AUDIO_BLOCK_SIZE) {
+        renderBlock(block, AUDIO_BLOCK_SIZE);
+      }
+      if (samplePlayers[v].playing) stuck++;
+      setVoiceModulation(v, PITCH_UNITY, DECAY_NONE, 0);
+    }
+  }
+  resetVoiceParameters();
+
+  bool ok = stuck == 0;
+  printf("%-4s pitch_min voices=%d stuck=%d\n", ok ? "ok" : "FAIL", cases,
+         stuck);
+  return ok;
+}
+
+struct StressOnset {
+  uint32_t offset;  // Sample clock relative to the start of the run
+  int voice;
+
+  bool operator<(const StressOnset& other) const {
+    return offset != other.offset ? offset < other.offset
+                                  : voice < other.voice;
+  }
+  bool operator==(const StressOnset& other) const {
+    return offset == other.offset && voice == other.voice;
+  }
+};
+
+static std::vector<StressOnset> heardOnsets;
+static uint32_t onsetClockStart = 0;
+
+static void recordOnset(int voice, uint32_t sampleClock) {
+  heardOnsets.push_back({sampleClock - onsetClockStart, voice});
+}
+
+// The sequencer at a random tempo, swing, length and pattern, rendered in
+// whole blocks with steps queued a block ahead as on the module. Every step
+// must sound on its exact sample, straight through the clock wrap.
+static bool runSequencerScenario(const StressOptions& options, uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t length = options.seconds * MOZZI_AUDIO_RATE;
+  uint32_t clockStart = 0u - length / 2;
+
+  SequencerPattern savedPattern = sequencerPattern;
+  sequencerPattern.length = 16 << random.below(3);
+  for (int track = 0; track < SEQ_TRACKS; track++) {
+    sequencerPattern.steps[track] =
+        (uint64_t)random.next() << 32 | random.next();
+  }
+  uint16_t bpm = SEQ_MIN_BPM + random.below(SEQ_MAX_BPM - SEQ_MIN_BPM + 1);
+  uint8_t swing = SEQ_SWING_STRAIGHT +
+                  random.below(SEQ_SWING_MAX - SEQ_SWING_STRAIGHT + 1);
+  sequencerSetTempo(bpm);
+  sequencerSetSwing(swing);
+
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(clockStart);
+  heardOnsets.clear();
+  onsetClockStart = clockStart;
+  setVoiceOnsetHandler(recordOnset);
+
+  // Expected: every step inside the run, plus each sample's leading silence
+  uint32_t silence[NUM_VOICES];
+  uint32_t maxSilence = 0;
+  for (int v = 0; v < NUM_VOICES; v++) {
+    silence[v] = leadingSilence(sampleBank[v]);
+    maxSilence = std::max(maxSilence, silence[v]);
+  }
+
+  sequencerStart(clockStart);
+  std::vector<StressOnset> expected;
+  for (uint32_t step = 0;; step++) {
+    uint32_t offset = sequencerStepClock(step) - clockStart;
+    if (offset >= length) break;
+    uint32_t position = step % sequencerPattern.length;
+    for (int track = 0; track < SEQ_TRACKS; track++) {
+      if ((sequencerPattern.steps[track] >> position) & 1) {
+        expected.push_back({offset + silence[track], track});
+      }
+    }
+  }
+  std::sort(expected.begin(), expected.end());
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  uint32_t total = length + maxSilence + AUDIO_BLOCK_SIZE;
+  uint32_t wallStart = readCycleCounter();
+  for (uint32_t sample = 0; sample < total; sample += AUDIO_BLOCK_SIZE) {
+    uint32_t horizon = std::min(sample + 2 * AUDIO_BLOCK_SIZE, length);
+    sequencerSchedule(clockStart + horizon);
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+  }
+  double wallNs = (double)(readCycleCounter() - wallStart);
+
+  sequencerStop();
+  stopAllSamples();
+  setVoiceOnsetHandler(nullptr);
+  sequencerPattern = savedPattern;
+
+  std::sort(heardOnsets.begin(), heardOnsets.end());
+  size_t matched = 0;
+  for (size_t i = 0; i < expected.size() && i < heardOnsets.size(); i++) {
+    if (expected[i] == heardOnsets[i]) matched++;
+  }
+  bool ok = matched == expected.size() && heardOnsets.size() == expected.size();
+
+  double speed = (double)total * (1e9 / MOZZI_AUDIO_RATE) / wallNs;
+  printf("%-4s %-9s hits=%-10zu speed=%.0fx bpm=%u swing=%u steps=%u\n",
+         ok ? "ok" : "FAIL", "sequencer", expected.size(), speed, bpm, swing,
+         sequencerPattern.length);
+  if (!ok) {
+    printf("     %zu of %zu hits on their exact sample, %zu onsets heard\n",
+           matched, expected.size(), heardOnsets.size());
+  }
+  return ok;
+}
+
+// Stopping the sequencer with steps and an external trigger queued: the
+// steps must be dropped and the external trigger must still sound on its
+// exact sample
+static bool runStopCheck(uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t clockStart = random.next();
+
+  SequencerPattern savedPattern = sequencerPattern;
+  sequencerPattern.length = 16;
+  for (int track = 0; track < SEQ_TRACKS; track++) {
+    sequencerPattern.steps[track] = ~0ull;
+  }
+  sequencerSetTempo(SEQ_MAX_BPM);
+  sequencerSetSwing(SEQ_SWING_STRAIGHT);
+
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(clockStart);
+  heardOnsets.clear();
+  onsetClockStart = clockStart;
+  setVoiceOnsetHandler(recordOnset);
+
+  // Steps queued ahead, with an external hit in among them
+  sequencerStart(clockStart + AUDIO_BLOCK_SIZE);
+  sequencerSchedule(sequencerStepClock(4));
+  int voice = random.below(NUM_VOICES);
+  uint32_t offset = sequencerStepClock(1) - clockStart + 1;
+  scheduleTrigger(voice, clockStart + offset);
+  sequencerStop();
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  uint32_t total = sequencerStepClock(8) - clockStart +
+                   leadingSilence(sampleBank[voice]);
+  for (uint32_t sample = 0; sample < total; sample += AUDIO_BLOCK_SIZE) {
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+  }
+
+  stopAllSamples();
+  setVoiceOnsetHandler(nullptr);
+  sequencerPattern = savedPattern;
+
+  StressOnset expected = {offset + leadingSilence(sampleBank[voice]), voice};
+  bool ok = heardOnsets.size() == 1 && heardOnsets[0] == expected;
+  printf("%-4s stop      onsets=%zu expected=1 voice=%d\n",
+         ok ? "ok" : "FAIL", heardOnsets.size(), voice);
+  return ok;
+}
+
+// Live hits recorded into an empty pattern at a random tempo, swing, length
+// and record grid, each played live and recorded at the clock it is heard
+// on, as the pads do on the module. Every live hit must sound on its exact
+// sample, the pattern must hold the hits at their nearest grid steps, and a
+// step recorded ahead of the playhead must not sound again in the same pass.
+struct RecordedHit {
+  uint32_t offset;
+  int track;
+  uint8_t velocity;
+  uint32_t step;  // Nearest grid step, found by brute force
+};
+
+static bool runRecordScenario(const StressOptions& options, uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t length = options.seconds * MOZZI_AUDIO_RATE;
+  uint32_t clockStart = 0u - length / 2;
+
+  SequencerPattern savedPattern = sequencerPattern;
+  memset(&sequencerPattern, 0, sizeof sequencerPattern);
+  sequencerPattern.length = 16 << random.below(3);
+  uint16_t bpm = SEQ_MIN_BPM + random.below(SEQ_MAX_BPM - SEQ_MIN_BPM + 1);
+  uint8_t swing = SEQ_SWING_STRAIGHT +
+                  random.below(SEQ_SWING_MAX - SEQ_SWING_STRAIGHT + 1);
+  uint8_t grid = 1 << random.below(3);
+  sequencerSetTempo(bpm);
+  sequencerSetSwing(swing);
+  sequencerSetRecordGrid(grid);
+  sequencerSetRecording(true);
+
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(clockStart);
+  heardOnsets.clear();
+  onsetClockStart = clockStart;
+  setVoiceOnsetHandler(recordOnset);
+
+  uint32_t silence[NUM_VOICES];
+  uint32_t maxSilence = 0;
+  for (int v = 0; v < NUM_VOICES; v++) {
+    silence[v] = leadingSilence(sampleBank[v]);
+    maxSilence = std::max(maxSilence, silence[v]);
+  }
+
+  sequencerStart(clockStart);
+  std::vector<uint32_t> stepOffsets;  // Every grid step of the run
+  for (uint32_t step = 0;; step++) {
+    uint32_t offset = sequencerStepClock(step) - clockStart;
+    if (offset >= length) break;
+    stepOffsets.push_back(offset);
+  }
+
+  // A few hits a second, off the grid, after the first step
+  std::vector<RecordedHit> hits;
+  uint32_t firstStep = stepOffsets.size() > 1 ? stepOffsets[1] : length;
+  for (uint32_t i = 0; i < options.seconds * 4 && firstStep < length; i++) {
+    RecordedHit hit;
+    hit.offset = firstStep + random.below(length - firstStep);
+    if (std::binary_search(stepOffsets.begin(), stepOffsets.end(),
+                           hit.offset)) {
+      hit.offset++;  // Never on the sample of a step it could repeat
+    }
+    hit.track = random.below(SEQ_TRACKS);
+    // Soft hits start later: the onset is the first nonzero output sample
+    hit.velocity = VELOCITY_MAX / 2 + random.below(VELOCITY_MAX / 2 + 1);
+    uint32_t bestDistance = UINT32_MAX;
+    for (uint32_t step = 0; step < stepOffsets.size() + grid; step += grid) {
+      uint32_t offset = sequencerStepClock(step) - clockStart;
+      uint32_t distance = offset > hit.offset ? offset - hit.offset
+                                              : hit.offset - offset;
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        hit.step = step;
+      }
+    }
+    hits.push_back(hit);
+  }
+  std::sort(hits.begin(), hits.end(),
+            [](const RecordedHit& a, const RecordedHit& b) {
+              return a.offset < b.offset;
+            });
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  uint32_t total = length + maxSilence + AUDIO_BLOCK_SIZE;
+  size_t nextHit = 0;
+  for (uint32_t sample = 0; sample < total; sample += AUDIO_BLOCK_SIZE) {
+    uint32_t horizon = std::min(sample + 2 * AUDIO_BLOCK_SIZE, length);
+    sequencerSchedule(clockStart + horizon);
+    while (nextHit < hits.size() &&
+           hits[nextHit].offset < sample + AUDIO_BLOCK_SIZE) {
+      const RecordedHit& hit = hits[nextHit++];
+      scheduleTrigger(hit.track, clockStart + hit.offset, hit.velocity);
+      sequencerRecord(hit.track, clockStart + hit.offset, hit.velocity);
+    }
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+  }
+
+  sequencerStop();
+  sequencerSetRecording(false);
+  sequencerSetRecordGrid(1);
+  stopAllSamples();
+  setVoiceOnsetHandler(nullptr);
+  SequencerPattern recorded = sequencerPattern;
+  sequencerPattern = savedPattern;
+
+  // The pattern holds the last hit at each track and position
+  SequencerPattern reference;
+  memset(&reference, 0, sizeof reference);
+  reference.length = recorded.length;
+  for (const RecordedHit& hit : hits) {
+    uint32_t position = hit.step % reference.length;
+    reference.steps[hit.track] |= 1ull << position;
+    reference.velocity[hit.track][position] = hit.velocity;
+  }
+  bool patternOk = memcmp(&reference, &recorded, sizeof reference) == 0;
+
+  // Live hits sound exactly when played; whatever else sounds is the
+  // pattern repeating them
+  std::vector<StressOnset> live;
+  for (const RecordedHit& hit : hits) {
+    live.push_back({hit.offset + silence[hit.track], hit.track});
+  }
+  std::sort(live.begin(), live.end());
+  std::sort(heardOnsets.begin(), heardOnsets.end());
+  std::vector<StressOnset> repeats;
+  std::set_difference(heardOnsets.begin(), heardOnsets.end(), live.begin(),
+                      live.end(), std::back_inserter(repeats));
+
+  // Every live hit sounds on its exact sample, unless a retrigger inside
+  // its leading silence took its onset over
+  size_t liveMissing = 0;
+  for (const StressOnset& onset : live) {
+    if (std::binary_search(heardOnsets.begin(), heardOnsets.end(), onset)) {
+      continue;
+    }
+    bool retriggered = false;
+    for (auto later = std::upper_bound(heardOnsets.begin(), heardOnsets.end(),
+                                       onset);
+         later != heardOnsets.end() &&
+         later->offset <= onset.offset + silence[onset.voice];
+         ++later) {
+      if (later->voice == onset.voice) retriggered = true;
+    }
+    if (!retriggered) liveMissing++;
+  }
+
+  // Each repeat is a grid step after a hit recorded at its position, and
+  // never the step a hit first went to. Steps well after a hit (past the
+  // lookahead) must all repeat it, unless a hit lands there again.
+  size_t badRepeats = 0, missingRepeats = 0;
+  uint32_t lookahead = 4 * AUDIO_BLOCK_SIZE;
+  for (int track = 0; track < SEQ_TRACKS; track++) {
+    for (uint32_t step = 0; step < stepOffsets.size(); step++) {
+      uint32_t position = step % recorded.length;
+      bool earlier = false, due = false, here = false;
+      for (const RecordedHit& hit : hits) {
+        if (hit.track != track || hit.step % recorded.length != position) {
+          continue;
+        }
+        if (hit.step == step) here = true;
+        if (hit.step < step) {
+          earlier = true;
+          if (stepOffsets[step] > hit.offset + lookahead) due = true;
+        }
+      }
+      StressOnset onset = {stepOffsets[step] + silence[track], track};
+      bool heard = std::binary_search(repeats.begin(), repeats.end(), onset);
+      if (heard && !earlier) badRepeats++;
+      if (!heard && due && !here) missingRepeats++;
+    }
+  }
+
+  bool ok = patternOk && liveMissing == 0 && badRepeats == 0 &&
+            missingRepeats == 0;
+  printf("%-4s %-9s hits=%-10zu repeats=%zu bpm=%u swing=%u steps=%u "
+         "grid=%u\n",
+         ok ? "ok" : "FAIL", "record", hits.size(), repeats.size(), bpm,
+         swing, recorded.length, grid);
+  if (!ok) {
+    printf("     pattern %s, %zu live hits off their exact sample, "
+           "%zu repeats off the pattern, %zu repeats missing\n",
+           patternOk ? "ok" : "wrong", liveMissing, badRepeats,
+           missingRepeats);
+  }
+  return ok;
+}
+
+// The sequencer following an external clock at a random tempo, with
+// +/-CLOCK_JITTER samples of jitter on every pulse. Edges reach the tracker
+// CLOCK_LATENCY samples late, as the module's audio buffer delays them.
+// Once the fit has a full history, steps must land closer to the ideal grid
+// than the pulses themselves do.
+#define CLOCK_JITTER 16    // ~1ms
+#define CLOCK_LATENCY 256  // Samples buffered ahead of the DAC on the module
+
+static bool runClockScenario(const StressOptions& options, int ratio,
+                             uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t length = options.seconds * MOZZI_AUDIO_RATE;
+  uint32_t clockStart = 0u - length / 2;
+
+  // Pulses are sixteenths multiplied or divided back by the ratio, so steps
+  // are always sixteenths at bpm
+  const ClockRatio& r = clockRatios[ratio];
+  uint32_t bpm = 60 + random.below(181);
+  double stepSamples = MOZZI_AUDIO_RATE * 60.0 / (bpm * SEQ_STEPS_PER_BEAT);
+  double pulseSamples = stepSamples * r.multiply / r.divide;
+
+  std::vector<uint32_t> edges;
+  double edgeJitterSquares = 0;
+  for (double t = 1000; t + CLOCK_JITTER < length; t += pulseSamples) {
+    int jitter = (int)random.below(2 * CLOCK_JITTER + 1) - CLOCK_JITTER;
+    edges.push_back((uint32_t)lround(t) + jitter);
+    edgeJitterSquares += (double)jitter * jitter;
+  }
+  double lastPulse = 1000 + (edges.size() - 1) * pulseSamples;
+
+  SequencerPattern savedPattern = sequencerPattern;
+  sequencerPattern = {16, {~0ull, 0, 0, 0}, {}};
+  sequencerSetTempo(120);
+  sequencerSetSwing(SEQ_SWING_STRAIGHT);
+  clockInputReset();
+  clockInputSetRatio(ratio);
+
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(clockStart);
+  heardOnsets.clear();
+  onsetClockStart = clockStart;
+  setVoiceOnsetHandler(recordOnset);
+  uint32_t silence = leadingSilence(sampleBank[0]);
+
+  int8_t block[AUDIO_BLOCK_SIZE];
+  size_t nextEdge = 0;
+  bool stopped = false;
+  uint32_t total = length + 4 * (uint32_t)pulseSamples;
+  for (uint32_t sample = 0; sample < total; sample += AUDIO_BLOCK_SIZE) {
+    while (nextEdge < edges.size() &&
+           edges[nextEdge] + CLOCK_LATENCY <= sample) {
+      clockInputEdge(clockStart + edges[nextEdge++]);
+    }
+    uint32_t played = clockStart + sample - CLOCK_LATENCY;
+    if (clockInputUpdate(played) == CLOCK_STOPPED) {
+      stopped = true;
+    }
+    sequencerSchedule(clockStart + sample + 2 * AUDIO_BLOCK_SIZE);
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+  }
+
+  sequencerStop();
+  stopAllSamples();
+  setVoiceOnsetHandler(nullptr);
+  clockInputReset();
+  sequencerPattern = savedPattern;
+  sequencerSetTempo(120);
+
+  // Compare the steps after the fit fills up with the ideal grid
+  double warmup = 1000 + CLOCK_HISTORY * pulseSamples;
+  size_t steps = 0, missing = 0;
+  double errorSquares = 0, maxError = 0;
+  std::sort(heardOnsets.begin(), heardOnsets.end());
+  size_t heard = 0;
+  for (double ideal = 1000; ideal <= lastPulse; ideal += stepSamples) {
+    if (ideal < warmup) continue;
+    while (heard < heardOnsets.size() &&
+           heardOnsets[heard].offset - silence < ideal - stepSamples / 2) {
+      heard++;
+    }
+    steps++;
+    if (heard == heardOnsets.size() ||
+        heardOnsets[heard].offset - silence > ideal + stepSamples / 2) {
+      missing++;
+      continue;
+    }
+    double error = (double)(heardOnsets[heard].offset - silence) - ideal;
+    errorSquares += error * error;
+    maxError = std::max(maxError, fabs(error));
+  }
+
+  double edgeRms = sqrt(edgeJitterSquares / edges.size());
+  double stepRms = sqrt(errorSquares / std::max<size_t>(steps - missing, 1));
+  bool ok = steps > 0 && missing == 0 && stopped && stepRms < edgeRms &&
+            maxError <= 2 * CLOCK_JITTER;
+
+  printf("%-4s %-9s steps=%-9zu edge_rms=%.1f step_rms=%.1f step_max=%.0f "
+         "bpm=%u ratio=%s\n",
+         ok ? "ok" : "FAIL", "clock", steps, edgeRms, stepRms, maxError, bpm,
+         r.name);
+  if (!ok) {
+    printf("     %zu steps missing, clock stop %sdetected\n", missing,
+           stopped ? "" : "not ");
+  }
+  return ok;
+}
+
+// The first pulse of a clock start arrives stamped on the DAC clock, behind
+// the engine. Steps on the grid before the engine clock must be skipped,
+// and every later step must sound on its exact sample.
+static bool runClockStartCheck(uint32_t seed) {
+  StressRandom random = {seed ? seed : 1};
+  uint32_t clockStart = random.next();
+
+  SequencerPattern savedPattern = sequencerPattern;
+  sequencerPattern = {16, {~0ull, 0, 0, 0}, {}};
+  sequencerSetTempo(SEQ_MIN_BPM + random.below(SEQ_MAX_BPM - SEQ_MIN_BPM + 1));
+  sequencerSetSwing(SEQ_SWING_STRAIGHT);
+  clockInputReset();
+
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(clockStart);
+  heardOnsets.clear();
+  onsetClockStart = clockStart;
+  setVoiceOnsetHandler(recordOnset);
+
+  uint32_t edge = clockStart - CLOCK_LATENCY;
+  clockInputEdge(edge);
+  clockInputUpdate(edge);
+
+  uint32_t silence = leadingSilence(sampleBank[0]);
+  uint32_t length = sequencerStepClock(4) - clockStart;
+  int8_t block[AUDIO_BLOCK_SIZE];
+  for (uint32_t sample = 0; sample < length + silence;
+       sample += AUDIO_BLOCK_SIZE) {
+    if (sample < length) {
+      sequencerSchedule(clockStart + std::min(sample + 2 * AUDIO_BLOCK_SIZE,
+                                              length));
+    }
+    renderBlock(block, AUDIO_BLOCK_SIZE);
+  }
+
+  std::vector<StressOnset> expected;
+  for (uint32_t step = 0; step < 4; step++) {
+    int32_t offset = (int32_t)(sequencerStepClock(step) - clockStart);
+    if (offset >= 0) expected.push_back({(uint32_t)offset + silence, 0});
+  }
+
+  sequencerStop();
+  stopAllSamples();
+  setVoiceOnsetHandler(nullptr);
+  clockInputReset();
+  sequencerPattern = savedPattern;
+  sequencerSetTempo(120);
+
+  std::sort(heardOnsets.begin(), heardOnsets.end());
+  bool ok = !expected.empty() && heardOnsets == expected;
+  printf("%-4s %-9s onsets=%zu expected=%zu first_onset=%ld\n",
+         ok ? "ok" : "FAIL", "clk_start", heardOnsets.size(), expected.size(),
+         heardOnsets.empty() ? -1L : (long)heardOnsets[0].offset);
+  return ok;
+}
+
+int runStressScenarios(const StressOptions& options) {
+  for (int s = 0; s < NUM_SAMPLES; s++) {
+    hostProgmemRegisterRegion(sampleBank[s].data, sampleBank[s].length);
+  }
+
+  printf("stress seed=%lu seconds=%lu min_speed=%.0fx\n",
+         (unsigned long)options.seed, (unsigned long)options.seconds,
+         options.minSpeed);
+
+  int failures = 0;
+  int index = 0;
+  for (const StressScenario& scenario : stressScenarios) {
+    if (!runScenario(scenario, options, options.seed + index++)) failures++;
+  }
+  if (!runRampCheck(options.seed + index++)) failures++;
+  if (!runPitchFloorCheck()) failures++;
+  if (!runSequencerScenario(options, options.seed + index++)) failures++;
+  if (!runStopCheck(options.seed + index++)) failures++;
+  if (!runRecordScenario(options, options.seed + index++)) failures++;
+  for (int ratio = 0; ratio < CLOCK_RATIO_COUNT; ratio++) {
+    if (!runClockScenario(options, ratio, options.seed + index++)) failures++;
+  }
+  if (!runClockStartCheck(options.seed + index++)) failures++;
+  printf("%d scenarios failed\n", failures);
+  return failures;
+}
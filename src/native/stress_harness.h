@@ -0,0 +1,38 @@
+/*
+  Randomized stress harness for the trigger and voice engine.
+
+  Generates random and adversarial trigger streams (dense random hits, rolls
+  retriggering every few samples, flams, all pads at once, sparse hits) and
+  renders them as fast as possible while checking invariants:
+
+    - no sample read outside the PROGMEM sample arrays
+    - every voice retires once its sample has played out
+    - render time per block stays well inside the real-time budget
+    - sample clock arithmetic survives wrapping at 2^32 samples (the second
+      half of every run is rendered after the clock wraps)
+
+  A sequencer scenario runs the step sequencer at a random tempo, swing,
+  length and pattern, queueing steps a block ahead as the firmware does, and
+  checks that every step sounds on its exact sample. The clock scenarios
+  drive it from a jittery synthetic external clock at each multiply/divide
+  ratio and check that steps land closer to the ideal grid than the pulses.
+  The record scenario plays random live hits while recording them into an
+  empty pattern, and checks that each sounds on its exact sample, is stored
+  at its nearest grid step, and does not sound again in the same pass.
+*/
+
+#ifndef STRESS_HARNESS_H
+#define STRESS_HARNESS_H
+
+#include <stdint.h>
+
+struct StressOptions {
+  uint32_t seed;
+  uint32_t seconds;    // Audio rendered per scenario
+  double minSpeed;     // Required x real time for 99.9% of blocks
+};
+
+// Run every scenario, returning the number that broke an invariant
+int runStressScenarios(const StressOptions& options);
+
+#endif  // STRESS_HARNESS_H
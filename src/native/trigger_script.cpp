@@ -0,0 +1,75 @@
+/*
+  Trigger list files - see trigger_script.h
+*/
+
+#include "trigger_script.h"
+
+#include <Mozzi.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <strings.h>
+
+#include <algorithm>
+
+#include "../sample_engine.h"
+
+static int parsePad(const char* text) {
+  char* end;
+  long number = strtol(text, &end, 10);
+  if (*end == '\0') {
+    return (number >= 1 && number <= NUM_VOICES) ? (int)number - 1 : -1;
+  }
+
+  for (int i = 0; i < NUM_VOICES; i++) {
+    if (strcasecmp(text, samplePlayers[i].name) == 0) return i;
+  }
+  return -1;
+}
+
+bool loadTriggerScript(const std::string& path,
+                       std::vector<ScriptTrigger>& triggers,
+                       std::string& error) {
+  FILE* f = fopen(path.c_str(), "r");
+  if (!f) {
+    error = "cannot open " + path;
+    return false;
+  }
+
+  char line[256];
+  int lineNumber = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineNumber++;
+
+    char* comment = strchr(line, '#');
+    if (comment) *comment = '\0';
+
+    char timeText[64];
+    char padText[64];
+    int fields = sscanf(line, "%63s %63s", timeText, padText);
+    if (fields <= 0) continue;  // Blank line
+
+    char* end;
+    double timeMs = strtod(timeText, &end);
+    int voice = fields == 2 ? parsePad(padText) : -1;
+    if (*end != '\0' || timeMs < 0 || voice < 0) {
+      error = path + ":" + std::to_string(lineNumber) + ": expected <time_ms> <pad>";
+      fclose(f);
+      return false;
+    }
+
+    ScriptTrigger trigger;
+    trigger.sample = (uint32_t)llround(timeMs * MOZZI_AUDIO_RATE / 1000.0);
+    trigger.voice = voice;
+    triggers.push_back(trigger);
+  }
+  fclose(f);
+
+  // Keep file order for triggers on the same sample
+  std::stable_sort(triggers.begin(), triggers.end(),
+                   [](const ScriptTrigger& a, const ScriptTrigger& b) {
+                     return a.sample < b.sample;
+                   });
+  return true;
+}
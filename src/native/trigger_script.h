@@ -0,0 +1,27 @@
+/*
+  Trigger list files for the native host build.
+
+  One trigger per line: "<time_ms> <pad>", where pad is a 1-based pad number
+  or a sample name (kick, snare, hihat, tom). Blank lines and text after '#'
+  are ignored. Times are rounded to the nearest audio sample.
+*/
+
+#ifndef TRIGGER_SCRIPT_H
+#define TRIGGER_SCRIPT_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+struct ScriptTrigger {
+  uint32_t sample;  // Audio sample index the trigger lands on
+  int voice;        // 0-based voice index
+};
+
+// Parse a trigger list file, returning the triggers sorted by time
+bool loadTriggerScript(const std::string& path,
+                       std::vector<ScriptTrigger>& triggers,
+                       std::string& error);
+
+#endif  // TRIGGER_SCRIPT_H
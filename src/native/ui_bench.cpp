@@ -0,0 +1,321 @@
+/*
+  OLED composition benchmark - see ui_bench.h
+*/
+
+#include "ui_bench.h"
+
+#include <Mozzi.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <chrono>
+
+#include "../display_scheduler.h"
+#include "../oled_diff.h"
+#include "../sample_engine.h"
+#include "../spectrum.h"
+#include "../ui_frame.h"
+
+#define UI_BENCH_FPS 30
+#define UI_BENCH_SECONDS 8
+#define UI_BENCH_REPEATS 20         // Compositions timed per frame and path
+#define UI_BENCH_HIT_INTERVAL 4096  // Samples between triggers (250 ms)
+// Most whole audio blocks one display frame needs
+#define UI_BENCH_FRAME_BLOCKS \
+  ((MOZZI_AUDIO_RATE / UI_BENCH_FPS + AUDIO_BLOCK_SIZE - 1) / AUDIO_BLOCK_SIZE)
+#define UI_BENCH_FFTS 2000
+#define UI_BENCH_BURST 16          // Triggers 1 ms apart between two frames
+#define UI_BENCH_COMPOSE_US 300    // Frame cost fed to the scheduler, kept
+#define UI_BENCH_FLUSH_US 1500     // low enough for the fastest frame rate
+
+// Adafruit display(): the window commands in two command transmissions
+// (control byte + 5, control byte + 1), then every byte of the frame in
+// 31-byte data transmissions
+#define UI_BENCH_FULL_FRAME_BYTES \
+  (8 + OLED_FRAME_BYTES + (OLED_FRAME_BYTES + OLED_I2C_CHUNK - 1) / OLED_I2C_CHUNK)
+
+// Reference path: Adafruit_GFX style, every pixel through a virtual
+// drawPixel with bounds checks. The real library adds rotation handling and
+// a per-call colour switch, so this understates its cost.
+struct PixelCanvas {
+  uint8_t* frame;
+
+  virtual void drawPixel(int x, int y) {
+    if (x < 0 || x >= OLED_COLUMNS || y < 0 || y >= OLED_PAGES * 8) return;
+    frame[x + (y / 8) * OLED_COLUMNS] |= 1 << (y & 7);
+  }
+  virtual ~PixelCanvas() {}
+
+  void drawChar(int x, int y, char c) {
+    const uint8_t* glyph = glyphColumns(c);
+    for (int i = 0; i < GLYPH_WIDTH; i++) {
+      uint8_t line = glyph[i];
+      for (int j = 0; j < 8; j++, line >>= 1) {
+        if (line & 1) drawPixel(x + i, y + j);
+      }
+    }
+  }
+
+  int print(int x, int y, const char* text) {
+    for (; *text; text++, x += GLYPH_ADVANCE) drawChar(x, y, *text);
+    return x;
+  }
+
+  void drawIcon(int x, int y, UiIcon icon) {
+    for (int i = 0; i < ICON_WIDTH; i++) {
+      for (int j = 0; j < 8; j++) {
+        if (UI_ICONS[icon][i] & (1 << j)) drawPixel(x + i, y + j);
+      }
+    }
+  }
+
+  void invertPixel(int x, int y) {
+    if (x < 0 || x >= OLED_COLUMNS || y < 0 || y >= OLED_PAGES * 8) return;
+    frame[x + (y / 8) * OLED_COLUMNS] ^= 1 << (y & 7);
+  }
+
+  // drawBitmap of a page-format image
+  void drawPages(int x, int y, const uint8_t* image, int width, int pages) {
+    for (int i = 0; i < width; i++) {
+      for (int j = 0; j < pages * 8; j++) {
+        uint8_t column = image[(j / 8) * width + i];
+        if (column & (1 << (j & 7))) drawPixel(x + i, y + j);
+      }
+    }
+  }
+
+  void fillRect(int x, int y, int w, int h) {
+    for (int i = x; i < x + w; i++) {
+      for (int j = y; j < y + h; j++) drawPixel(i, j);
+    }
+  }
+};
+
+// The ui_frame.cpp layout, drawn the pixel way
+static void composePixelFrame(PixelCanvas& canvas, const UiFrameState& state) {
+  memset(canvas.frame, 0, OLED_FRAME_BYTES);
+
+  canvas.print(0, 0, "Pico DAC Sampler");
+
+  canvas.drawIcon(0, 8, state.playingMask ? ICON_PLAYING : ICON_READY);
+  canvas.print(UI_NAME_COLUMN, 8, state.lastName);
+
+  int waveY = UI_WAVE_PAGE * 8;
+  canvas.drawPages(0, waveY, state.wave, WAVE_COLUMNS, WAVE_PAGES);
+  if (state.playhead >= 0) {
+    for (int y = waveY; y < waveY + WAVE_PAGES * 8; y++) {
+      canvas.invertPixel(state.playhead, y);
+    }
+  }
+
+  for (int i = 0; i < NUM_VOICES; i++) {
+    int bar = meterPixels(state.meters[i].level, METER_HEIGHT);
+    int hold = meterPixels(state.meters[i].hold, METER_HEIGHT);
+    int meterX = METER_X + i * METER_SPACING;
+    canvas.fillRect(meterX, METER_HEIGHT - bar, METER_WIDTH, bar);
+    if (hold > bar) {
+      canvas.fillRect(meterX, METER_HEIGHT - hold, METER_WIDTH, 1);
+    }
+  }
+}
+
+static double nowNs() {
+  return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Time the analyzer's FFT on the master output of the drumming
+static void benchSpectrum(ReportLineFn emit, const int8_t* audio) {
+  static int16_t re[FFT_SIZE], im[FFT_SIZE];
+  double fftMin = 1e18, fftTotal = 0, stageMin = 1e18, stageTotal = 0;
+
+  for (int i = 0; i < UI_BENCH_FFTS; i++) {
+    double start = nowNs();
+    fftQ15(audio, re, im);
+    double fft = nowNs() - start;
+
+    fftLoadQ15(audio, re, im);
+    start = nowNs();
+    fftStageQ15(re, im, FFT_LOG2_SIZE);
+    double stage = nowNs() - start;
+
+    fftTotal += fft;
+    stageTotal += stage;
+    if (fft < fftMin) fftMin = fft;
+    if (stage < stageMin) stageMin = stage;
+  }
+
+  char line[96];
+  snprintf(line, sizeof(line), "# spectrum,fft_size=%d", FFT_SIZE);
+  emit(line);
+  emit("step,ns_min,ns_avg");
+  snprintf(line, sizeof(line), "fft,%.0f,%.0f", fftMin,
+           fftTotal / UI_BENCH_FFTS);
+  emit(line);
+  snprintf(line, sizeof(line), "stage,%.0f,%.0f", stageMin,
+           stageTotal / UI_BENCH_FFTS);
+  emit(line);
+}
+
+// The scheduler's report, passed through with its last line kept
+static ReportLineFn schedulerEmit = nullptr;
+static char schedulerLine[128];
+
+static void captureSchedulerLine(const char* line) {
+  if (schedulerEmit) schedulerEmit(line);
+  snprintf(schedulerLine, sizeof(schedulerLine), "%s", line);
+}
+
+// Close the scheduler's report window the way the firmware does: core 0
+// asks, the display loop hands it over, core 0 prints it
+static void schedulerReport(ReportLineFn emit) {
+  schedulerEmit = emit;
+  while (!displaySchedulerReport(captureSchedulerLine)) {
+    displaySchedulerService();
+  }
+}
+
+// A burst of triggers arriving between two frames, polled every millisecond
+// as loop1() does, must cost a single redraw. Returns 1 if it did not.
+static int benchScheduler(ReportLineFn emit) {
+  // First frame draws at once; start the burst with a fresh window
+  uint32_t now = 0;
+  displayMarkDirty();
+  if (displayFrameDue(now)) {
+    displayFrameDone(UI_BENCH_COMPOSE_US, UI_BENCH_FLUSH_US, now);
+  }
+  schedulerReport(nullptr);
+
+  int frames = 0;
+  for (now = 1; now <= DISPLAY_MAX_FRAME_MS; now++) {
+    if (now <= UI_BENCH_BURST) displayMarkDirty();
+    if (displayFrameDue(now)) {
+      displayFrameDone(UI_BENCH_COMPOSE_US, UI_BENCH_FLUSH_US, now);
+      frames++;
+    }
+  }
+  schedulerReport(emit);
+
+  // The report must agree: every update but one coalesced
+  unsigned long reported = 0, updates = 0, coalesced = 0;
+  sscanf(schedulerLine, "%lu,%lu,%lu", &reported, &updates, &coalesced);
+  bool ok = frames == 1 && reported == 1 && updates == UI_BENCH_BURST &&
+            coalesced == UI_BENCH_BURST - 1;
+  if (!ok) {
+    char line[96];
+    snprintf(line, sizeof(line),
+             "# FAIL: a burst of %d triggers took %d frames (%lu reported)",
+             UI_BENCH_BURST, frames, reported);
+    emit(line);
+  }
+  return ok ? 0 : 1;
+}
+
+int runUiBenchmarks(ReportLineFn emit) {
+  static uint8_t pixelFrame[OLED_FRAME_BYTES];
+  static uint8_t atlasFrame[OLED_FRAME_BYTES];
+  static uint8_t shownFrame[OLED_FRAME_BYTES];
+  static int8_t audio[UI_BENCH_FRAME_BLOCKS * AUDIO_BLOCK_SIZE];
+
+  PixelCanvas canvas;
+  canvas.frame = pixelFrame;
+  LevelMeter meters[NUM_VOICES] = {};
+  int lastPad = 0;
+
+  double pixelMin = 1e18, pixelTotal = 0, atlasMin = 1e18, atlasTotal = 0;
+  uint64_t fullBytes = 0, dirtyBytes = 0;
+  int frames = UI_BENCH_FPS * UI_BENCH_SECONDS;
+  int mismatches = 0;
+  uint32_t clock = 0, nextHit = 0;
+
+  buildWaveOverviews();
+  stopAllSamples();
+  clearScheduledTriggers();
+  setEngineSampleClock(0);
+  memset(shownFrame, 0, sizeof(shownFrame));
+
+  for (int frame = 0; frame < frames; frame++) {
+    // One display frame of audio in whole blocks, as updateAudio()
+    // renders it, with hits cycling through the pads on their exact samples
+    uint32_t frameEnd = (uint64_t)(frame + 1) * MOZZI_AUDIO_RATE / UI_BENCH_FPS;
+    for (int i = 0; clock < frameEnd; i += AUDIO_BLOCK_SIZE) {
+      if (nextHit - clock < AUDIO_BLOCK_SIZE) {
+        lastPad = (nextHit / UI_BENCH_HIT_INTERVAL) % NUM_VOICES;
+        scheduleTrigger(lastPad, nextHit);
+        nextHit += UI_BENCH_HIT_INTERVAL;
+      }
+      renderBlock(audio + i, AUDIO_BLOCK_SIZE);
+      clock += AUDIO_BLOCK_SIZE;
+    }
+
+    uint8_t peaks[NUM_VOICES];
+    takeVoicePeaks(peaks);
+    for (int i = 0; i < NUM_VOICES; i++) updateLevelMeter(meters[i], peaks[i]);
+
+    UiFrameState state = {activeSampleMask(), samplePlayers[lastPad].name,
+                          waveOverview(lastPad), wavePlayheadColumn(lastPad),
+                          meters};
+
+    for (int r = 0; r < UI_BENCH_REPEATS; r++) {
+      double start = nowNs();
+      composePixelFrame(canvas, state);
+      double pixel = nowNs() - start;
+
+      start = nowNs();
+      composeUiFrame(atlasFrame, state);
+      double atlas = nowNs() - start;
+
+      pixelTotal += pixel;
+      atlasTotal += atlas;
+      if (pixel < pixelMin) pixelMin = pixel;
+      if (atlas < atlasMin) atlasMin = atlas;
+    }
+
+    if (memcmp(pixelFrame, atlasFrame, OLED_FRAME_BYTES) != 0) mismatches++;
+
+    // Adafruit display() sends every frame as one full window
+    fullBytes += UI_BENCH_FULL_FRAME_BYTES;
+
+    OledSpan spans[OLED_MAX_SPANS];
+    int count = planOledSpans(atlasFrame, shownFrame, spans);
+    for (int i = 0; i < count; i++) {
+      int columns = spans[i].lastColumn - spans[i].firstColumn + 1;
+      dirtyBytes += oledSpanBytes(columns);
+    }
+    memcpy(shownFrame, atlasFrame, OLED_FRAME_BYTES);
+  }
+
+  int timed = frames * UI_BENCH_REPEATS;
+  char line[96];
+  snprintf(line, sizeof(line), "# ui_bench,frames=%d", frames);
+  emit(line);
+  emit("method,ns_min,ns_avg,speedup");
+  snprintf(line, sizeof(line), "pixel,%.0f,%.0f,1.00", pixelMin,
+           pixelTotal / timed);
+  emit(line);
+  snprintf(line, sizeof(line), "atlas,%.0f,%.0f,%.2f", atlasMin,
+           atlasTotal / timed, pixelTotal / atlasTotal);
+  emit(line);
+
+  snprintf(line, sizeof(line), "# i2c,frames=%d", frames);
+  emit(line);
+  emit("transfer,bytes_total,bytes_per_frame,ratio");
+  snprintf(line, sizeof(line), "full,%llu,%.1f,1.00",
+           (unsigned long long)fullBytes, (double)fullBytes / frames);
+  emit(line);
+  snprintf(line, sizeof(line), "dirty,%llu,%.1f,%.3f",
+           (unsigned long long)dirtyBytes, (double)dirtyBytes / frames,
+           (double)dirtyBytes / fullBytes);
+  emit(line);
+
+  benchSpectrum(emit, audio);
+  int failures = benchScheduler(emit);
+
+  if (mismatches) {
+    snprintf(line, sizeof(line), "# FAIL: %d frames differ between paths",
+             mismatches);
+    emit(line);
+  }
+  return mismatches + failures;
+}
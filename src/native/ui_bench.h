@@ -0,0 +1,39 @@
+/*
+  Host benchmark for OLED frame composition and I2C traffic.
+
+  Replays a few seconds of drumming through the engine at display rate and,
+  for every frame, composes the UI twice: once pixel by pixel the way
+  Adafruit_GFX draws (drawChar -> drawPixel per set bit), and once with the
+  page-format glyph atlas (ui_frame.cpp). Both must produce identical
+  frames. It also counts the I2C bytes a full display() would send against
+  the dirty spans oledFlush() sends, and times the spectrum analyzer's
+  fixed-point FFT. Last, it feeds the display scheduler a burst of
+  UI_BENCH_BURST triggers between two frames, which must cost one redraw,
+  and prints the scheduler's own report of it.
+
+  Output (CSV):
+    # ui_bench,frames=<n>
+    method,ns_min,ns_avg,speedup
+    pixel,...
+    atlas,...
+    # i2c,frames=<n>
+    transfer,bytes_total,bytes_per_frame,ratio
+    full,...
+    dirty,...
+    # spectrum,fft_size=<n>
+    step,ns_min,ns_avg
+    fft,...         load + all butterfly stages
+    stage,...       one butterfly stage (the analyzer's time slice unit)
+    # display,...   the display scheduler's report (display_scheduler.h)
+*/
+
+#ifndef UI_BENCH_H
+#define UI_BENCH_H
+
+#include "../report.h"
+
+// Returns the number of failed checks: frames where the two composition
+// paths differ, plus one if the trigger burst took more than one redraw
+int runUiBenchmarks(ReportLineFn emit);
+
+#endif  // UI_BENCH_H
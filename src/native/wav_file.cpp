@@ -0,0 +1,106 @@
+/*
+  16-bit mono PCM WAV reading and writing - see wav_file.h
+*/
+
+#include "wav_file.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static void putLE16(FILE* f, uint16_t v) {
+  fputc(v & 0xFF, f);
+  fputc(v >> 8, f);
+}
+
+static void putLE32(FILE* f, uint32_t v) {
+  putLE16(f, v & 0xFFFF);
+  putLE16(f, v >> 16);
+}
+
+static uint16_t getLE16(const uint8_t* p) { return p[0] | (p[1] << 8); }
+
+static uint32_t getLE32(const uint8_t* p) {
+  return getLE16(p) | ((uint32_t)getLE16(p + 2) << 16);
+}
+
+bool writeWavFile(const std::string& path, const std::vector<int16_t>& samples,
+                  uint32_t sampleRate) {
+  FILE* f = fopen(path.c_str(), "wb");
+  if (!f) return false;
+
+  uint32_t dataSize = samples.size() * 2;
+
+  // RIFF header
+  fwrite("RIFF", 1, 4, f);
+  putLE32(f, 36 + dataSize);
+  fwrite("WAVE", 1, 4, f);
+
+  // Format chunk: PCM, mono, 16-bit
+  fwrite("fmt ", 1, 4, f);
+  putLE32(f, 16);
+  putLE16(f, 1);
+  putLE16(f, 1);
+  putLE32(f, sampleRate);
+  putLE32(f, sampleRate * 2);
+  putLE16(f, 2);
+  putLE16(f, 16);
+
+  // Data chunk
+  fwrite("data", 1, 4, f);
+  putLE32(f, dataSize);
+  for (size_t i = 0; i < samples.size(); i++) {
+    putLE16(f, (uint16_t)samples[i]);
+  }
+
+  bool ok = !ferror(f);
+  fclose(f);
+  return ok;
+}
+
+bool readWavFile(const std::string& path, std::vector<int16_t>& samples,
+                 uint32_t& sampleRate) {
+  FILE* f = fopen(path.c_str(), "rb");
+  if (!f) return false;
+
+  std::vector<uint8_t> bytes;
+  uint8_t buf[4096];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+    bytes.insert(bytes.end(), buf, buf + n);
+  }
+  fclose(f);
+
+  if (bytes.size() < 12 || memcmp(&bytes[0], "RIFF", 4) != 0 ||
+      memcmp(&bytes[8], "WAVE", 4) != 0) {
+    return false;
+  }
+
+  // Walk the chunks looking for "fmt " and "data"
+  bool haveFormat = false;
+  size_t pos = 12;
+  while (pos + 8 <= bytes.size()) {
+    uint32_t chunkSize = getLE32(&bytes[pos + 4]);
+    const uint8_t* chunk = &bytes[pos + 8];
+    if (pos + 8 + chunkSize > bytes.size()) return false;
+
+    if (memcmp(&bytes[pos], "fmt ", 4) == 0 && chunkSize >= 16) {
+      // Only 16-bit mono PCM is produced by this project
+      if (getLE16(chunk) != 1 || getLE16(chunk + 2) != 1 ||
+          getLE16(chunk + 14) != 16) {
+        return false;
+      }
+      sampleRate = getLE32(chunk + 4);
+      haveFormat = true;
+    } else if (memcmp(&bytes[pos], "data", 4) == 0 && haveFormat) {
+      samples.resize(chunkSize / 2);
+      for (size_t i = 0; i < samples.size(); i++) {
+        samples[i] = (int16_t)getLE16(chunk + i * 2);
+      }
+      return true;
+    }
+
+    pos += 8 + chunkSize + (chunkSize & 1);
+  }
+
+  return false;
+}
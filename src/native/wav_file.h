@@ -0,0 +1,19 @@
+/*
+  16-bit mono PCM WAV reading and writing for the native host build
+*/
+
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+bool writeWavFile(const std::string& path, const std::vector<int16_t>& samples,
+                  uint32_t sampleRate);
+
+bool readWavFile(const std::string& path, std::vector<int16_t>& samples,
+                 uint32_t& sampleRate);
+
+#endif  // WAV_FILE_H
@@ -0,0 +1,45 @@
+/*
+  Dirty-region detection for the SSD1306 framebuffer - see oled_diff.h
+*/
+
+#include "oled_diff.h"
+
+int findDirtySpans(const uint8_t* frame, const uint8_t* previous,
+                   OledSpan* spans, int maxSpans) {
+  int count = 0;
+
+  for (int page = 0; page < OLED_PAGES; page++) {
+    const uint8_t* now = frame + page * OLED_COLUMNS;
+    const uint8_t* before = previous + page * OLED_COLUMNS;
+    int open = -1;  // Index of the span still being extended on this page
+
+    for (int column = 0; column < OLED_COLUMNS; column++) {
+      if (now[column] == before[column]) continue;
+
+      if (open >= 0 &&
+          column - spans[open].lastColumn <= OLED_SPAN_MERGE_GAP) {
+        spans[open].lastColumn = column;
+        continue;
+      }
+
+      if (count == maxSpans) return -1;
+      spans[count] = {(uint8_t)page, (uint8_t)column, (uint8_t)column};
+      open = count++;
+    }
+  }
+
+  return count;
+}
+
+int planOledSpans(const uint8_t* frame, const uint8_t* previous,
+                  OledSpan* spans) {
+  int count = -1;
+  if (previous) count = findDirtySpans(frame, previous, spans, OLED_MAX_SPANS);
+  if (count >= 0) return count;
+
+  // Too fragmented (or unknown panel contents): one window per page
+  for (int page = 0; page < OLED_PAGES; page++) {
+    spans[page] = {(uint8_t)page, 0, OLED_COLUMNS - 1};
+  }
+  return OLED_PAGES;
+}
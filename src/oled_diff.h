@@ -0,0 +1,55 @@
+/*
+  Dirty-region detection for the SSD1306 framebuffer.
+
+  The framebuffer is in SSD1306 page format: OLED_PAGES rows of 8-pixel-tall
+  pages, one byte per column. Comparing a new frame with the last one sent
+  yields spans of changed columns per page. Nearby changes are merged when
+  the unchanged gap costs less to resend than a new addressing command.
+
+  Spans are sent in the panel's page addressing mode: a window is a page
+  and a start column, three commands in one transmission, and the data
+  that follows stays within that page.
+*/
+
+#ifndef OLED_DIFF_H
+#define OLED_DIFF_H
+
+#include <Arduino.h>
+
+#define OLED_COLUMNS 128
+#define OLED_PAGES 4  // 32 rows / 8
+#define OLED_FRAME_BYTES (OLED_COLUMNS * OLED_PAGES)
+
+#define OLED_I2C_CHUNK 31           // Data bytes per transmission (+ control)
+#define OLED_SPAN_COMMAND_BYTES 4   // Control byte, page, column low/high
+
+// A new span costs its window command and its own data control byte
+#define OLED_SPAN_MERGE_GAP (OLED_SPAN_COMMAND_BYTES + 1)
+#define OLED_MAX_SPANS 16
+
+struct OledSpan {
+  uint8_t page;
+  uint8_t firstColumn;
+  uint8_t lastColumn;  // Inclusive
+};
+
+// I2C bytes needed to send a window of this many columns
+inline uint32_t oledSpanBytes(uint32_t columns) {
+  return OLED_SPAN_COMMAND_BYTES + columns +
+         (columns + OLED_I2C_CHUNK - 1) / OLED_I2C_CHUNK;
+}
+
+// Find the changed column spans between two frames. Returns the number of
+// spans written, or -1 if more than maxSpans would be needed (send the
+// whole frame instead).
+int findDirtySpans(const uint8_t* frame, const uint8_t* previous,
+                   OledSpan* spans, int maxSpans);
+
+// The windows to send for a frame: its dirty spans, or one whole-page
+// window per page when previous is nullptr (panel contents unknown) or the
+// changes need more than OLED_MAX_SPANS spans. spans needs OLED_MAX_SPANS
+// entries. Returns the number of windows.
+int planOledSpans(const uint8_t* frame, const uint8_t* previous,
+                  OledSpan* spans);
+
+#endif  // OLED_DIFF_H
@@ -0,0 +1,83 @@
+/*
+  Incremental SSD1306 flushing - see oled_flush.h
+*/
+
+#include "oled_flush.h"
+
+#define OLED_CONTROL_COMMANDS 0x00  // Co = 0, D/C# = 0
+#define OLED_CONTROL_DATA 0x40      // Co = 0, D/C# = 1
+#define OLED_PAGE_ADDRESSING 0x02   // SSD1306_MEMORYMODE argument
+#define OLED_SET_PAGE 0xB0          // Page start address, page in bits 0-2
+#define OLED_SET_COLUMN_LOW 0x00    // Start column, low nibble
+#define OLED_SET_COLUMN_HIGH 0x10   // Start column, high nibble
+
+static Adafruit_SSD1306* oledDisplay = nullptr;
+static TwoWire* oledWire = nullptr;
+static uint8_t oledAddress = 0;
+static uint8_t shownFrame[OLED_FRAME_BYTES];  // What the panel holds now
+static bool shownFrameValid = false;
+static OledFlushStats flushStats = {0, 0};
+
+void oledFlushBegin(Adafruit_SSD1306& display, TwoWire& wire, uint8_t address) {
+  oledDisplay = &display;
+  oledWire = &wire;
+  oledAddress = address;
+  shownFrameValid = false;
+
+  // Page addressing: a window costs three commands instead of six, and
+  // every span lies within one page
+  display.ssd1306_command(SSD1306_MEMORYMODE);
+  display.ssd1306_command(OLED_PAGE_ADDRESSING);
+}
+
+void oledInvalidate() { shownFrameValid = false; }
+
+// Address a window and stream its bytes into the panel's GDDRAM
+static uint32_t sendSpan(const uint8_t* frame, const OledSpan& span) {
+  oledWire->beginTransmission(oledAddress);
+  oledWire->write(OLED_CONTROL_COMMANDS);
+  oledWire->write(OLED_SET_PAGE | span.page);
+  oledWire->write(OLED_SET_COLUMN_LOW | (span.firstColumn & 0x0F));
+  oledWire->write(OLED_SET_COLUMN_HIGH | (span.firstColumn >> 4));
+  oledWire->endTransmission();
+
+  const uint8_t* data = frame + span.page * OLED_COLUMNS + span.firstColumn;
+  uint32_t columns = span.lastColumn - span.firstColumn + 1;
+
+  for (uint32_t remaining = columns; remaining;) {
+    uint32_t chunk = remaining < OLED_I2C_CHUNK ? remaining : OLED_I2C_CHUNK;
+    oledWire->beginTransmission(oledAddress);
+    oledWire->write(OLED_CONTROL_DATA);
+    oledWire->write(data, chunk);
+    oledWire->endTransmission();
+
+    data += chunk;
+    remaining -= chunk;
+  }
+  return oledSpanBytes(columns);
+}
+
+uint32_t oledFlush() {
+  if (!oledDisplay) return 0;
+  const uint8_t* frame = oledDisplay->getBuffer();
+
+  OledSpan spans[OLED_MAX_SPANS];
+  int count =
+      planOledSpans(frame, shownFrameValid ? shownFrame : nullptr, spans);
+
+  uint32_t sent = 0;
+  for (int i = 0; i < count; i++) {
+    sent += sendSpan(frame, spans[i]);
+  }
+
+  memcpy(shownFrame, frame, OLED_FRAME_BYTES);
+  shownFrameValid = true;
+
+  if (sent) {
+    flushStats.flushes++;
+    flushStats.bytesSent += sent;
+  }
+  return sent;
+}
+
+const OledFlushStats& oledFlushStats() { return flushStats; }
@@ -0,0 +1,34 @@
+/*
+  Incremental SSD1306 flushing (RP2040 only).
+
+  Replaces display.display(): keeps a copy of the last frame sent and only
+  transfers the changed spans of the Adafruit_SSD1306 framebuffer, each as a
+  page and start column followed by its data bytes. oledFlushBegin() puts
+  the panel in page addressing mode, so display.display() must not be used
+  after it.
+*/
+
+#ifndef OLED_FLUSH_H
+#define OLED_FLUSH_H
+
+#include <Adafruit_SSD1306.h>
+#include <Wire.h>
+
+#include "oled_diff.h"
+
+struct OledFlushStats {
+  uint32_t flushes;    // oledFlush() calls that sent something
+  uint32_t bytesSent;  // I2C payload + command bytes
+};
+
+void oledFlushBegin(Adafruit_SSD1306& display, TwoWire& wire, uint8_t address);
+
+// Forget what the panel shows, so the next flush sends the whole frame
+void oledInvalidate();
+
+// Send the changed parts of the framebuffer. Returns the I2C bytes sent.
+uint32_t oledFlush();
+
+const OledFlushStats& oledFlushStats();
+
+#endif  // OLED_FLUSH_H
@@ -0,0 +1,43 @@
+/*
+  Page-format drawing - see page_canvas.h
+*/
+
+#include "page_canvas.h"
+
+#include <string.h>
+
+void clearFrame(uint8_t* frame) { memset(frame, 0, OLED_FRAME_BYTES); }
+
+int drawText(uint8_t* frame, int page, int column, const char* text) {
+  uint8_t* row = frame + page * OLED_COLUMNS;
+
+  for (; *text && column + GLYPH_ADVANCE <= OLED_COLUMNS; text++) {
+    const uint8_t* glyph = glyphColumns(*text);
+    memcpy(row + column, glyph, GLYPH_WIDTH);
+    row[column + GLYPH_WIDTH] = 0;
+    column += GLYPH_ADVANCE;
+  }
+  return column;
+}
+
+void drawIcon(uint8_t* frame, int page, int column, UiIcon icon) {
+  if (column + ICON_WIDTH > OLED_COLUMNS) return;
+  memcpy(frame + page * OLED_COLUMNS + column, UI_ICONS[icon], ICON_WIDTH);
+}
+
+void fillRows(uint8_t* frame, int column, int width, int top, int bottom) {
+  if (top < 0) top = 0;
+  if (bottom > OLED_PAGES * 8) bottom = OLED_PAGES * 8;
+  if (column + width > OLED_COLUMNS) width = OLED_COLUMNS - column;
+
+  for (int page = top / 8; page * 8 < bottom; page++) {
+    int first = top > page * 8 ? top - page * 8 : 0;
+    int last = bottom < page * 8 + 8 ? bottom - page * 8 : 8;  // Exclusive
+    uint8_t mask = (uint8_t)((0xFF << first) & (0xFF >> (8 - last)));
+
+    uint8_t* bytes = frame + page * OLED_COLUMNS + column;
+    for (int i = 0; i < width; i++) {
+      bytes[i] |= mask;
+    }
+  }
+}
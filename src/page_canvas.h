@@ -0,0 +1,29 @@
+/*
+  Drawing straight into an SSD1306 page-format framebuffer.
+
+  Text and icons sit on page boundaries (y = 0, 8, 16, 24), so each glyph
+  column is one byte copy out of the glyph atlas. Rectangles are written a
+  page at a time with bit masks. Glyphs are opaque: their blank spacing
+  column is written too.
+*/
+
+#ifndef PAGE_CANVAS_H
+#define PAGE_CANVAS_H
+
+#include <Arduino.h>
+
+#include "glyph_atlas.h"
+#include "oled_diff.h"
+
+void clearFrame(uint8_t* frame);
+
+// Draw text on a page starting at column; clipped at the right edge.
+// Returns the column after the last glyph.
+int drawText(uint8_t* frame, int page, int column, const char* text);
+
+void drawIcon(uint8_t* frame, int page, int column, UiIcon icon);
+
+// Set every pixel in columns [column, column + width) and rows [top, bottom)
+void fillRows(uint8_t* frame, int column, int width, int top, int bottom);
+
+#endif  // PAGE_CANVAS_H
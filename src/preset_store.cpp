@@ -0,0 +1,258 @@
+/*
+  Kit presets in flash - see preset_store.h
+*/
+
+#include "preset_store.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#include "cv_input.h"
+#include "serial_protocol.h"  // serialCrc16()
+
+#ifndef SAMPLER_NATIVE
+#include <hardware/flash.h>
+#include <hardware/sync.h>
+#endif
+
+#define PRESET_MAGIC 0x54455350  // "PSET"
+#define PRESET_NO_PAGE -1
+
+struct PresetRecord {
+  uint32_t magic;
+  uint16_t crc;  // CRC-16/CCITT-FALSE of everything from slot on
+  uint8_t slot;
+  uint8_t reserved;
+  uint32_t sequence;  // One more than the record written before it
+  PresetSettings settings;
+};
+
+static_assert(sizeof(PresetRecord) <= PRESET_PAGE_BYTES,
+              "a preset record must fit in one flash page");
+static_assert(PRESET_SLOTS < PRESET_SECTOR_PAGES,
+              "the current records must fit in one sector");
+
+static bool storeReady = false;
+static int16_t slotPages[PRESET_SLOTS];  // Newest record of each slot
+static int head = 0;                     // Page the next record goes to
+static uint32_t nextSequence = 1;
+static uint8_t dirtySectors = 0;  // Bit per sector not fully erased
+static bool savePending = false;
+static PresetRecord pendingRecord;
+static PresetStoreStats stats;
+
+// Flash cannot be programmed from data in flash, so records go via RAM
+static uint8_t pageBuffer[PRESET_PAGE_BYTES];
+
+static const PresetRecord* recordAt(int page) {
+  return (const PresetRecord*)(presetFlashData() + page * PRESET_PAGE_BYTES);
+}
+
+static uint16_t recordCrc(const PresetRecord& record) {
+  size_t start = offsetof(PresetRecord, slot);
+  return serialCrc16((const uint8_t*)&record + start,
+                     sizeof(PresetRecord) - start);
+}
+
+static bool validRecord(const PresetRecord* record) {
+  return record->magic == PRESET_MAGIC && record->slot < PRESET_SLOTS &&
+         record->crc == recordCrc(*record);
+}
+
+static bool newer(const PresetRecord* a, const PresetRecord* b) {
+  return (int32_t)(a->sequence - b->sequence) > 0;
+}
+
+static bool pageBlank(int page) {
+  const uint8_t* data = presetFlashData() + page * PRESET_PAGE_BYTES;
+  for (int i = 0; i < PRESET_PAGE_BYTES; i++) {
+    if (data[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+// Slot whose newest record is in a sector, or -1
+static int currentSlotIn(int sector) {
+  for (int slot = 0; slot < PRESET_SLOTS; slot++) {
+    if (slotPages[slot] == PRESET_NO_PAGE) continue;
+    if (slotPages[slot] / PRESET_SECTOR_PAGES == sector) return slot;
+  }
+  return -1;
+}
+
+// Program a record at the head, which is always an erased page
+static void writeRecord(PresetRecord& record) {
+  int page = head;
+  record.sequence = nextSequence++;
+  record.crc = recordCrc(record);
+  memset(pageBuffer, 0xFF, sizeof pageBuffer);
+  memcpy(pageBuffer, &record, sizeof record);
+  presetFlashProgram(page, pageBuffer);
+
+  dirtySectors |= 1 << (page / PRESET_SECTOR_PAGES);
+  slotPages[record.slot] = page;
+  head = (page + 1) % PRESET_PAGES;
+  stats.records++;
+}
+
+bool presetStoreBegin() {
+  storeReady = false;
+  savePending = false;
+  if (presetFlashSize() < PRESET_FLASH_BYTES) return false;
+
+  int newestPage = PRESET_NO_PAGE;
+  for (int slot = 0; slot < PRESET_SLOTS; slot++) {
+    slotPages[slot] = PRESET_NO_PAGE;
+  }
+  dirtySectors = 0;
+  for (int page = 0; page < PRESET_PAGES; page++) {
+    if (!pageBlank(page)) dirtySectors |= 1 << (page / PRESET_SECTOR_PAGES);
+    const PresetRecord* record = recordAt(page);
+    if (!validRecord(record)) continue;
+
+    int16_t& slotPage = slotPages[record->slot];
+    if (slotPage == PRESET_NO_PAGE || newer(record, recordAt(slotPage))) {
+      slotPage = page;
+    }
+    if (newestPage == PRESET_NO_PAGE || newer(record, recordAt(newestPage))) {
+      newestPage = page;
+    }
+  }
+
+  if (newestPage == PRESET_NO_PAGE) {
+    // Nothing usable (first boot, or another firmware's data): start over
+    for (int sector = 0; sector < PRESET_SECTORS; sector++) {
+      if (dirtySectors & (1 << sector)) presetFlashErase(sector);
+    }
+    dirtySectors = 0;
+    head = 0;
+    nextSequence = 1;
+  } else {
+    nextSequence = recordAt(newestPage)->sequence + 1;
+    head = (newestPage + 1) % PRESET_PAGES;
+    // Writes cut short by a power loss leave spoilt pages at the head.
+    // Every sector they reach into was erased before they began.
+    for (int i = 0; i < PRESET_PAGES && !pageBlank(head); i++) {
+      head = (head + 1) % PRESET_PAGES;
+    }
+  }
+
+  storeReady = true;
+  return true;
+}
+
+bool presetSave(int slot) {
+  if (!storeReady || slot < 0 || slot >= PRESET_SLOTS || savePending) {
+    return false;
+  }
+  memset(&pendingRecord, 0, sizeof pendingRecord);
+  pendingRecord.magic = PRESET_MAGIC;
+  pendingRecord.slot = slot;
+  for (int voice = 0; voice < NUM_VOICES; voice++) {
+    pendingRecord.settings.voices[voice] = voiceSettings(voice);
+  }
+  pendingRecord.settings.cvTarget = cvInputTarget();
+  savePending = true;
+  return true;
+}
+
+bool presetSavePending() { return savePending; }
+
+bool presetRead(int slot, PresetSettings& settings) {
+  if (!storeReady || slot < 0 || slot >= PRESET_SLOTS) return false;
+  if (slotPages[slot] == PRESET_NO_PAGE) return false;
+  const PresetRecord* record = recordAt(slotPages[slot]);
+  if (!validRecord(record)) return false;
+  settings = record->settings;
+  return true;
+}
+
+bool presetRecall(int slot) {
+  PresetSettings settings;
+  if (!presetRead(slot, settings)) return false;
+
+  // The CVs modulate these settings, so they hold on patched voices too
+  cvInputSetTarget(settings.cvTarget);
+  for (int voice = 0; voice < NUM_VOICES; voice++) {
+    setVoiceSettings(voice, settings.voices[voice]);
+  }
+  return true;
+}
+
+void presetStoreService(bool silent) {
+  if (!storeReady) return;
+  int next = (head / PRESET_SECTOR_PAGES + 1) % PRESET_SECTORS;
+
+  // Current records move out of the sector the head reaches next. This
+  // starts as the head enters a sector, so they always fit before its end.
+  int slot = currentSlotIn(next);
+  if (slot >= 0) {
+    PresetRecord copy = *recordAt(slotPages[slot]);
+    writeRecord(copy);
+    stats.copies++;
+    return;
+  }
+
+  // Then that sector is erased, in a silent moment if there is one before
+  // the head needs it
+  if (dirtySectors & (1 << next)) {
+    bool lastPage = head % PRESET_SECTOR_PAGES == PRESET_SECTOR_PAGES - 1;
+    bool needed = lastPage && savePending;
+    if (silent || needed) {
+      presetFlashErase(next);
+      dirtySectors &= ~(1 << next);
+      stats.erases++;
+      if (!silent) stats.forcedErases++;
+      return;
+    }
+  }
+
+  if (savePending) {
+    writeRecord(pendingRecord);
+    savePending = false;
+  }
+}
+
+PresetStoreStats presetStoreStats() { return stats; }
+
+#ifndef SAMPLER_NATIVE
+
+extern uint8_t _FS_start;  // Flash set aside by board_build.filesystem_size
+extern uint8_t _FS_end;
+
+const uint8_t* presetFlashData() { return &_FS_start; }
+
+size_t presetFlashSize() { return &_FS_end - &_FS_start; }
+
+static uint32_t flashOffset(int page) {
+  return (uintptr_t)&_FS_start - XIP_BASE + page * PRESET_PAGE_BYTES;
+}
+
+// While the flash erases or programs nothing may run from it: interrupts
+// are off (most handlers live in flash) and this code runs from RAM
+static void __not_in_flash_func(flashErase)(uint32_t offset) {
+  uint32_t interrupts = save_and_disable_interrupts();
+  flash_range_erase(offset, PRESET_SECTOR_BYTES);
+  restore_interrupts(interrupts);
+}
+
+static void __not_in_flash_func(flashProgram)(uint32_t offset,
+                                              const uint8_t* data) {
+  uint32_t interrupts = save_and_disable_interrupts();
+  flash_range_program(offset, data, PRESET_PAGE_BYTES);
+  restore_interrupts(interrupts);
+}
+
+void presetFlashErase(int sector) {
+  rp2040.idleOtherCore();  // Core 1 parks in RAM until resumed
+  flashErase(flashOffset(sector * PRESET_SECTOR_PAGES));
+  rp2040.resumeOtherCore();
+}
+
+void presetFlashProgram(int page, const uint8_t* data) {
+  rp2040.idleOtherCore();
+  flashProgram(flashOffset(page), data);
+  rp2040.resumeOtherCore();
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+  Kit presets in flash: each voice's pitch, decay, level and sample, and
+  the voices the CV inputs control.
+
+  The store is a log over PRESET_SECTORS flash sectors. Saving a slot
+  appends a record (one 256-byte page: magic, sequence number, slot, CRC,
+  settings) at the head; the newest valid record of a slot wins. The head
+  walks the sectors in a ring, so every sector is erased equally often
+  however the slots are used. Before the head can reach the next sector,
+  the records still current there are copied forward and the sector is
+  erased. At most PRESET_SLOTS records are current, fewer than a sector
+  holds, so the copies always fit.
+
+  presetStoreBegin() scans the log once and keeps the page of each slot's
+  newest record, so recalling a slot reads one record through the XIP
+  window and applies it: a few microseconds, well inside one audio block.
+  A record cut short by a power loss fails its CRC and the slot falls back
+  to its previous record.
+
+  Flash writes are audio-safe. presetSave() only copies the settings to
+  RAM; presetStoreService(), called from loop(), then does at most one
+  flash operation per call. It idles core 1 and disables interrupts, since
+  nothing may run from flash meanwhile, and the erase and program code
+  runs from RAM. A page program (under 1 ms) fits in the I2S DMA buffers.
+  A sector erase (about 45 ms) does not, so it waits until no voice plays
+  and the sequencer is stopped. It runs while playing only if the head
+  reaches that sector first, once in 8 or more saves. MIDI bytes that
+  arrive during an erase are lost (the UART FIFO is off).
+
+  The log lives in the flash area reserved by board_build.filesystem_size
+  (platformio.ini). The native host build runs the same code against a
+  simulated flash (program presets).
+*/
+
+#ifndef PRESET_STORE_H
+#define PRESET_STORE_H
+
+#include <Arduino.h>
+
+#include "sample_engine.h"
+
+#define PRESET_SLOTS 8
+#define PRESET_SECTORS 4          // Log size, erased in turn
+#define PRESET_SECTOR_BYTES 4096  // RP2040 flash erase unit
+#define PRESET_PAGE_BYTES 256     // RP2040 flash program unit, one record
+#define PRESET_SECTOR_PAGES (PRESET_SECTOR_BYTES / PRESET_PAGE_BYTES)
+#define PRESET_PAGES (PRESET_SECTORS * PRESET_SECTOR_PAGES)
+#define PRESET_FLASH_BYTES (PRESET_SECTORS * PRESET_SECTOR_BYTES)
+
+struct PresetSettings {
+  VoiceSettings voices[NUM_VOICES];
+  uint8_t cvTarget;  // Voice mask the CV inputs control
+};
+
+// Counters for the wear report
+struct PresetStoreStats {
+  uint32_t records;  // Pages programmed, copies included
+  uint32_t copies;   // Records moved out of a sector before its erase
+  uint32_t erases;
+  uint32_t forcedErases;  // Erases that could not wait for silence
+};
+
+// Scan the log and index the newest record of every slot. Formats the
+// area if it holds no valid record. Returns false if the flash area is
+// missing or too small (presets then stay unavailable).
+bool presetStoreBegin();
+
+// Snapshot the current settings into a slot. The write happens over the
+// next presetStoreService() calls. Returns false while an earlier save is
+// still waiting.
+bool presetSave(int slot);
+bool presetSavePending();
+
+// Apply a slot's settings to the engine and the CV inputs. Returns false
+// if the slot was never saved.
+bool presetRecall(int slot);
+
+// A slot's stored settings, without applying them
+bool presetRead(int slot, PresetSettings& settings);
+
+// Run at most one flash operation. silent: no voice plays and the
+// sequencer is stopped, so a sector erase may stall audio now.
+void presetStoreService(bool silent);
+
+PresetStoreStats presetStoreStats();
+
+// Flash access: the firmware uses the RP2040 flash, the native host build
+// a simulation. Sectors and pages count from the start of the area.
+const uint8_t* presetFlashData();  // Memory-mapped contents
+size_t presetFlashSize();
+void presetFlashErase(int sector);
+void presetFlashProgram(int page, const uint8_t* data);
+
+#endif  // PRESET_STORE_H
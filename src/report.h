@@ -0,0 +1,11 @@
+/*
+  Line sink for diagnostic reports, so shared modules can produce text
+  without depending on Serial (the host build prints to stdout instead).
+*/
+
+#ifndef REPORT_H
+#define REPORT_H
+
+typedef void (*ReportLineFn)(const char* line);
+
+#endif  // REPORT_H
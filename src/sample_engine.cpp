@@ -0,0 +1,385 @@
+/*
+  Sample playback engine - see sample_engine.h
+*/
+
+#include "sample_engine.h"
+
+#include "hihat_sample.h"    // Hi-hat sample
+#include "kick_sample.h"     // Kick drum sample
+#include "smoothed_param.h"  // Per-block ramps for level and pitch
+#include "snare_sample.h"    // Snare drum sample
+#include "tom_sample.h"      // Tom sample
+#include "trace_ring.h"      // Voice start/end trace events
+
+const SampleData sampleBank[NUM_SAMPLES] = {
+    {kick_sample_data, kick_sample_length, "Kick"},
+    {snare_sample_data, snare_sample_length, "Snare"},
+    {hihat_sample_data, hihat_sample_length, "Hihat"},
+    {tom_sample_data, tom_sample_length, "Tom"}};
+
+// Initialize sample players for each drum
+SamplePlayer samplePlayers[NUM_VOICES] = {
+    {kick_sample_data, kick_sample_length, 0, false, "Kick"},
+    {snare_sample_data, snare_sample_length, 0, false, "Snare"},
+    {hihat_sample_data, hihat_sample_length, 0, false, "Hihat"},
+    {tom_sample_data, tom_sample_length, 0, false, "Tom"}};
+
+// Sample clock and onset reporting
+static uint32_t sampleClock = 0;
+static VoiceOnsetFn voiceOnsetHandler = nullptr;
+static bool voiceOnsetPending[NUM_VOICES];
+
+// Per-voice playback parameters. Level is Q15 (LEVEL_UNITY = as stored):
+// the trigger velocity times the decay envelope times the pad level, ramped
+// across each block towards its new value so changes never step.
+static uint8_t voiceGain[NUM_VOICES] = {128, 128, 128, 128};
+static uint32_t voiceEnvelope[NUM_VOICES];  // Q16, DECAY_NONE at the trigger
+static uint32_t voiceDecay[NUM_VOICES] = {DECAY_NONE, DECAY_NONE, DECAY_NONE,
+                                          DECAY_NONE};
+static uint32_t voiceBasePitch[NUM_VOICES] = {PITCH_UNITY, PITCH_UNITY,
+                                              PITCH_UNITY, PITCH_UNITY};
+static uint32_t voiceBaseDecay[NUM_VOICES] = {DECAY_NONE, DECAY_NONE,
+                                              DECAY_NONE, DECAY_NONE};
+
+// CV modulation on top of the settings above
+static uint32_t voiceModPitch[NUM_VOICES] = {PITCH_UNITY, PITCH_UNITY,
+                                             PITCH_UNITY, PITCH_UNITY};
+static uint32_t voiceModDecay[NUM_VOICES] = {DECAY_NONE, DECAY_NONE,
+                                             DECAY_NONE, DECAY_NONE};
+static uint8_t voiceModSample[NUM_VOICES];
+static SmoothedParam voicePadLevel[NUM_VOICES] = {
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_EXPONENTIAL, 2),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_EXPONENTIAL, 2),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_EXPONENTIAL, 2),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_EXPONENTIAL, 2)};
+static SmoothedParam voiceLevel[NUM_VOICES] = {
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(LEVEL_UNITY, PARAM_RAMP_LINEAR, 1)};
+static SmoothedParam voicePitch[NUM_VOICES] = {
+    SMOOTHED_PARAM(PITCH_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(PITCH_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(PITCH_UNITY, PARAM_RAMP_LINEAR, 1),
+    SMOOTHED_PARAM(PITCH_UNITY, PARAM_RAMP_LINEAR, 1)};
+static uint8_t rampingVoices = 0;  // Voices whose level or pitch moves
+static uint16_t voiceFraction[NUM_VOICES];  // Position between samples
+static uint8_t voiceSampleIndex[NUM_VOICES] = {0, 1, 2, 3};  // Playing
+static uint8_t voiceNextSample[NUM_VOICES] = {0, 1, 2, 3};   // Next trigger
+
+// Scheduled triggers, sorted by sample clock (wrap-safe comparisons)
+struct ScheduledTrigger {
+  uint32_t sampleClock;
+  uint8_t voice;
+  uint8_t velocity;
+  TriggerSource source;
+};
+
+static ScheduledTrigger triggerQueue[TRIGGER_QUEUE_SIZE];
+static int triggerQueueCount = 0;
+
+// Per-voice peak levels for metering. Only the renderer writes them; the
+// reader just asks for a reset, which happens at the next block start.
+static uint8_t voicePeak[NUM_VOICES];
+static volatile bool voicePeaksTaken = false;
+
+// Level a voice is heading for: velocity x envelope x pad level, Q15
+static int32_t voiceLevelTarget(int index) {
+  int32_t level = (voiceGain[index] * voiceEnvelope[index]) >> 8;
+  return (level * voicePadLevel[index].end) >> 15;
+}
+
+void triggerSample(int index, uint8_t velocity) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  if (velocity == 0) velocity = 1;
+  if (velocity > VELOCITY_MAX) velocity = VELOCITY_MAX;
+
+  SamplePlayer& player = samplePlayers[index];
+  voiceSampleIndex[index] =
+      (voiceNextSample[index] + voiceModSample[index]) % NUM_SAMPLES;
+  const SampleData& sample = sampleBank[voiceSampleIndex[index]];
+  player.data = sample.data;
+  player.length = sample.length;
+  player.name = sample.name;
+
+  // A restart begins at its own level and pitch, not mid-ramp
+  voiceGain[index] = velocity + 1;
+  voiceEnvelope[index] = DECAY_NONE;
+  paramJump(voiceLevel[index], voiceLevelTarget(index));
+  paramJump(voicePitch[index], voicePitch[index].target);
+  rampingVoices &= ~(1 << index);
+  voiceFraction[index] = 0;
+  player.position = 0;
+  player.playing = true;
+  traceEvent(TRACE_VOICE_START, index);
+  voiceOnsetPending[index] = voiceOnsetHandler != nullptr;
+}
+
+bool scheduleTrigger(int index, uint32_t sampleClock, uint8_t velocity,
+                     TriggerSource source) {
+  if (index < 0 || index >= NUM_VOICES) return false;
+  if (triggerQueueCount == TRIGGER_QUEUE_SIZE) return false;
+
+  // Insert after everything due at or before this clock
+  int slot = triggerQueueCount;
+  while (slot > 0 &&
+         (int32_t)(triggerQueue[slot - 1].sampleClock - sampleClock) > 0) {
+    triggerQueue[slot] = triggerQueue[slot - 1];
+    slot--;
+  }
+  triggerQueue[slot] = {sampleClock, (uint8_t)index, velocity, source};
+  triggerQueueCount++;
+  return true;
+}
+
+void clearScheduledTriggers() { triggerQueueCount = 0; }
+
+void clearScheduledTriggers(TriggerSource source) {
+  // Compact in place; the rest stay in clock order
+  int kept = 0;
+  for (int i = 0; i < triggerQueueCount; i++) {
+    if (triggerQueue[i].source == source) continue;
+    triggerQueue[kept++] = triggerQueue[i];
+  }
+  triggerQueueCount = kept;
+}
+
+// Start every queued trigger due at the current sample
+static void fireDueTriggers() {
+  int due = 0;
+  while (due < triggerQueueCount &&
+         (int32_t)(triggerQueue[due].sampleClock - sampleClock) <= 0) {
+    traceEvent(TRACE_TRIGGER, triggerQueue[due].voice, TRACE_SOURCE_SCHEDULED);
+    triggerSample(triggerQueue[due].voice, triggerQueue[due].velocity);
+    due++;
+  }
+
+  triggerQueueCount -= due;
+  for (int i = 0; i < triggerQueueCount; i++) {
+    triggerQueue[i] = triggerQueue[i + due];
+  }
+}
+
+// Playback rate and decay with the modulation applied. A rate of 0 would
+// hold a voice on one sample for good, so the product keeps to PITCH_MIN.
+static void updateVoicePitch(int index) {
+  uint64_t step = (uint64_t)voiceBasePitch[index] * voiceModPitch[index] >> 16;
+  if (step < PITCH_MIN) step = PITCH_MIN;
+  if (step > PITCH_MAX) step = PITCH_MAX;
+  paramSetTarget(voicePitch[index], step);
+}
+
+static void updateVoiceDecay(int index) {
+  voiceDecay[index] =
+      (uint64_t)voiceBaseDecay[index] * voiceModDecay[index] >> 16;
+}
+
+void setVoicePitch(int index, uint32_t stepQ16) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  if (stepQ16 < PITCH_MIN) stepQ16 = PITCH_MIN;
+  if (stepQ16 > PITCH_MAX) stepQ16 = PITCH_MAX;
+  voiceBasePitch[index] = stepQ16;
+  updateVoicePitch(index);
+}
+
+void setVoiceLevel(int index, int32_t levelQ15) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  if (levelQ15 < 0) levelQ15 = 0;
+  if (levelQ15 > LEVEL_UNITY) levelQ15 = LEVEL_UNITY;
+  paramSetTarget(voicePadLevel[index], levelQ15);
+}
+
+void setVoiceDecay(int index, uint32_t factorQ16) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  voiceBaseDecay[index] = factorQ16 > DECAY_NONE ? DECAY_NONE : factorQ16;
+  updateVoiceDecay(index);
+}
+
+void setVoiceSample(int index, int sample) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  if (sample < 0 || sample >= NUM_SAMPLES) return;
+  voiceNextSample[index] = sample;
+}
+
+int voiceSample(int index) { return voiceSampleIndex[index]; }
+
+VoiceSettings voiceSettings(int index) {
+  VoiceSettings settings = {};
+  if (index < 0 || index >= NUM_VOICES) return settings;
+  settings.pitch = voiceBasePitch[index];
+  settings.decay = voiceBaseDecay[index];
+  settings.level = voicePadLevel[index].target;
+  settings.sample = voiceNextSample[index];
+  return settings;
+}
+
+void setVoiceSettings(int index, const VoiceSettings& settings) {
+  setVoicePitch(index, settings.pitch);
+  setVoiceDecay(index, settings.decay);
+  setVoiceLevel(index, settings.level);
+  setVoiceSample(index, settings.sample);
+}
+
+void setVoiceModulation(int index, uint32_t pitchQ16, uint32_t decayQ16,
+                        int sampleOffset) {
+  if (index < 0 || index >= NUM_VOICES) return;
+  if (sampleOffset < 0 || sampleOffset >= NUM_SAMPLES) return;
+  voiceModPitch[index] = pitchQ16 > PITCH_MAX ? PITCH_MAX : pitchQ16;
+  voiceModDecay[index] = decayQ16 > DECAY_NONE ? DECAY_NONE : decayQ16;
+  voiceModSample[index] = sampleOffset;
+  updateVoicePitch(index);
+  updateVoiceDecay(index);
+}
+
+void stopAllSamples() {
+  for (int i = 0; i < NUM_VOICES; i++) {
+    samplePlayers[i].position = 0;
+    samplePlayers[i].playing = false;
+    voiceOnsetPending[i] = false;
+  }
+}
+
+bool anySamplePlaying() {
+  for (int i = 0; i < NUM_VOICES; i++) {
+    if (samplePlayers[i].playing) {
+      return true;
+    }
+  }
+  return false;
+}
+
+int32_t voicePosition(int index) {
+  if (!samplePlayers[index].playing) return -1;
+  return (int32_t)samplePlayers[index].position;
+}
+
+uint32_t engineSampleClock() { return sampleClock; }
+
+void setEngineSampleClock(uint32_t clock) { sampleClock = clock; }
+
+void setVoiceOnsetHandler(VoiceOnsetFn handler) { voiceOnsetHandler = handler; }
+
+VoiceOnsetFn currentVoiceOnsetHandler() { return voiceOnsetHandler; }
+
+int activeSampleCount() {
+  int count = 0;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    if (samplePlayers[i].playing) count++;
+  }
+  return count;
+}
+
+uint8_t activeSampleMask() {
+  uint8_t mask = 0;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    if (samplePlayers[i].playing) mask |= 1 << i;
+  }
+  return mask;
+}
+
+int8_t renderSample() {
+  int16_t mixedSample = 0;  // Use 16-bit for mixing to prevent overflow
+
+  if (triggerQueueCount &&
+      (int32_t)(triggerQueue[0].sampleClock - sampleClock) <= 0) {
+    fireDueTriggers();
+  }
+
+  // Mix all playing samples
+  for (int i = 0; i < NUM_VOICES; i++) {
+    SamplePlayer& player = samplePlayers[i];
+    if (player.playing && player.position < player.length) {
+      // Read sample from PROGMEM, between two samples at fractional rates
+      int16_t value = (int8_t)pgm_read_byte(&player.data[player.position]);
+      uint32_t fraction = voiceFraction[i];
+      if (fraction) {
+        int16_t next = 0;
+        if (player.position + 1 < player.length) {
+          next = (int8_t)pgm_read_byte(&player.data[player.position + 1]);
+        }
+        value += ((next - value) * (int32_t)fraction) >> 16;
+      }
+
+      // Scale by velocity, decay and pad level and add to mix
+      int16_t sample = (value * voiceLevel[i].current) >> 15;
+      mixedSample += sample;
+
+      uint32_t advance = fraction + voicePitch[i].current;
+      player.position += advance >> 16;
+      voiceFraction[i] = advance & 0xFFFF;
+
+      // Ramps only run in blocks where something changed
+      if (rampingVoices & (1 << i)) {
+        paramTick(voiceLevel[i]);
+        paramTick(voicePitch[i]);
+      }
+
+      uint8_t level = sample < 0 ? -sample : sample;
+      if (level > voicePeak[i]) voicePeak[i] = level;
+
+      // First audible sample since the trigger
+      if (voiceOnsetPending[i] && sample != 0) {
+        voiceOnsetPending[i] = false;
+        voiceOnsetHandler(i, sampleClock);
+      }
+    } else if (player.playing) {
+      // Sample finished playing
+      player.playing = false;
+      traceEvent(TRACE_VOICE_END, i);
+    }
+  }
+
+  sampleClock++;
+
+  // Clamp mixed sample to 8-bit range
+  if (mixedSample > 127) mixedSample = 127;
+  if (mixedSample < -128) mixedSample = -128;
+
+  return (int8_t)mixedSample;
+}
+
+void takeVoicePeaks(uint8_t peaks[NUM_VOICES]) {
+  for (int i = 0; i < NUM_VOICES; i++) {
+    peaks[i] = voicePeak[i];
+  }
+  voicePeaksTaken = true;
+}
+
+void renderBlock(int8_t* out, int count) {
+  traceEvent(TRACE_BLOCK_START, 0, count);
+  // Levels and pitches plan their ramp for this block. Decay envelopes
+  // move once per block, and a voice that has ramped to silence stops.
+  uint8_t ramping = 0;
+  for (int i = 0; i < NUM_VOICES; i++) {
+    bool padLevelMoves = paramBlockStart(voicePadLevel[i], count);
+    if (!samplePlayers[i].playing) continue;
+
+    bool decays = voiceDecay[i] != DECAY_NONE;
+    if (decays) {
+      voiceEnvelope[i] = (uint64_t)voiceEnvelope[i] * voiceDecay[i] >> 16;
+    }
+    if (decays || padLevelMoves) {
+      paramSetTarget(voiceLevel[i], voiceLevelTarget(i));
+    }
+    if (voiceLevel[i].end == 0 && voiceLevel[i].target == 0) {
+      samplePlayers[i].playing = false;
+      traceEvent(TRACE_VOICE_END, i);
+      continue;
+    }
+
+    if (paramBlockStart(voiceLevel[i], count)) ramping |= 1 << i;
+    if (paramBlockStart(voicePitch[i], count)) ramping |= 1 << i;
+  }
+  rampingVoices = ramping;
+
+  if (voicePeaksTaken) {
+    voicePeaksTaken = false;
+    for (int i = 0; i < NUM_VOICES; i++) {
+      voicePeak[i] = 0;
+    }
+  }
+  for (int i = 0; i < count; i++) {
+    out[i] = renderSample();
+  }
+  traceEvent(TRACE_BLOCK_END, 0, activeSampleCount());
+}
@@ -0,0 +1,148 @@
+/*
+  Sample playback engine shared by the RP2040 firmware and the native host
+  build. Everything in here is free of hardware access so it can be rendered
+  offline and profiled on Linux (see src/native/).
+*/
+
+#ifndef SAMPLE_ENGINE_H
+#define SAMPLE_ENGINE_H
+
+#include <Arduino.h>
+
+#define NUM_VOICES 4           // One voice per drum pad
+#define NUM_SAMPLES 4          // Samples in flash a voice can play
+#define AUDIO_BLOCK_SIZE 32    // Samples rendered per renderBlock() call
+#define TRIGGER_QUEUE_SIZE 32  // Scheduled triggers waiting to fire
+#define VELOCITY_MAX 127       // Plays the sample at its stored level
+#define PITCH_UNITY 0x10000    // Q16.16 playback rate of 1.0
+#define PITCH_MAX 0x100000     // Fastest playback rate, 16.0
+#define PITCH_MIN 0x1000       // Slowest, 1/16: a voice always reaches its end
+#define LEVEL_UNITY 32768      // Q15 pad level that plays as stored
+#define DECAY_NONE 0x10000     // Q16 per-block level factor that holds level
+
+// Multi-voice sample player structure
+struct SamplePlayer {
+  const int8_t* data;
+  uint32_t length;
+  uint32_t position;
+  bool playing;
+  const char* name;
+};
+
+// Sample players for each drum (Kick, Snare, Hihat, Tom)
+extern SamplePlayer samplePlayers[NUM_VOICES];
+
+// A sample in flash
+struct SampleData {
+  const int8_t* data;
+  uint32_t length;
+  const char* name;
+};
+
+// Every sample, in pad order: voice i starts out playing sampleBank[i]
+extern const SampleData sampleBank[NUM_SAMPLES];
+
+// Called when a triggered voice renders its first non-zero sample, with the
+// sample clock of that sample (the moment it will reach the DAC)
+typedef void (*VoiceOnsetFn)(int voice, uint32_t sampleClock);
+
+// Restart a voice from the beginning of its sample. Velocity 1-127 scales
+// its level linearly.
+void triggerSample(int index, uint8_t velocity = VELOCITY_MAX);
+
+// Who queued a scheduled trigger, so one source can withdraw its own
+enum TriggerSource : uint8_t {
+  TRIGGER_SOURCE_EXTERNAL = 0,  // MIDI notes, serial trigger frames
+  TRIGGER_SOURCE_SEQUENCER = 1,
+};
+
+// Restart a voice at an exact sample clock. Schedule before the block that
+// contains it is rendered; a clock already past fires on the next sample.
+// Returns false when the queue is full.
+bool scheduleTrigger(int index, uint32_t sampleClock,
+                     uint8_t velocity = VELOCITY_MAX,
+                     TriggerSource source = TRIGGER_SOURCE_EXTERNAL);
+
+// Drop every scheduled trigger that has not fired yet
+void clearScheduledTriggers();
+
+// Drop the unfired triggers one source queued, keeping the others
+void clearScheduledTriggers(TriggerSource source);
+
+// Playback rate of a voice, Q16.16 (PITCH_UNITY plays the sample as
+// stored, PITCH_MIN to PITCH_MAX). A playing voice glides there across the
+// next block; fractional rates interpolate linearly between stored samples.
+void setVoicePitch(int index, uint32_t stepQ16);
+
+// Mix level of a pad, Q15 up to LEVEL_UNITY. Changes ease in over a few
+// blocks (exponential ramp), so moving it never clicks.
+void setVoiceLevel(int index, int32_t levelQ15);
+
+// Level factor applied to a voice once per block, Q16 (DECAY_NONE keeps the
+// level). A voice that decays to silence stops early.
+void setVoiceDecay(int index, uint32_t factorQ16);
+
+// Sample a voice plays from its next trigger, index into sampleBank
+void setVoiceSample(int index, int sample);
+
+// Sample a voice is playing, or played last
+int voiceSample(int index);
+
+// A voice's settings as the setters above last left them: targets, not
+// where a ramp has got to, and without modulation
+struct VoiceSettings {
+  uint32_t pitch;  // Q16.16 playback rate
+  uint32_t decay;  // Q16 per-block level factor
+  int32_t level;   // Q15 pad level
+  uint8_t sample;  // Played from the next trigger
+};
+VoiceSettings voiceSettings(int index);
+void setVoiceSettings(int index, const VoiceSettings& settings);
+
+// Modulation (the CV inputs) on top of a voice's settings: the playback
+// rate is multiplied by pitchQ16, the decay factor by decayQ16, and the
+// sample moves sampleOffset places through sampleBank from the next
+// trigger. PITCH_UNITY, DECAY_NONE and 0 leave the settings as they are.
+// voiceSettings() never includes it, so presets and the serial setters are
+// not overwritten by whatever the CVs happen to read.
+void setVoiceModulation(int index, uint32_t pitchQ16, uint32_t decayQ16,
+                        int sampleOffset);
+
+// Silence every voice and rewind to the start
+void stopAllSamples();
+
+// True while at least one voice is still playing
+bool anySamplePlaying();
+
+// Number of voices currently playing
+int activeSampleCount();
+
+// Bit per voice currently playing
+uint8_t activeSampleMask();
+
+// Playback position of a voice in samples, or -1 while it is idle. Each
+// field is a single aligned word, so the display core can read it while
+// the audio core renders.
+int32_t voicePosition(int index);
+
+// Sample clock of the next sample renderSample() produces. It counts every
+// rendered sample and wraps at 2^32.
+uint32_t engineSampleClock();
+void setEngineSampleClock(uint32_t clock);
+
+// Optional hook for latency measurement (nullptr to disable)
+void setVoiceOnsetHandler(VoiceOnsetFn handler);
+VoiceOnsetFn currentVoiceOnsetHandler();
+
+// Largest |sample| (0-128) each voice produced since the previous call.
+// The renderer keeps these as a by-product of mixing; safe to call from the
+// display core while audio runs on the other.
+void takeVoicePeaks(uint8_t peaks[NUM_VOICES]);
+
+// Mix the next output sample of all voices, clamped to the 8-bit range
+int8_t renderSample();
+
+// Render count consecutive output samples
+void renderBlock(int8_t* out, int count);
+
+#endif  // SAMPLE_ENGINE_H
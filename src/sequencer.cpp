@@ -0,0 +1,176 @@
+/*
+  Step sequencer - see sequencer.h
+*/
+
+#include "sequencer.h"
+
+#include <Mozzi.h>
+
+// A step lasts MOZZI_AUDIO_RATE * 60 / (tempo * SEQ_STEPS_PER_BEAT) samples
+#define STEP_SAMPLES_NUMERATOR ((uint64_t)MOZZI_AUDIO_RATE * 60)
+
+// Default pattern: kick on the beats, snare on 2 and 4, eighth-note hats
+SequencerPattern sequencerPattern = {
+    16,
+    {0x1111111111111111ull,   // Kick: steps 0, 4, 8, 12
+     0x1010101010101010ull,   // Snare: steps 4, 12
+     0x5555555555555555ull,   // Hihat: every other step
+     0x0000000000000000ull},  // Tom
+    {}};                      // Every step at full velocity
+
+static bool running = false;
+static uint16_t tempo = 120;
+static uint8_t swing = SEQ_SWING_STRAIGHT;
+static uint32_t nextStep = 0;  // Steps scheduled since start
+
+// Live recording
+static bool recording = false;
+static uint8_t recordGrid = 1;
+static uint64_t skipOnce[SEQ_TRACKS];  // Recorded ahead, already heard live
+
+// Step grid: step n starts at anchorClock plus
+// (n - anchorStep) * stepNumerator / stepDenominator samples
+static uint32_t anchorClock = 0;
+static uint32_t anchorStep = 0;
+static uint32_t stepNumerator = STEP_SAMPLES_NUMERATOR;
+static uint32_t stepDenominator = 120 * SEQ_STEPS_PER_BEAT;
+
+static uint32_t gridClock(uint32_t stepCount) {
+  int64_t steps = (int32_t)(stepCount - anchorStep);
+  return anchorClock +
+         (uint32_t)(steps * (int64_t)stepNumerator / stepDenominator);
+}
+
+uint32_t sequencerStepClock(uint32_t stepCount) {
+  uint32_t clock = gridClock(stepCount);
+
+  // Off-beats land later by the swing amount
+  if (stepCount & 1) {
+    clock += (uint32_t)((uint64_t)stepNumerator * (swing - SEQ_SWING_STRAIGHT) /
+                        ((uint64_t)stepDenominator * SEQ_SWING_STRAIGHT));
+  }
+  return clock;
+}
+
+void sequencerStart(uint32_t sampleClock) {
+  anchorClock = sampleClock;
+  anchorStep = 0;
+  nextStep = 0;
+  running = true;
+  for (int track = 0; track < SEQ_TRACKS; track++) skipOnce[track] = 0;
+}
+
+void sequencerSkipBefore(uint32_t sampleClock) {
+  while (running && (int32_t)(sequencerStepClock(nextStep) - sampleClock) < 0) {
+    nextStep++;
+  }
+}
+
+void sequencerStop() {
+  running = false;
+  clearScheduledTriggers(TRIGGER_SOURCE_SEQUENCER);
+  for (int track = 0; track < SEQ_TRACKS; track++) skipOnce[track] = 0;
+}
+
+bool sequencerRunning() { return running; }
+
+void sequencerSetTempo(uint16_t bpm) {
+  if (bpm < SEQ_MIN_BPM) bpm = SEQ_MIN_BPM;
+  if (bpm > SEQ_MAX_BPM) bpm = SEQ_MAX_BPM;
+
+  // Re-anchor on the next step so the change doesn't move it
+  anchorClock = gridClock(nextStep);
+  anchorStep = nextStep;
+  stepNumerator = STEP_SAMPLES_NUMERATOR;
+  stepDenominator = (uint32_t)bpm * SEQ_STEPS_PER_BEAT;
+  tempo = bpm;
+}
+
+uint16_t sequencerTempo() { return tempo; }
+
+void sequencerSync(uint32_t stepCount, uint32_t sampleClock,
+                   uint32_t stepSamplesQ8) {
+  anchorClock = sampleClock;
+  anchorStep = stepCount;
+  stepNumerator = stepSamplesQ8;
+  stepDenominator = 256;
+}
+
+void sequencerSetSwing(uint8_t percent) {
+  if (percent < SEQ_SWING_STRAIGHT) percent = SEQ_SWING_STRAIGHT;
+  if (percent > SEQ_SWING_MAX) percent = SEQ_SWING_MAX;
+  swing = percent;
+}
+
+uint8_t sequencerSwing() { return swing; }
+
+void sequencerSchedule(uint32_t horizon) {
+  while (running) {
+    uint32_t clock = sequencerStepClock(nextStep);
+    if ((int32_t)(clock - horizon) >= 0) return;
+
+    uint32_t position = nextStep % sequencerPattern.length;
+    uint64_t bit = 1ull << position;
+    for (int track = 0; track < SEQ_TRACKS; track++) {
+      if (!(sequencerPattern.steps[track] & bit)) continue;
+      if (skipOnce[track] & bit) {
+        skipOnce[track] &= ~bit;
+        continue;
+      }
+      uint8_t velocity = sequencerPattern.velocity[track][position];
+      scheduleTrigger(track, clock, velocity ? velocity : VELOCITY_MAX,
+                      TRIGGER_SOURCE_SEQUENCER);
+    }
+    nextStep++;
+  }
+}
+
+void sequencerSetRecording(bool on) { recording = on; }
+
+bool sequencerRecording() { return recording; }
+
+void sequencerSetRecordGrid(uint8_t steps) {
+  if (steps == 1 || steps == 2 || steps == SEQ_GRID_MAX) recordGrid = steps;
+}
+
+uint8_t sequencerRecordGrid() { return recordGrid; }
+
+// Step count whose unswung grid time is the last at or before sampleClock
+static uint32_t stepAtClock(uint32_t sampleClock) {
+  int64_t scaled = (int64_t)(int32_t)(sampleClock - anchorClock) *
+                   stepDenominator;
+  int64_t steps = scaled >= 0
+                      ? scaled / stepNumerator
+                      : -((-scaled + stepNumerator - 1) / stepNumerator);
+  return anchorStep + (uint32_t)steps;
+}
+
+bool sequencerRecord(int track, uint32_t sampleClock, uint8_t velocity) {
+  if (!recording || !running || track < 0 || track >= SEQ_TRACKS) {
+    return false;
+  }
+
+  // Nearest grid step by swung time: the grid step at or before the
+  // unswung step, or one either side of it
+  uint32_t before = stepAtClock(sampleClock) & ~(uint32_t)(recordGrid - 1);
+  uint32_t nearest = before;
+  uint32_t nearestDistance = UINT32_MAX;
+  for (int i = -1; i <= 1; i++) {
+    uint32_t step = before + i * recordGrid;
+    int32_t offset = (int32_t)(sequencerStepClock(step) - sampleClock);
+    uint32_t distance = offset < 0 ? -(uint32_t)offset : offset;
+    if (distance < nearestDistance) {
+      nearest = step;
+      nearestDistance = distance;
+    }
+  }
+
+  uint32_t position = nearest % sequencerPattern.length;
+  uint64_t bit = 1ull << position;
+  sequencerPattern.steps[track] |= bit;
+  sequencerPattern.velocity[track][position] = velocity ? velocity : 1;
+
+  // Not queued yet: the coming pass would repeat the live hit
+  if ((int32_t)(nearest - nextStep) >= 0) skipOnce[track] |= bit;
+  return true;
+}
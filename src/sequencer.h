@@ -0,0 +1,98 @@
+/*
+  Step sequencer timed by the audio sample clock.
+
+  Four tracks (one per pad) of 16, 32 or 64 sixteenth-note steps, with
+  swing. Step times are computed from the step count with exact integer
+  arithmetic, so they never drift however long the sequencer runs. The audio
+  path calls sequencerSchedule() before rendering each block, and every
+  step due within the horizon goes into the engine's trigger queue. Steps
+  therefore start on their exact sample, unaffected by the control rate or
+  the display.
+
+  Live recording: while recording, sequencerRecord() drops each live hit
+  onto the nearest step of the record grid (every step, every other step
+  or every beat) and keeps its velocity. Quantizing happens once, at
+  insertion; playback only reads bits. The live hit itself has already
+  been triggered by then, so recording never delays it. A hit quantized
+  forward onto a step not yet queued would sound twice (live, then
+  sequenced a moment later), so that one pass of the step is skipped.
+
+  Call everything from the audio core; on the module updateControl() and
+  updateAudio() both run from audioHook().
+*/
+
+#ifndef SEQUENCER_H
+#define SEQUENCER_H
+
+#include <Arduino.h>
+
+#include "sample_engine.h"
+
+#define SEQ_TRACKS NUM_VOICES
+#define SEQ_MAX_STEPS 64
+#define SEQ_STEPS_PER_BEAT 4  // Sixteenth notes
+#define SEQ_MIN_BPM 40
+#define SEQ_MAX_BPM 300
+#define SEQ_SWING_STRAIGHT 50  // Off-beat exactly halfway through the pair
+#define SEQ_SWING_MAX 75       // Off-beat three quarters through the pair
+#define SEQ_GRID_MAX 4         // Coarsest record grid, one beat
+
+// Fixed size, no allocation: a bit and a velocity byte per step. Velocity
+// 0 plays at VELOCITY_MAX (steps set without one, like the default).
+struct SequencerPattern {
+  uint8_t length;              // 16, 32 or 64 steps
+  uint64_t steps[SEQ_TRACKS];  // Bit n set: the track plays on step n
+  uint8_t velocity[SEQ_TRACKS][SEQ_MAX_STEPS];
+};
+
+extern SequencerPattern sequencerPattern;
+
+// Start with the first step at sampleClock (use a clock at least one block
+// ahead so the step is not late)
+void sequencerStart(uint32_t sampleClock);
+
+// Skip the steps that start before sampleClock, for a grid anchored on a
+// clock already past (an external pulse stamped on the DAC clock). Those
+// steps would otherwise all fire late, on the next rendered sample.
+void sequencerSkipBefore(uint32_t sampleClock);
+
+// Stop and drop its steps already queued in the engine. MIDI and serial
+// triggers queued for later still fire.
+void sequencerStop();
+
+bool sequencerRunning();
+
+// Tempo changes take effect from the next step, keeping it where it was
+void sequencerSetTempo(uint16_t bpm);
+uint16_t sequencerTempo();
+
+// Follow an external clock: put step stepCount on sampleClock, with steps
+// stepSamplesQ8 / 256 samples apart from there. Queued steps keep their
+// time; the next step moves to the new grid. sequencerSetTempo() returns to
+// the internal tempo.
+void sequencerSync(uint32_t stepCount, uint32_t sampleClock,
+                   uint32_t stepSamplesQ8);
+
+// Percent of a step pair before the off-beat, SEQ_SWING_STRAIGHT..MAX
+void sequencerSetSwing(uint8_t percent);
+uint8_t sequencerSwing();
+
+// Queue every step that starts before horizon
+void sequencerSchedule(uint32_t horizon);
+
+// Sample clock of a step, counted from start, including swing
+uint32_t sequencerStepClock(uint32_t stepCount);
+
+// Record live hits into the pattern (only while the sequencer runs)
+void sequencerSetRecording(bool on);
+bool sequencerRecording();
+
+// Record grid in steps: 1 (sixteenths), 2 (eighths) or SEQ_GRID_MAX
+void sequencerSetRecordGrid(uint8_t steps);
+uint8_t sequencerRecordGrid();
+
+// Put a hit the player heard at sampleClock on the nearest grid step.
+// Call after triggering the hit live. Returns false when not recording.
+bool sequencerRecord(int track, uint32_t sampleClock, uint8_t velocity);
+
+#endif  // SEQUENCER_H
@@ -0,0 +1,175 @@
+/*
+  Framed binary control protocol - see serial_protocol.h
+*/
+
+#include "serial_protocol.h"
+
+// Arguments after the opcode, or -1 for opcodes the module does not take
+static int commandArgumentBytes(uint8_t opcode) {
+  switch (opcode) {
+    case SERIAL_CMD_TRIGGER:
+    case SERIAL_CMD_SET:
+      return 6;
+    case SERIAL_CMD_STATS:
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+static uint32_t readU32(const uint8_t* data) {
+  return data[0] | data[1] << 8 | data[2] << 16 | (uint32_t)data[3] << 24;
+}
+
+uint16_t serialCrc16(const uint8_t* data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i] << 8;
+    for (int bit = 0; bit < 8; bit++) {
+      crc = crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1;
+    }
+  }
+  return crc;
+}
+
+// Undo COBS in place. Returns the decoded length, or -1 if malformed.
+static int cobsDecode(uint8_t* data, int length) {
+  int read = 0;
+  int write = 0;
+  while (read < length) {
+    uint8_t code = data[read++];
+    if (code == 0 || read + code - 1 > length) return -1;
+    for (int i = 1; i < code; i++) data[write++] = data[read++];
+    if (code < 0xFF && read < length) data[write++] = 0;
+  }
+  return write;
+}
+
+// Check a decoded frame: CRC, then that the commands fill it exactly
+static bool validFrame(const uint8_t* data, int length) {
+  if (length < 3) return false;
+  int payload = length - 2;
+  uint16_t crc = data[payload] | data[payload + 1] << 8;
+  if (serialCrc16(data, payload) != crc) return false;
+
+  int position = 0;
+  while (position < payload) {
+    int arguments = commandArgumentBytes(data[position]);
+    if (arguments < 0) return false;
+    position += 1 + arguments;
+  }
+  return position == payload;
+}
+
+void serialLinkReset(SerialLink& link) {
+  link.length = 0;
+  link.payloadLength = 0;
+  link.readPosition = 0;
+  link.inFrame = false;
+  link.afterFrame = false;
+  link.overflow = false;
+  link.framesOk = 0;
+  link.framesBad = 0;
+}
+
+SerialEvent serialLinkByte(SerialLink& link, uint8_t byte) {
+  if (!link.inFrame) {
+    if (byte != 0) return SERIAL_KEY;
+    link.inFrame = true;
+    link.afterFrame = false;
+    link.length = 0;
+    link.overflow = false;
+    return SERIAL_NONE;
+  }
+
+  if (byte != 0) {
+    if (link.length < sizeof(link.buffer)) {
+      link.buffer[link.length++] = byte;
+    } else {
+      link.overflow = true;  // Keep going until the closing zero
+    }
+    return SERIAL_NONE;
+  }
+
+  // An empty frame is just back-to-back delimiters: this zero opens a frame
+  if (link.length == 0 && !link.overflow) {
+    link.afterFrame = false;
+    return SERIAL_NONE;
+  }
+
+  int decoded = link.overflow ? -1 : cobsDecode(link.buffer, link.length);
+
+  // This zero may also be the next frame's opener, if this frame lost its
+  // closing zero, so the link stays in frame mode. Bytes after it are a
+  // frame unless the port goes quiet first (serialLinkIdle()).
+  link.length = 0;
+  link.overflow = false;
+  link.afterFrame = true;
+
+  if (decoded < 0 || !validFrame(link.buffer, decoded)) {
+    link.payloadLength = 0;
+    link.framesBad++;
+    return SERIAL_BAD_FRAME;
+  }
+
+  link.payloadLength = decoded - 2;
+  link.readPosition = 0;
+  link.framesOk++;
+  return SERIAL_FRAME;
+}
+
+int serialLinkIdle(SerialLink& link) {
+  if (!link.inFrame || !link.afterFrame) return 0;
+  int keys = link.overflow ? 0 : link.length;
+  link.inFrame = false;
+  link.afterFrame = false;
+  link.length = 0;
+  link.overflow = false;
+  return keys;
+}
+
+bool serialNextCommand(SerialLink& link, SerialCommand& command) {
+  if (link.readPosition >= link.payloadLength) return false;
+
+  const uint8_t* data = link.buffer + link.readPosition;
+  command.opcode = data[0];
+  command.target = 0;
+  command.detail = 0;
+  command.value = 0;
+  if (commandArgumentBytes(data[0]) == 6) {
+    command.target = data[1];
+    command.detail = data[2];
+    command.value = readU32(data + 3);
+  }
+  link.readPosition += 1 + commandArgumentBytes(data[0]);
+  return true;
+}
+
+size_t serialEncodeFrame(const uint8_t* payload, size_t length, uint8_t* out) {
+  uint16_t crc = serialCrc16(payload, length);
+  size_t total = length + 2;
+  size_t write = 0;
+  out[write++] = 0;
+
+  // COBS: each block starts with the distance to the next zero
+  size_t code = write++;
+  uint8_t run = 1;
+  for (size_t i = 0; i < total; i++) {
+    uint8_t byte = i < length ? payload[i] : (i == length ? crc : crc >> 8);
+    if (byte == 0) {
+      out[code] = run;
+      code = write++;
+      run = 1;
+      continue;
+    }
+    out[write++] = byte;
+    if (++run == 0xFF) {
+      out[code] = run;
+      code = write++;
+      run = 1;
+    }
+  }
+  out[code] = run;
+  out[write++] = 0;
+  return write;
+}
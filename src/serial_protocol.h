@@ -0,0 +1,117 @@
+/*
+  Framed binary control protocol over the USB serial port.
+
+  Frames carry batches of commands, so a host can drive the module at
+  thousands of events per second (tools/sampler_link.py). On the wire
+  each frame is
+
+    0x00, COBS(payload, CRC-16), 0x00
+
+  COBS removes every zero byte from the encoded data, so a zero always
+  marks a frame boundary. The CRC is CRC-16/CCITT-FALSE over the payload,
+  sent low byte first. A frame with a bad CRC or an unknown command is
+  dropped whole, so a batch never runs halfway. Bytes outside frames are
+  the one-key serial commands, so typing into a serial monitor still works.
+
+  Every zero both closes the frame before it and opens the next one, so a
+  frame that loses its closing zero costs at most itself: the frames after
+  it never spill into the key path. Bytes after a closing zero are held as
+  a frame; only if the port then stays quiet for SERIAL_KEY_GAP_MS, which
+  a host never does mid-frame, are they handed out as typed keys.
+
+  The payload is one or more commands, each an opcode followed by fixed
+  arguments (multi-byte values little-endian):
+
+    0x01 trigger   pad, velocity, u32 sample clock   (7 bytes)
+    0x02 set       parameter, voice, i32 value       (7 bytes)
+    0x03 stats     (1 byte), answered with a stats frame
+
+  A trigger starts the pad on an exact engine sample clock; a clock already
+  past plays on the next sample. The clock comes from a stats reply:
+
+    0x83 stats     u32 engine clock, u32 frames ok, u32 frames bad,
+                   u32 commands, u32 triggers dropped (queue full),
+                   u16 load in 0.1%, u32 underruns, u8 playing voice mask
+
+  Shared with the native host build, which checks framing, batching and
+  recovery from corrupt input (program serial).
+*/
+
+#ifndef SERIAL_PROTOCOL_H
+#define SERIAL_PROTOCOL_H
+
+#include <Arduino.h>
+
+#define SERIAL_FRAME_MAX 256  // Largest payload, CRC included
+
+// Command opcodes
+#define SERIAL_CMD_TRIGGER 0x01
+#define SERIAL_CMD_SET 0x02
+#define SERIAL_CMD_STATS 0x03
+#define SERIAL_REPLY_STATS 0x83
+
+// Parameters for SERIAL_CMD_SET
+#define SERIAL_PARAM_TEMPO 0         // BPM
+#define SERIAL_PARAM_SWING 1         // Percent, 50 is straight
+#define SERIAL_PARAM_STEPS 2         // Pattern length: 16, 32 or 64
+#define SERIAL_PARAM_RUNNING 3       // 1 starts the sequencer, 0 stops it
+#define SERIAL_PARAM_PITCH 4         // Per voice, Q16.16 playback rate
+#define SERIAL_PARAM_DECAY 5         // Per voice, Q16 per-block level factor
+#define SERIAL_PARAM_SAMPLE 6        // Per voice, sample bank index
+#define SERIAL_PARAM_CV_TARGET 7     // Voice mask the CV inputs control
+#define SERIAL_PARAM_LEVEL 8         // Per voice, Q15 pad level
+#define SERIAL_PARAM_PRESET 9        // Recall a kit preset slot (0-7)
+#define SERIAL_PARAM_PRESET_SAVE 10  // Save the kit to a preset slot
+#define SERIAL_PARAM_RECORD 11       // 1 records live hits, 0 stops
+#define SERIAL_PARAM_RECORD_GRID 12  // Record grid in steps: 1, 2 or 4
+
+struct SerialCommand {
+  uint8_t opcode;
+  uint8_t target;  // Pad (trigger) or parameter (set)
+  uint8_t detail;  // Velocity (trigger) or voice (set)
+  uint32_t value;  // Sample clock (trigger) or value (set)
+};
+
+enum SerialEvent : uint8_t {
+  SERIAL_NONE,       // Byte consumed, nothing complete yet
+  SERIAL_KEY,        // A one-key command outside any frame
+  SERIAL_FRAME,      // A valid frame; read it with serialNextCommand()
+                     // before feeding the next byte
+  SERIAL_BAD_FRAME,  // A frame failed COBS, CRC, length or opcode checks
+};
+
+struct SerialLink {
+  uint8_t buffer[SERIAL_FRAME_MAX + 2];  // Encoded, then decoded in place
+  uint16_t length;
+  uint16_t payloadLength;  // Decoded payload of the last good frame
+  uint16_t readPosition;   // Next command in the payload
+  bool inFrame;
+  bool afterFrame;  // Held since a closing zero: may be typed keys
+  bool overflow;
+  uint32_t framesOk;
+  uint32_t framesBad;
+};
+
+// Forget any frame in progress and clear the counters
+void serialLinkReset(SerialLink& link);
+
+// Feed one received byte
+SerialEvent serialLinkByte(SerialLink& link, uint8_t byte);
+
+// Call once no byte has arrived for SERIAL_KEY_GAP_MS. Bytes held since
+// the last frame were typed keys: returns how many, left at the start of
+// link.buffer, and goes back to key mode.
+#define SERIAL_KEY_GAP_MS 50
+int serialLinkIdle(SerialLink& link);
+
+// The next command of the last good frame. Returns false after the last.
+bool serialNextCommand(SerialLink& link, SerialCommand& command);
+
+// Encode a payload as a complete frame, delimiters included. out needs
+// room for SERIAL_ENCODED_MAX(length) bytes. Returns the frame length.
+#define SERIAL_ENCODED_MAX(length) ((length) + 2 + (length) / 254 + 4)
+size_t serialEncodeFrame(const uint8_t* payload, size_t length, uint8_t* out);
+
+uint16_t serialCrc16(const uint8_t* data, size_t length);
+
+#endif  // SERIAL_PROTOCOL_H
@@ -0,0 +1,50 @@
+/*
+  Zipper-free parameter changes - see smoothed_param.h
+*/
+
+#include "smoothed_param.h"
+
+void paramSetTarget(SmoothedParam& param, int32_t target) {
+  if (target == param.target) return;
+  param.target = target;
+  if (param.mode != PARAM_RAMP_LINEAR) return;
+
+  // Split the distance into rate steps, rounding away from zero so the
+  // last block is the short one
+  int32_t distance = target - param.end;
+  int32_t round = distance > 0 ? param.rate - 1 : 1 - param.rate;
+  param.blockDelta = (distance + round) / param.rate;
+}
+
+void paramJump(SmoothedParam& param, int32_t value) {
+  param.current = value;
+  param.step = 0;
+  param.end = value;
+  param.target = value;
+  param.blockDelta = 0;
+}
+
+bool paramBlockStart(SmoothedParam& param, int count) {
+  // Ticks can leave the value short by the step's rounding; pick up
+  // exactly where the last block was meant to end
+  param.current = param.end;
+  if (param.end == param.target) {
+    param.step = 0;
+    return false;
+  }
+
+  int32_t next;
+  if (param.mode == PARAM_RAMP_LINEAR) {
+    next = param.end + param.blockDelta;
+    bool passed = param.blockDelta > 0 ? next > param.target
+                                       : next < param.target;
+    if (passed) next = param.target;
+  } else {
+    int32_t delta = (param.target - param.end) >> param.rate;
+    next = delta == 0 ? param.target : param.end + delta;
+  }
+
+  param.step = (next - param.end) / count;
+  param.end = next;
+  return true;
+}
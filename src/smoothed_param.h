@@ -0,0 +1,58 @@
+/*
+  Zipper-free parameter changes in fixed point.
+
+  A SmoothedParam holds a target and the value actually in use. Once per
+  render block paramBlockStart() picks where the value will be at the end
+  of the block and the per-sample step to get there, so a change becomes a
+  straight line across the block instead of a jump at its start. How the
+  block end values approach the target is the ramp mode:
+
+    PARAM_RAMP_LINEAR       equal steps, reaching the target in `rate`
+                            blocks (1: within the next block)
+    PARAM_RAMP_EXPONENTIAL  1/2^rate of the remaining distance per block,
+                            snapping to the target once that rounds to 0
+
+  A parameter at its target costs one compare per block: paramBlockStart()
+  returns false and the caller skips paramTick() for the whole block. A
+  block-rate consumer can read `end` without ticking at all.
+
+  Values are plain int32_t in whatever fixed-point format the parameter
+  uses (Q15 level, Q16.16 playback rate, ...). Targets and values must stay
+  within +/-2^30 so the differences fit.
+*/
+
+#ifndef SMOOTHED_PARAM_H
+#define SMOOTHED_PARAM_H
+
+#include <Arduino.h>
+
+enum ParamRamp : uint8_t { PARAM_RAMP_LINEAR, PARAM_RAMP_EXPONENTIAL };
+
+struct SmoothedParam {
+  int32_t current;     // Value for the next sample
+  int32_t step;        // Added per sample this block, 0 when settled
+  int32_t end;         // Value at the end of this block
+  int32_t target;
+  int32_t blockDelta;  // Linear ramps: change per block
+  ParamRamp mode;
+  uint8_t rate;        // Blocks per linear ramp, or exponential shift
+};
+
+// Static initializer for a parameter settled at value
+#define SMOOTHED_PARAM(value, mode, rate) \
+  { (value), 0, (value), (value), 0, (mode), (rate) }
+
+// Ramp towards a new target from wherever the value is now
+void paramSetTarget(SmoothedParam& param, int32_t target);
+
+// Move straight to a value with no ramp (e.g. when a voice restarts)
+void paramJump(SmoothedParam& param, int32_t value);
+
+// Plan the next block of count samples. Returns false when the value holds
+// for the whole block (the fast path), true when it moves.
+bool paramBlockStart(SmoothedParam& param, int count);
+
+// Advance one sample of a moving block
+inline void paramTick(SmoothedParam& param) { param.current += param.step; }
+
+#endif  // SMOOTHED_PARAM_H
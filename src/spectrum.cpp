@@ -0,0 +1,94 @@
+/*
+  Spectrum analyzer - see spectrum.h
+*/
+
+#include "spectrum.h"
+
+#include "cycle_counter.h"
+
+enum SpectrumPhase : uint8_t {
+  PHASE_WAIT,    // For the audio core to complete a buffer
+  PHASE_LOAD,    // Window and bit-reverse
+  PHASE_STAGES,  // One butterfly stage per step
+  PHASE_BARS     // Magnitudes to bar heights
+};
+
+// Capture double buffer: the audio core only writes captureBuffers[filling]
+static int8_t captureBuffers[2][FFT_SIZE];
+static int filling = 0;
+static int captured = 0;
+static volatile int readyBuffer = -1;  // Complete set for the display core
+
+// Analysis state (display core)
+static int16_t re[FFT_SIZE];
+static int16_t im[FFT_SIZE];
+static uint8_t bars[SPECTRUM_BINS];
+static SpectrumPhase phase = PHASE_WAIT;
+static int nextStage = 1;
+
+void spectrumCapture(const int8_t* samples, int count) {
+  for (int i = 0; i < count; i++) {
+    captureBuffers[filling][captured++] = samples[i];
+    if (captured < FFT_SIZE) continue;
+
+    captured = 0;
+    if (readyBuffer < 0) {
+      readyBuffer = filling;
+      filling ^= 1;
+    }
+    // else: the display core is behind, refill the same half
+  }
+}
+
+// Quarter-bit log2 of a bin's magnitude, mapped to a bar height
+static uint8_t barHeight(int32_t real, int32_t imaginary) {
+  uint32_t a = real < 0 ? -real : real;
+  uint32_t b = imaginary < 0 ? -imaginary : imaginary;
+  uint32_t magnitude = a > b ? a + (b * 3 >> 3) : b + (a * 3 >> 3);
+  if (magnitude < 4) return 0;
+
+  int msb = 31 - __builtin_clz(magnitude);
+  int log4 = msb * 4 + ((magnitude >> (msb - 2)) & 3);
+  int height = log4 - (SPECTRUM_FULL_SCALE_LOG4 - SPECTRUM_HEIGHT);
+
+  if (height < 0) return 0;
+  return height > SPECTRUM_HEIGHT ? SPECTRUM_HEIGHT : height;
+}
+
+bool spectrumStep(uint32_t budgetCycles) {
+  uint32_t start = readCycleCounter();
+
+  while (readCycleCounter() - start < budgetCycles) {
+    switch (phase) {
+      case PHASE_WAIT:
+        if (readyBuffer < 0) return false;
+        phase = PHASE_LOAD;
+        break;
+
+      case PHASE_LOAD:
+        fftLoadQ15(captureBuffers[readyBuffer], re, im);
+        readyBuffer = -1;  // Hand the half back to the audio core
+        nextStage = 1;
+        phase = PHASE_STAGES;
+        break;
+
+      case PHASE_STAGES:
+        fftStageQ15(re, im, nextStage);
+        if (++nextStage > FFT_LOG2_SIZE) phase = PHASE_BARS;
+        break;
+
+      case PHASE_BARS:
+        for (int bin = 0; bin < SPECTRUM_BINS; bin++) {
+          uint8_t height = barHeight(re[bin], im[bin]);
+          uint8_t fallen = bars[bin] > SPECTRUM_FALL ? bars[bin] - SPECTRUM_FALL
+                                                     : 0;
+          bars[bin] = height > fallen ? height : fallen;
+        }
+        phase = PHASE_WAIT;
+        return true;
+    }
+  }
+  return false;
+}
+
+const uint8_t* spectrumBars() { return bars; }
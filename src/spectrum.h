@@ -0,0 +1,37 @@
+/*
+  Spectrum analyzer for the OLED, fed from the master output.
+
+  The audio core copies its rendered blocks into one half of a double
+  buffer; when FFT_SIZE samples are complete and the display core has taken
+  the previous set, the halves swap. Otherwise the new set is dropped, so
+  capture never waits.
+
+  The display core runs the FFT a slice at a time with spectrumStep(), which
+  stops once its cycle budget is spent and resumes on the next call. Bars
+  are on a log scale (6 dB per 4 pixels, 48 dB range) and fall slowly like
+  the level meters.
+*/
+
+#ifndef SPECTRUM_H
+#define SPECTRUM_H
+
+#include <Arduino.h>
+
+#include "fft_q15.h"
+
+#define SPECTRUM_BINS (FFT_SIZE / 2)
+#define SPECTRUM_HEIGHT 32         // Tallest bar, pixels
+#define SPECTRUM_FALL 2            // Pixels a bar drops per spectrum
+#define SPECTRUM_FULL_SCALE_LOG4 48  // 4*log2 of a full-scale sine's bin
+
+// Audio core: append rendered output samples
+void spectrumCapture(const int8_t* samples, int count);
+
+// Display core: advance the analysis for at most about budgetCycles of
+// readCycleCounter(). Returns true when a new set of bars is ready.
+bool spectrumStep(uint32_t budgetCycles);
+
+// Bar heights, SPECTRUM_BINS of them, 0..SPECTRUM_HEIGHT
+const uint8_t* spectrumBars();
+
+#endif  // SPECTRUM_H
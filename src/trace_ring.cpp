@@ -0,0 +1,94 @@
+/*
+  Binary trace ring - see trace_ring.h
+*/
+
+#include "trace_ring.h"
+
+#include <stdio.h>
+
+#define TRACE_EVENTS_PER_LINE 8
+
+TraceRing traceRings[TRACE_CORES];
+volatile bool traceFrozen = false;
+
+// Dump in progress, kept between calls
+static bool dumping = false;
+static int dumpCore = -1;  // -1: header not written yet
+static uint32_t dumpHead = 0;
+static uint32_t dumpCount = 0;
+static uint32_t dumpIndex = 0;
+
+static void startCoreDump(int core) {
+  // A write that began before the freeze may still land on the slot after
+  // head, which is the oldest slot of a full ring, so that one is skipped
+  const TraceRing& ring = traceRings[core];
+  dumpCore = core;
+  dumpHead = ring.head;
+  dumpCount = dumpHead - ring.dumped;
+  if (dumpCount > TRACE_RING_SIZE - 1) dumpCount = TRACE_RING_SIZE - 1;
+  dumpIndex = 0;
+}
+
+// Format the next line of the current core's events. Returns its length
+// and how many events it holds.
+static size_t formatEventLine(char* line, uint32_t& events) {
+  static const char hexDigits[] = "0123456789abcdef";
+  const TraceRing& ring = traceRings[dumpCore];
+  char* p = line;
+  *p++ = 'T';
+  *p++ = '0' + dumpCore;
+  *p++ = ' ';
+
+  uint32_t i = dumpIndex;
+  for (int n = 0; n < TRACE_EVENTS_PER_LINE && i < dumpCount; n++, i++) {
+    const TraceEvent& event =
+        ring.events[(dumpHead - dumpCount + i) & (TRACE_RING_SIZE - 1)];
+    const uint8_t* bytes = (const uint8_t*)&event;
+    for (size_t b = 0; b < sizeof(TraceEvent); b++) {
+      *p++ = hexDigits[bytes[b] >> 4];
+      *p++ = hexDigits[bytes[b] & 0x0F];
+    }
+  }
+  *p = '\0';
+  events = i - dumpIndex;
+  return p - line;
+}
+
+bool traceDump(LogWriteFn write) {
+  char line[4 + TRACE_EVENTS_PER_LINE * 2 * sizeof(TraceEvent) + 1];
+
+  if (!dumping) {
+    traceFrozen = true;
+    dumping = true;
+    dumpCore = -1;
+  }
+
+  for (int lines = 0; lines < TRACE_DUMP_LINES_PER_CALL; lines++) {
+    if (dumpCore < 0) {
+      int length = snprintf(line, sizeof(line),
+                            "# trace,cores=%d,ring_size=%d,"
+                            "timestamp_hz=1000000",
+                            TRACE_CORES, TRACE_RING_SIZE);
+      if (!write(line, length)) return false;
+      startCoreDump(0);
+      continue;
+    }
+
+    if (dumpIndex == dumpCount) {
+      traceRings[dumpCore].dumped = dumpHead;
+      if (dumpCore + 1 == TRACE_CORES) {
+        dumping = false;
+        traceFrozen = false;
+        return true;
+      }
+      startCoreDump(dumpCore + 1);
+      continue;
+    }
+
+    uint32_t events;
+    size_t length = formatEventLine(line, events);
+    if (!write(line, length)) return false;
+    dumpIndex += events;
+  }
+  return false;
+}
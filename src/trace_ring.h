@@ -0,0 +1,102 @@
+/*
+  Binary trace ring for hot-path events.
+
+  Each core records compact 8-byte events into its own ring in SRAM, so a
+  write never contends with the other core. Interrupts are masked on the
+  writing core only for the handful of instructions that claim a slot and
+  store the event. The rings overwrite their oldest events, keeping the most
+  recent TRACE_RING_SIZE events per core as a flight recorder. Only the
+  owning core writes a ring's head; a dump keeps its own read index, so
+  dumping from core 0 never races core 1's writes.
+
+  traceDump() (serial 't' command) prints the rings as hex lines, a few per
+  call so the port never blocks the audio loop. Recording stops while a
+  dump is in progress:
+    # trace,cores=<n>,ring_size=<events>,timestamp_hz=1000000
+    T<core> <16 hex chars per event>...
+  tools/trace_to_perfetto.py turns a captured dump into Chrome/Perfetto JSON.
+*/
+
+#ifndef TRACE_RING_H
+#define TRACE_RING_H
+
+#include <Arduino.h>
+
+#include "deferred_log.h"
+
+#ifdef SAMPLER_NATIVE
+#include "cycle_counter.h"
+#else
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+#include <pico/platform.h>
+#endif
+
+#define TRACE_RING_SIZE 512  // Events per core, power of two
+#define TRACE_CORES 2
+#define TRACE_DUMP_LINES_PER_CALL 4  // ~530 bytes, under a USB write buffer
+
+enum TraceEventType : uint8_t {
+  TRACE_TRIGGER = 1,      // arg: voice, data: TraceTriggerSource
+  TRACE_VOICE_START = 2,  // arg: voice
+  TRACE_VOICE_END = 3,    // arg: voice
+  TRACE_BLOCK_START = 4,  // data: samples in the block
+  TRACE_BLOCK_END = 5,    // data: voices playing
+  TRACE_UNDERRUN = 6,
+  TRACE_EDGE = 7,         // arg: voice (raw GPIO edge)
+  TRACE_MIDI_NOTE = 8,    // arg: pad, data: velocity (note-on arrival)
+};
+
+enum TraceTriggerSource : uint16_t {
+  TRACE_SOURCE_BUTTON = 0,
+  TRACE_SOURCE_SERIAL = 1,
+  TRACE_SOURCE_SCHEDULED = 2,  // scheduleTrigger(), e.g. the sequencer
+};
+
+// 8 bytes, little-endian on both the RP2040 and the host
+struct TraceEvent {
+  uint32_t timestamp;  // Microseconds, wraps every ~71 minutes
+  uint8_t type;
+  uint8_t arg;
+  uint16_t data;
+};
+
+struct TraceRing {
+  TraceEvent events[TRACE_RING_SIZE];
+  volatile uint32_t head;  // Total events written; slot = head % size
+  uint32_t dumped;         // head at the last dump, traceDump() only
+};
+
+extern TraceRing traceRings[TRACE_CORES];
+extern volatile bool traceFrozen;  // Set while a dump reads the rings
+
+// Record an event on the calling core's ring
+inline void traceEvent(uint8_t type, uint8_t arg = 0, uint16_t data = 0) {
+  if (traceFrozen) return;
+
+#ifdef SAMPLER_NATIVE
+  TraceRing& ring = traceRings[0];
+  uint32_t timestamp = readCycleCounter() / 1000;
+  uint32_t head = ring.head;
+  ring.events[head & (TRACE_RING_SIZE - 1)] = {timestamp, type, arg, data};
+  ring.head = head + 1;
+#else
+  // The event is stored before head counts it, so a dump never reads a slot
+  // that is claimed but not yet written
+  TraceRing& ring = traceRings[get_core_num()];
+  uint32_t interrupts = save_and_disable_interrupts();
+  uint32_t head = ring.head;
+  ring.events[head & (TRACE_RING_SIZE - 1)] = {time_us_32(), type, arg, data};
+  __dmb();
+  ring.head = head + 1;
+  restore_interrupts(interrupts);
+#endif
+}
+
+// Print each ring's events since the last dump, oldest first. Writes up to
+// TRACE_DUMP_LINES_PER_CALL lines, fewer once write() reports the port is
+// busy; returns true when the dump is complete, false to be called again
+// on a later pass.
+bool traceDump(LogWriteFn write);
+
+#endif  // TRACE_RING_H
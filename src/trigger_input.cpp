@@ -0,0 +1,31 @@
+/*
+  Button/trigger input debouncing - see trigger_input.h
+*/
+
+#include "trigger_input.h"
+
+bool debounceButton(ButtonState& button, int reading, unsigned long now) {
+  bool pressed = false;
+
+  // Check if button state changed (for debouncing)
+  if (reading != button.lastState) {
+    button.lastDebounceTime = now;
+  }
+
+  // If enough time has passed since last state change
+  if ((now - button.lastDebounceTime) > DEBOUNCE_DELAY) {
+    // If the button state has actually changed
+    if (reading != button.currentState) {
+      button.currentState = reading;
+
+      // Trigger on falling edge (button press) - active LOW with pullup
+      if (button.currentState == LOW) {
+        button.triggered = true;
+        pressed = true;
+      }
+    }
+  }
+
+  button.lastState = reading;
+  return pressed;
+}
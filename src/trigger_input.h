@@ -0,0 +1,29 @@
+/*
+  Button/trigger input debouncing, shared with the native host build so
+  trigger timing can be simulated off-target.
+*/
+
+#ifndef TRIGGER_INPUT_H
+#define TRIGGER_INPUT_H
+
+#include <Arduino.h>
+
+// Debounce settings
+#define DEBOUNCE_DELAY 20    // 20ms debounce delay
+#define TRIGGER_MIN_PULSE 5  // Minimum 5ms pulse for eurorack triggers
+
+// Button/Trigger state tracking
+struct ButtonState {
+  int pin;
+  bool lastState;
+  bool currentState;
+  unsigned long lastDebounceTime;
+  bool triggered;
+  const char* name;
+};
+
+// Feed one pin reading taken at time now (ms). Returns true, and sets
+// button.triggered, on a debounced press (falling edge - active LOW).
+bool debounceButton(ButtonState& button, int reading, unsigned long now);
+
+#endif  // TRIGGER_INPUT_H
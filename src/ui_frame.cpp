@@ -0,0 +1,49 @@
+/*
+  OLED user interface composition - see ui_frame.h
+*/
+
+#include "ui_frame.h"
+
+#include <string.h>
+
+static void drawMeter(uint8_t* frame, int x, const LevelMeter& meter) {
+  int bar = meterPixels(meter.level, METER_HEIGHT);
+  int hold = meterPixels(meter.hold, METER_HEIGHT);
+
+  fillRows(frame, x, METER_WIDTH, METER_HEIGHT - bar, METER_HEIGHT);
+  if (hold > bar) {
+    fillRows(frame, x, METER_WIDTH, METER_HEIGHT - hold,
+             METER_HEIGHT - hold + 1);
+  }
+}
+
+static void drawWave(uint8_t* frame, const uint8_t* wave, int playhead) {
+  for (int page = 0; page < WAVE_PAGES; page++) {
+    uint8_t* row = frame + (UI_WAVE_PAGE + page) * OLED_COLUMNS;
+    memcpy(row, wave + page * WAVE_COLUMNS, WAVE_COLUMNS);
+    if (playhead >= 0) row[playhead] ^= 0xFF;
+  }
+}
+
+void composeUiFrame(uint8_t* frame, const UiFrameState& state) {
+  clearFrame(frame);
+
+  drawText(frame, 0, 0, "Pico DAC Sampler");
+
+  // Which pads are playing shows on the meters
+  drawIcon(frame, 1, 0, state.playingMask ? ICON_PLAYING : ICON_READY);
+  drawText(frame, 1, UI_NAME_COLUMN, state.lastName);
+
+  drawWave(frame, state.wave, state.playhead);
+
+  for (int i = 0; i < NUM_VOICES; i++) {
+    drawMeter(frame, METER_X + i * METER_SPACING, state.meters[i]);
+  }
+}
+
+void composeSpectrumFrame(uint8_t* frame, const uint8_t* bars) {
+  clearFrame(frame);
+  for (int bin = 0; bin < SPECTRUM_BINS && bin < OLED_COLUMNS; bin++) {
+    fillRows(frame, bin, 1, OLED_PAGES * 8 - bars[bin], OLED_PAGES * 8);
+  }
+}
@@ -0,0 +1,48 @@
+/*
+  Composes the OLED user interface into a page-format framebuffer.
+
+  Pads view (128x32):
+    page 0    title
+    page 1    playing/ready icon and the last triggered pad
+    page 2-3  waveform of that pad with its playhead
+    right     one level meter per pad, full height
+
+  Spectrum view: one bar per FFT bin across the whole screen.
+*/
+
+#ifndef UI_FRAME_H
+#define UI_FRAME_H
+
+#include <Arduino.h>
+
+#include "level_meter.h"
+#include "page_canvas.h"
+#include "sample_engine.h"
+#include "spectrum.h"
+#include "wave_overview.h"
+
+// Per-pad level meters: vertical bars at the right edge of the screen
+#define METER_X 100  // Left edge of the first bar
+#define METER_WIDTH 5
+#define METER_SPACING 7
+#define METER_HEIGHT (OLED_PAGES * 8)
+
+#define UI_NAME_COLUMN 9  // Pad name, after the icon
+#define UI_WAVE_PAGE 2
+
+enum UiView : uint8_t { UI_VIEW_PADS, UI_VIEW_SPECTRUM, UI_VIEW_COUNT };
+
+struct UiFrameState {
+  uint8_t playingMask;       // activeSampleMask() bits
+  const char* lastName;      // Name of the last triggered pad
+  const uint8_t* wave;       // waveOverview() of that pad
+  int playhead;              // Overview column being played, or -1
+  const LevelMeter* meters;  // NUM_VOICES meters
+};
+
+void composeUiFrame(uint8_t* frame, const UiFrameState& state);
+
+// bars: SPECTRUM_BINS heights from spectrumBars()
+void composeSpectrumFrame(uint8_t* frame, const uint8_t* bars);
+
+#endif  // UI_FRAME_H
@@ -0,0 +1,53 @@
+/*
+  Waveform overviews - see wave_overview.h
+*/
+
+#include "wave_overview.h"
+
+#include <string.h>
+
+#define WAVE_HALF_HEIGHT (WAVE_PAGES * 4)
+
+static uint8_t overviews[NUM_SAMPLES][WAVE_BYTES];
+
+// Set rows [top, bottom) of one overview column
+static void setColumnRows(uint8_t* overview, int column, int top, int bottom) {
+  for (int row = top; row < bottom; row++) {
+    overview[(row / 8) * WAVE_COLUMNS + column] |= 1 << (row & 7);
+  }
+}
+
+void buildWaveOverviews() {
+  for (int index = 0; index < NUM_SAMPLES; index++) {
+    const SampleData& source = sampleBank[index];
+    uint8_t* overview = overviews[index];
+    memset(overview, 0, WAVE_BYTES);
+
+    for (int column = 0; column < WAVE_COLUMNS; column++) {
+      uint32_t first = (uint64_t)source.length * column / WAVE_COLUMNS;
+      uint32_t end = (uint64_t)source.length * (column + 1) / WAVE_COLUMNS;
+
+      int peak = 0;
+      for (uint32_t i = first; i < end; i++) {
+        int8_t sample = pgm_read_byte(&source.data[i]);
+        int level = sample < 0 ? -sample : sample;
+        if (level > peak) peak = level;
+      }
+
+      // Anything audible gets at least one pixel either side of zero
+      int height = (peak * WAVE_HALF_HEIGHT + 127) / 128;
+      setColumnRows(overview, column, WAVE_HALF_HEIGHT - height,
+                    WAVE_HALF_HEIGHT + height);
+    }
+  }
+}
+
+const uint8_t* waveOverview(int voice) { return overviews[voiceSample(voice)]; }
+
+int wavePlayheadColumn(int voice) {
+  int32_t position = voicePosition(voice);
+  uint32_t length = samplePlayers[voice].length;
+  if (position < 0 || length == 0) return -1;
+  if ((uint32_t)position >= length) return WAVE_COLUMNS - 1;
+  return (int)((uint64_t)position * WAVE_COLUMNS / length);
+}
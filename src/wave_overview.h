@@ -0,0 +1,31 @@
+/*
+  Precomputed waveform overviews for the OLED.
+
+  Each sample is reduced once at startup to WAVE_COLUMNS columns of peak
+  level, stored ready to copy into framebuffer pages. After that the display
+  never reads sample data from flash: drawing a waveform is a memcpy and the
+  playhead is one inverted column, so the cost per frame is fixed.
+*/
+
+#ifndef WAVE_OVERVIEW_H
+#define WAVE_OVERVIEW_H
+
+#include <Arduino.h>
+
+#include "sample_engine.h"
+
+#define WAVE_COLUMNS 96
+#define WAVE_PAGES 2  // 16 pixels tall, centred on the zero line
+#define WAVE_BYTES (WAVE_COLUMNS * WAVE_PAGES)
+
+// Scan every sample once. Call at startup, before the overviews are drawn.
+void buildWaveOverviews();
+
+// Page-format overview of the sample a voice plays: WAVE_PAGES rows of
+// WAVE_COLUMNS bytes
+const uint8_t* waveOverview(int voice);
+
+// Overview column under a voice's playhead, or -1 while the voice is idle
+int wavePlayheadColumn(int voice);
+
+#endif  // WAVE_OVERVIEW_H
@@ -0,0 +1,84 @@
+/*
+  XIP cache hit/miss statistics - see xip_stats.h
+*/
+
+#include "xip_stats.h"
+
+#include <hardware/structs/xip_ctrl.h>
+#include <stdio.h>
+
+#include "sample_engine.h"
+
+#define XIP_VOICE_SETS (1 << NUM_VOICES)
+
+struct XipVoiceSetStats {
+  uint32_t blocks;
+  uint32_t accesses;
+  uint32_t hits;
+};
+
+static XipVoiceSetStats xipVoiceSets[XIP_VOICE_SETS];
+
+void xipStatsBlockBegin() {
+  // The counters saturate rather than wrap, so start each block from zero
+  xip_ctrl_hw->ctr_acc = 0;
+  xip_ctrl_hw->ctr_hit = 0;
+}
+
+void xipStatsBlockEnd(uint8_t voiceMask) {
+  uint32_t accesses = xip_ctrl_hw->ctr_acc;
+  uint32_t hits = xip_ctrl_hw->ctr_hit;
+
+  XipVoiceSetStats& stats = xipVoiceSets[voiceMask & (XIP_VOICE_SETS - 1)];
+  stats.blocks++;
+  stats.accesses += accesses;
+  stats.hits += hits;
+}
+
+static void formatVoiceSet(uint8_t mask, char* text, size_t size) {
+  if (!mask) {
+    snprintf(text, size, "none");
+    return;
+  }
+
+  size_t length = 0;
+  text[0] = '\0';
+  for (int i = 0; i < NUM_VOICES && length < size; i++) {
+    if (mask & (1 << i)) {
+      length += snprintf(text + length, size - length, "%s%s",
+                         length ? "+" : "", samplePlayers[i].name);
+    }
+  }
+}
+
+void xipStatsReport(ReportLineFn emit) {
+  char line[112];
+  char voices[40];
+
+  snprintf(line, sizeof(line), "# xip,block_size=%d", AUDIO_BLOCK_SIZE);
+  emit(line);
+  emit("voices,blocks,accesses,hits,hit_pct,accesses_per_sample,"
+       "misses_per_sample");
+
+  for (int mask = 0; mask < XIP_VOICE_SETS; mask++) {
+    XipVoiceSetStats stats = xipVoiceSets[mask];
+    xipVoiceSets[mask] = {0, 0, 0};
+    if (!stats.blocks) continue;
+
+    uint32_t samples = stats.blocks * AUDIO_BLOCK_SIZE;
+    uint32_t misses = stats.accesses - stats.hits;
+    uint32_t hitX10 =
+        stats.accesses ? (uint32_t)((uint64_t)stats.hits * 1000 / stats.accesses) : 0;
+    uint32_t accessX100 = (uint32_t)((uint64_t)stats.accesses * 100 / samples);
+    uint32_t missX100 = (uint32_t)((uint64_t)misses * 100 / samples);
+
+    formatVoiceSet(mask, voices, sizeof(voices));
+    snprintf(line, sizeof(line), "%s,%lu,%lu,%lu,%lu.%lu,%lu.%02lu,%lu.%02lu",
+             voices, (unsigned long)stats.blocks,
+             (unsigned long)stats.accesses, (unsigned long)stats.hits,
+             (unsigned long)(hitX10 / 10), (unsigned long)(hitX10 % 10),
+             (unsigned long)(accessX100 / 100), (unsigned long)(accessX100 % 100),
+             (unsigned long)(missX100 / 100), (unsigned long)(missX100 % 100));
+    emit(line);
+  }
+}
@@ -0,0 +1,29 @@
+/*
+  XIP cache hit/miss statistics for sample playback (RP2040 only).
+
+  The XIP cache counters (CTR_ACC/CTR_HIT) are cleared before each render
+  block and read after it, so each block's flash traffic is attributed to
+  the set of voices that were playing. The counters are shared with code
+  fetches from both cores, but during a block render they are dominated by
+  the renderer and the sample reads it makes.
+
+  Report (serial 'x' command), counts since the previous report:
+    # xip,block_size=<samples>
+    voices,blocks,accesses,hits,hit_pct,accesses_per_sample,misses_per_sample
+  voices lists the playing samples (e.g. "Kick+Hihat", "none").
+*/
+
+#ifndef XIP_STATS_H
+#define XIP_STATS_H
+
+#include <Arduino.h>
+
+#include "report.h"
+
+// Hot path: around every renderBlock() call
+void xipStatsBlockBegin();
+void xipStatsBlockEnd(uint8_t voiceMask);
+
+void xipStatsReport(ReportLineFn emit);
+
+#endif  // XIP_STATS_H
@@ -0,0 +1,55 @@
+#!/usr/bin/env python3
+"""
+Compare two audio benchmark reports (CSV from `program bench` or the `b`
+serial command) and flag kernels that got slower or exceed the audio budget.
+
+Usage: python3 tools/bench_compare.py baseline.csv current.csv [--threshold 10]
+"""
+
+import argparse
+import csv
+import sys
+
+
+def load_report(path):
+    """Return {(kernel, voices): row} from a benchmark CSV, skipping comments"""
+    with open(path) as f:
+        lines = [line for line in f if line.strip() and not line.startswith('#')]
+    return {(row['kernel'], int(row['voices'])): row for row in csv.DictReader(lines)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('baseline')
+    parser.add_argument('current')
+    parser.add_argument('--threshold', type=float, default=10.0,
+                        help='percent slowdown reported as a regression')
+    args = parser.parse_args()
+
+    baseline = load_report(args.baseline)
+    current = load_report(args.current)
+
+    regressions = 0
+    print(f"{'kernel':<8} {'voices':>6} {'base ns':>9} {'now ns':>9} {'change':>8} {'budget':>8}")
+    for key in sorted(current):
+        now = float(current[key]['ns_avg'])
+        budget = float(current[key]['budget_pct'])
+        flags = []
+        if key in baseline:
+            base = float(baseline[key]['ns_avg'])
+            change = (now - base) * 100.0 / base if base else 0.0
+            if change > args.threshold:
+                flags.append('REGRESSION')
+            base_text, change_text = f'{base:9.1f}', f'{change:+7.1f}%'
+        else:
+            base_text, change_text = f"{'-':>9}", f"{'new':>8}"
+        if budget >= 100.0:
+            flags.append('OVER BUDGET')
+        regressions += bool(flags)
+        print(f"{key[0]:<8} {key[1]:>6} {base_text} {now:9.1f} {change_text} {budget:7.2f}% {' '.join(flags)}")
+
+    sys.exit(1 if regressions else 0)
+
+
+if __name__ == '__main__':
+    main()
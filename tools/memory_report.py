@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""
+Static RAM usage report: lists the largest .data/.bss symbols of the firmware
+so memory budgets for buffers (trace rings, delay lines, caches) can be set
+from data.
+
+As a PlatformIO post-build script (see platformio.ini) it runs after every
+firmware link and writes memory_report.txt next to firmware.elf. It can also
+be run by hand:
+
+    python3 tools/memory_report.py .pio/build/pico/firmware.elf [--nm arm-none-eabi-nm]
+"""
+
+import os
+import subprocess
+import sys
+
+RAM_SIZE = 264 * 1024
+TOP_SYMBOLS = 25
+
+
+def read_symbols(nm, elf):
+    """Return [(size, section_type, name)] for sized RAM symbols"""
+    output = subprocess.run([nm, '-S', '-C', '--size-sort', elf],
+                            capture_output=True, text=True, check=True).stdout
+    symbols = []
+    for line in output.splitlines():
+        parts = line.split(None, 3)
+        if len(parts) < 4:
+            continue
+        _, size, kind, name = parts
+        if kind.lower() in ('b', 'd'):  # .bss and .data (incl. static)
+            symbols.append((int(size, 16), kind.lower(), name))
+    return symbols
+
+
+def build_report(symbols):
+    data = sum(size for size, kind, _ in symbols if kind == 'd')
+    bss = sum(size for size, kind, _ in symbols if kind == 'b')
+    lines = [
+        'Static RAM usage',
+        f'  .data {data:7d} bytes',
+        f'  .bss  {bss:7d} bytes',
+        f'  total {data + bss:7d} bytes ({(data + bss) * 100.0 / RAM_SIZE:.1f}% of {RAM_SIZE})',
+        '',
+        f'Largest {TOP_SYMBOLS} static buffers:',
+    ]
+    for size, kind, name in sorted(symbols, reverse=True)[:TOP_SYMBOLS]:
+        section = '.data' if kind == 'd' else '.bss '
+        lines.append(f'  {size:7d}  {section}  {name}')
+    return '\n'.join(lines)
+
+
+def report(nm, elf, output=None):
+    text = build_report(read_symbols(nm, elf))
+    print(text)
+    if output:
+        with open(output, 'w') as f:
+            f.write(text + '\n')
+
+
+def platformio_post_action(source, target, env):
+    elf = target[0].get_abspath()
+    nm = env.subst('$CC').replace('gcc', 'nm')
+    report(nm, elf, os.path.join(os.path.dirname(elf), 'memory_report.txt'))
+
+
+try:
+    Import('env')  # noqa: F821 - provided by PlatformIO/SCons
+    env.AddPostAction('$BUILD_DIR/${PROGNAME}.elf', platformio_post_action)  # noqa: F821
+except NameError:
+    if __name__ == '__main__':
+        args = sys.argv[1:]
+        nm = 'arm-none-eabi-nm'
+        if '--nm' in args:
+            i = args.index('--nm')
+            nm = args[i + 1]
+            del args[i:i + 2]
+        if len(args) != 1:
+            sys.exit(__doc__.strip())
+        report(nm, args[0])
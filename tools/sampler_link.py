@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Drive the module over its framed binary serial protocol (see
+src/serial_protocol.h): query stats, trigger pads, set parameters, and
+stream triggers at kHz rates scheduled on the module's sample clock.
+
+Usage:
+  python3 tools/sampler_link.py PORT stats
+  python3 tools/sampler_link.py PORT trigger PAD [--velocity N] [--delay-ms N]
+  python3 tools/sampler_link.py PORT set PARAM VALUE [--voice N]
+  python3 tools/sampler_link.py PORT roll [--rate HZ] [--seconds N]
+  python3 tools/sampler_link.py --self-test
+
+PAD is 1-4 or kick/snare/hihat/tom. PARAM is tempo, swing, steps, running,
+pitch (playback rate 0.0625-16, e.g. 1.5), decay (per-block factor, e.g.
+0.99), sample (0-3), cv_target (voice mask), level (pad level, 0-1), preset
+(recall slot 0-7), save_preset (slot 0-7), record (1 records triggers into
+the pattern) or record_grid (1, 2 or 4 steps). Needs pyserial.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+SAMPLE_RATE = 16384
+FRAME_MAX = 256  # Payload plus CRC
+
+CMD_TRIGGER = 0x01
+CMD_SET = 0x02
+CMD_STATS = 0x03
+REPLY_STATS = 0x83
+
+PARAMS = {'tempo': 0, 'swing': 1, 'steps': 2, 'running': 3, 'pitch': 4,
+          'decay': 5, 'sample': 6, 'cv_target': 7, 'level': 8, 'preset': 9,
+          'save_preset': 10, 'record': 11, 'record_grid': 12}
+PADS = {'kick': 0, 'snare': 1, 'hihat': 2, 'tom': 3}
+STATS_FIELDS = ('clock', 'frames_ok', 'frames_bad', 'commands',
+                'triggers_dropped', 'load_pct_x10', 'underruns', 'voices')
+
+
+def crc16(data):
+    """CRC-16/CCITT-FALSE, as the firmware computes it"""
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray([0])
+    code_index, run = 0, 1
+    for byte in data:
+        if byte == 0:
+            out[code_index] = run
+            code_index, run = len(out), 1
+            out.append(0)
+            continue
+        out.append(byte)
+        run += 1
+        if run == 0xFF:
+            out[code_index] = run
+            code_index, run = len(out), 1
+            out.append(0)
+    out[code_index] = run
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        if code == 0 or i + code > len(data):
+            raise ValueError('bad COBS block')
+        out += data[i + 1:i + code]
+        i += code
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(payload):
+    """Payload to wire bytes: 0x00, COBS(payload, CRC low byte first), 0x00"""
+    body = payload + struct.pack('<H', crc16(payload))
+    return b'\x00' + cobs_encode(body) + b'\x00'
+
+
+def decode_frame(encoded):
+    """Wire bytes between delimiters to a payload, or None if corrupt"""
+    try:
+        body = cobs_decode(encoded)
+    except ValueError:
+        return None
+    if len(body) < 3 or struct.unpack('<H', body[-2:])[0] != crc16(body[:-2]):
+        return None
+    return body[:-2]
+
+
+def trigger_command(pad, velocity, clock):
+    return struct.pack('<BBBI', CMD_TRIGGER, pad, velocity, clock & 0xFFFFFFFF)
+
+
+def set_command(param, voice, value):
+    return struct.pack('<BBBi', CMD_SET, param, voice, value)
+
+
+class Link:
+    """Serial port with frame batching and a sample clock estimate"""
+
+    def __init__(self, port):
+        import serial  # pyserial
+        self.port = serial.Serial(port, 115200, timeout=0.05)
+        self.pending = b''
+        self.clock_base = None  # (module clock, host time) of the last sync
+
+    def send(self, commands):
+        """Send commands, as few frames as they fit in"""
+        payload = b''
+        for command in commands:
+            if len(payload) + len(command) + 2 > FRAME_MAX:
+                self.port.write(encode_frame(payload))
+                payload = b''
+            payload += command
+        if payload:
+            self.port.write(encode_frame(payload))
+
+    def stats(self, timeout=1.0):
+        """Query stats and resync the clock estimate from the reply"""
+        self.send([bytes([CMD_STATS])])
+        sent = time.monotonic()
+        deadline = sent + timeout
+        while time.monotonic() < deadline:
+            self.pending += self.port.read(256)
+            # Log text can sit between frames; only zero-delimited data counts
+            while self.pending.count(0) >= 2:
+                start = self.pending.index(0)
+                end = self.pending.index(0, start + 1)
+                payload = decode_frame(self.pending[start + 1:end])
+                self.pending = self.pending[end:]
+                if payload and payload[0] == REPLY_STATS and len(payload) == 28:
+                    values = struct.unpack('<IIIIIHIB', payload[1:])
+                    reply = dict(zip(STATS_FIELDS, values))
+                    received = time.monotonic()
+                    self.clock_base = (reply['clock'], (sent + received) / 2)
+                    return reply
+        raise TimeoutError('no stats reply')
+
+    def clock_at(self, host_time):
+        clock, base = self.clock_base
+        return int(clock + (host_time - base) * SAMPLE_RATE) & 0xFFFFFFFF
+
+
+def parse_pad(text):
+    if text.lower() in PADS:
+        return PADS[text.lower()]
+    pad = int(text) - 1
+    if not 0 <= pad < 4:
+        raise argparse.ArgumentTypeError('pad must be 1-4 or a drum name')
+    return pad
+
+
+def roll(link, rate, seconds, lead_ms):
+    """Stream triggers cycling over the pads, each on an exact sample clock"""
+    link.stats()
+    interval = SAMPLE_RATE / rate
+    start = link.clock_at(time.monotonic() + lead_ms / 1000.0)
+    count = int(rate * seconds)
+    sent = 0
+    next_sync = time.monotonic() + 1.0
+    while sent < count:
+        now = time.monotonic()
+        if now >= next_sync:
+            link.stats()  # Follow drift between the two clocks
+            next_sync = now + 1.0
+        horizon = link.clock_at(now + lead_ms / 1000.0)
+        batch = []
+        while sent < count:
+            clock = (start + int(sent * interval)) & 0xFFFFFFFF
+            if ((clock - horizon) & 0xFFFFFFFF) < 0x80000000 and clock != horizon:
+                break  # Still beyond the lead window
+            batch.append(trigger_command(sent % 4, 100, clock))
+            sent += 1
+        link.send(batch)
+        time.sleep(0.002)
+    return link.stats()
+
+
+def self_test():
+    assert crc16(b'123456789') == 0x29B1
+    for payload in (b'\x00', b'\x01' * 300, trigger_command(0, 0, 0),
+                    bytes(range(256)) * 2):
+        frame = encode_frame(payload)
+        assert 0 not in frame[1:-1]
+        assert decode_frame(frame[1:-1]) == payload
+    corrupt = bytearray(encode_frame(trigger_command(1, 100, 5000)))
+    corrupt[3] ^= 0x10
+    assert decode_frame(bytes(corrupt[1:-1])) is None
+    print('self test ok')
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('port', nargs='?')
+    parser.add_argument('--self-test', action='store_true',
+                        help='check the framing code without a module')
+    commands = parser.add_subparsers(dest='command')
+
+    commands.add_parser('stats')
+    trigger = commands.add_parser('trigger')
+    trigger.add_argument('pad', type=parse_pad)
+    trigger.add_argument('--velocity', type=int, default=127)
+    trigger.add_argument('--delay-ms', type=float, default=20.0,
+                         help='play this long after the stats sync')
+    setter = commands.add_parser('set')
+    setter.add_argument('param', choices=sorted(PARAMS))
+    setter.add_argument('value', type=float)
+    setter.add_argument('--voice', type=int, default=0)
+    roller = commands.add_parser('roll')
+    roller.add_argument('--rate', type=float, default=1000.0,
+                        help='triggers per second')
+    roller.add_argument('--seconds', type=float, default=5.0)
+    roller.add_argument('--lead-ms', type=float, default=20.0,
+                        help='schedule ahead; the module queues 32 triggers')
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return
+    if not args.port or not args.command:
+        parser.error('need a serial port and a command')
+
+    link = Link(args.port)
+    if args.command == 'stats':
+        for name, value in link.stats().items():
+            print(f'{name},{value}')
+    elif args.command == 'trigger':
+        link.stats()
+        clock = link.clock_at(time.monotonic() + args.delay_ms / 1000.0)
+        link.send([trigger_command(args.pad, args.velocity, clock)])
+    elif args.command == 'set':
+        value = args.value
+        if args.param in ('pitch', 'decay'):
+            value *= 0x10000  # Q16
+        elif args.param == 'level':
+            value *= 0x8000  # Q15
+        link.send([set_command(PARAMS[args.param], args.voice, round(value))])
+    elif args.command == 'roll':
+        stats = roll(link, args.rate, args.seconds, args.lead_ms)
+        print(f"commands,{stats['commands']}")
+        print(f"triggers_dropped,{stats['triggers_dropped']}")
+        print(f"frames_bad,{stats['frames_bad']}")
+        print(f"load_pct,{stats['load_pct_x10'] / 10:.1f}")
+        print(f"underruns,{stats['underruns']}")
+        sys.exit(1 if stats['triggers_dropped'] or stats['frames_bad'] else 0)
+
+
+if __name__ == '__main__':
+    main()
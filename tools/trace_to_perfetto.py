@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""
+Convert a trace ring dump (serial 't' command, or `program render --trace`)
+into Chrome trace JSON for https://ui.perfetto.dev or chrome://tracing.
+
+Usage: python3 tools/trace_to_perfetto.py capture.txt [-o trace.json]
+
+The capture may contain other serial output; only the trace lines are used.
+"""
+
+import argparse
+import json
+import struct
+import sys
+
+EVENT_SIZE = 8  # struct TraceEvent: uint32 timestamp, uint8 type, uint8 arg, uint16 data
+
+TRACE_TRIGGER = 1
+TRACE_VOICE_START = 2
+TRACE_VOICE_END = 3
+TRACE_BLOCK_START = 4
+TRACE_BLOCK_END = 5
+TRACE_UNDERRUN = 6
+TRACE_EDGE = 7
+TRACE_MIDI_NOTE = 8
+
+VOICE_NAMES = ['Kick', 'Snare', 'Hihat', 'Tom']
+TRIGGER_SOURCES = ['button', 'serial', 'scheduled']
+VOICE_TRACK_BASE = 100  # Voice tracks sit after the core tracks
+
+
+def read_dump(lines):
+    """Return {core: [(timestamp, type, arg, data), ...]} in recording order"""
+    cores = {}
+    for line in lines:
+        line = line.strip()
+        if len(line) < 3 or line[0] != 'T' or not line[1].isdigit() or line[2] != ' ':
+            continue
+        raw = bytes.fromhex(line[3:])
+        events = cores.setdefault(int(line[1]), [])
+        for offset in range(0, len(raw) - EVENT_SIZE + 1, EVENT_SIZE):
+            events.append(struct.unpack_from('<IBBH', raw, offset))
+    return cores
+
+
+def unwrap(events):
+    """Turn 32-bit microsecond timestamps into a monotonic timeline"""
+    base = 0
+    last = None
+    for timestamp, kind, arg, data in events:
+        if last is not None and timestamp < last and last - timestamp > 1 << 31:
+            base += 1 << 32
+        last = timestamp
+        yield base + timestamp, kind, arg, data
+
+
+def voice_name(voice):
+    return VOICE_NAMES[voice] if voice < len(VOICE_NAMES) else f'Voice {voice + 1}'
+
+
+def to_chrome_events(cores):
+    out = []
+    for core in sorted(cores):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': core,
+                    'args': {'name': f'core{core}'}})
+    for voice in range(len(VOICE_NAMES)):
+        out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0,
+                    'tid': VOICE_TRACK_BASE + voice, 'args': {'name': voice_name(voice)}})
+
+    for core, events in sorted(cores.items()):
+        open_voices = set()
+        for ts, kind, arg, data in unwrap(events):
+            if kind == TRACE_BLOCK_START:
+                out.append({'name': 'render block', 'ph': 'B', 'ts': ts, 'pid': 0,
+                            'tid': core, 'args': {'samples': data}})
+            elif kind == TRACE_BLOCK_END:
+                out.append({'name': 'render block', 'ph': 'E', 'ts': ts, 'pid': 0,
+                            'tid': core, 'args': {'voices': data}})
+            elif kind == TRACE_VOICE_START:
+                track = VOICE_TRACK_BASE + arg
+                if arg in open_voices:  # Retrigger cuts the previous hit short
+                    out.append({'name': voice_name(arg), 'ph': 'E', 'ts': ts,
+                                'pid': 0, 'tid': track})
+                open_voices.add(arg)
+                out.append({'name': voice_name(arg), 'ph': 'B', 'ts': ts, 'pid': 0,
+                            'tid': track})
+            elif kind == TRACE_VOICE_END:
+                if arg in open_voices:
+                    open_voices.discard(arg)
+                    out.append({'name': voice_name(arg), 'ph': 'E', 'ts': ts,
+                                'pid': 0, 'tid': VOICE_TRACK_BASE + arg})
+            elif kind == TRACE_TRIGGER:
+                source = TRIGGER_SOURCES[data] if data < len(TRIGGER_SOURCES) else str(data)
+                out.append({'name': f'trigger {voice_name(arg)}', 'ph': 'i', 's': 't',
+                            'ts': ts, 'pid': 0, 'tid': core, 'args': {'source': source}})
+            elif kind == TRACE_EDGE:
+                out.append({'name': f'edge {voice_name(arg)}', 'ph': 'i', 's': 't',
+                            'ts': ts, 'pid': 0, 'tid': core})
+            elif kind == TRACE_MIDI_NOTE:
+                out.append({'name': f'midi {voice_name(arg)}', 'ph': 'i', 's': 't',
+                            'ts': ts, 'pid': 0, 'tid': core, 'args': {'velocity': data}})
+            elif kind == TRACE_UNDERRUN:
+                out.append({'name': 'underrun', 'ph': 'i', 's': 'g', 'ts': ts,
+                            'pid': 0, 'tid': core})
+    return out
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument('capture', help="trace dump ('-' for stdin)")
+    parser.add_argument('-o', '--output', default='trace.json')
+    args = parser.parse_args()
+
+    source = sys.stdin if args.capture == '-' else open(args.capture, errors='replace')
+    with source:
+        cores = read_dump(source)
+
+    if not cores:
+        sys.exit('No trace lines found')
+
+    events = to_chrome_events(cores)
+    with open(args.output, 'w') as f:
+        json.dump({'traceEvents': events, 'displayTimeUnit': 'ms'}, f)
+    print(f"Wrote {sum(len(e) for e in cores.values())} events from "
+          f"{len(cores)} core(s) to {args.output}")
+
+
+if __name__ == '__main__':
+    main()